@@ -9,8 +9,25 @@ LIBPE_NAMESPACE_BEGIN
 
 void LIBPE_API SetPELoaderIOBlockSize(UINT64 nMinBlockSize, UINT64 nMaxBlockSize);
 
+// The memory limit of the disk file loader. The buffers held by the living elements are counted too, and the other cached
+// blocks are evicted to stay under it. A range larger than the limit can't be got as raw memory, read it instead.
+void LIBPE_API SetPELoaderCacheSize(UINT64 nMaxCacheSize);
+
+// Read the data directories in a background thread as soon as the headers are parsed. Off by default.
+void LIBPE_API SetPELoaderAsyncReadAhead(BOOL bEnable);
+
+// Export tables look functions up by name with binary search, and build a hash index of their names after this
+// many lookups. 0 means the default, which is 8. Pass 1 to always use the hash index.
+void LIBPE_API SetPEExportNameIndexThreshold(UINT32 nLookupCount);
+
 HRESULT LIBPE_API ParsePEFromDiskFile(const file_char_t *pFilePath, IPEFile **ppFile);
-HRESULT LIBPE_API ParsePEFromMappedFile(void *pMemory, IPEFile **ppFile);
+HRESULT LIBPE_API ParsePEFromMappedDiskFile(const file_char_t *pFilePath, IPEFile **ppFile);
+
+// The memory is used in place and is still owned by the caller. It must outlive the returned file.
+HRESULT LIBPE_API ParsePEFromMappedFile(void *pMemory, UINT64 nSize, IPEFile **ppFile);
+
+// Same as ParsePEFromMappedFile, but the memory is in the loaded image layout, such as a module dumped from a process.
+HRESULT LIBPE_API ParsePEFromImageBuffer(void *pMemory, UINT64 nSize, IPEFile **ppFile);
 
 #ifdef LIBPE_WINOS
 HRESULT LIBPE_API ParsePEFromMappedResource(HMODULE hModule, IPEFile **ppFile);
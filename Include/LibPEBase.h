@@ -32,8 +32,8 @@ typedef short               INT16;
 typedef unsigned short      UINT16;
 typedef int                 INT32;
 typedef unsigned            UINT32;
-typedef __int64             INT64;
-typedef unsigned __int64    UINT64;
+typedef long long           INT64;
+typedef unsigned long long  UINT64;
 typedef char                file_char_t;
 typedef std::string         file_t;
 #endif
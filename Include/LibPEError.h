@@ -11,7 +11,7 @@ LIBPE_NAMESPACE_BEGIN
 
 #else
 
-typedef UINT32              HRESULT;
+typedef INT32               HRESULT;
 
 #define SUCCEEDED(hr)       (((HRESULT)(hr)) >= 0)
 #define FAILED(hr)          (((HRESULT)(hr)) < 0)
@@ -51,6 +51,8 @@ class IPEResourceDirectory;
 class IPEResourceDirectoryEntry;
 class IPEResourceDataEntry;
 class IPEResource;
+class IPEResourceDataSink;
+class IPEVersionInfo;
 class IPEExceptionTable;
 class IPECertificateTable;
 class IPERelocationTable;
@@ -60,12 +62,102 @@ class IPEDebugInfoTable;
 class IPEGlobalRegister;
 class IPETlsTable;
 class IPEBoundImportTable;
+class IPEBoundImportModule;
 class IPEImportAddressTable;
 class IPEImportAddressBlock;
 class IPEImportAddressItem;
 class IPEDelayImportTable;
+class IPEDelayImportModule;
 class IPECLRHeader;
 
+// A decoded base relocation item. nType is one of the IMAGE_REL_BASED_XXX values.
+struct PERelocationEntry {
+    UINT16      nType;
+    PEAddress   nRVA;
+};
+
+// The hashes which IPEImportTable::ComputeImportHash can compute from the normalized "module.function" import entries.
+// PE_IMPORT_HASH_MD5 is the imphash, which is 16 bytes. PE_IMPORT_HASH_FNV64 is 8 bytes. It adds up the 64-bit FNV-1a hashes
+// of the entries, so it is much cheaper and does not depend on the order of the imports.
+enum PEImportHashType {
+    PE_IMPORT_HASH_MD5      = 0,
+    PE_IMPORT_HASH_FNV64    = 1,
+};
+
+// The flat form of a whole import table, see IPEImportTable::Materialize. The names are copied into the string pool and
+// referred to by their offsets in it, so the arrays hold no pointers and can be written out as they are.
+enum {
+    PE_IMPORT_NO_NAME       = 0xFFFFFFFF,
+};
+
+struct PEImportModuleEntry {
+    UINT32      nNameOffset;
+    UINT32      nImportDescRVA;
+    UINT32      nFirstFunctionIndex;
+    UINT32      nFunctionCount;
+};
+
+// The functions imported by ordinal have no name, and their ordinal is in nOrdinal. nThunkRVA is the RVA of the IAT slot.
+struct PEImportFunctionEntry {
+    UINT32      nNameOffset;
+    UINT32      nThunkRVA;
+    UINT16      nHint;
+    UINT16      nOrdinal;
+};
+
+// The kinds of imports IPEFile::GetModuleImportKinds can report.
+enum PEImportKind {
+    PE_IMPORT_KIND_NORMAL   = 0x01,
+    PE_IMPORT_KIND_DELAY    = 0x02,
+    PE_IMPORT_KIND_BOUND    = 0x04,
+};
+
+struct PEMaterializedImportTable {
+    const PEImportModuleEntry   *pModules;
+    UINT32                      nModuleCount;
+    const PEImportFunctionEntry *pFunctions;
+    UINT32                      nFunctionCount;
+    const char                  *pStringPool;
+    UINT32                      nStringPoolSize;
+};
+
+// The import an IAT slot belongs to, see IPEImportTable::ResolveIATSlot. The indexes are the ones GetModuleByIndex and
+// IPEImportModule::GetFunctionByIndex take, and both are PE_IMPORT_NO_INDEX for an RVA which is in no IAT block.
+enum {
+    PE_IMPORT_NO_INDEX      = 0xFFFFFFFF,
+};
+
+struct PEImportSlot {
+    UINT32      nModuleIndex;
+    UINT32      nFunctionIndex;
+};
+
+// One leaf of the resource tree, see IPEResourceTable::GetResourceRecords. The type and the name are ids, or the offsets
+// of their IMAGE_RESOURCE_DIR_STRING_U in the resource table with PE_RESOURCE_NAME_IS_STRING set, the same as the Name
+// field of IMAGE_RESOURCE_DIRECTORY_ENTRY.
+enum {
+    PE_RESOURCE_NAME_IS_STRING  = 0x80000000,
+    PE_RESOURCE_ANY_LANGUAGE    = 0xFFFFFFFF,
+};
+
+struct PEResourceRecord {
+    UINT32      nType;
+    UINT32      nName;
+    UINT32      nLanguage;
+    UINT32      nDataEntryOffset;       // Offset of the IMAGE_RESOURCE_DATA_ENTRY in the resource table.
+    UINT32      nDataRVA;
+    UINT32      nDataSize;
+    UINT32      nCodePage;
+};
+
+// A UTF-16 string in the buffer of the loader, which is not null-terminated. It lives as long as the element it is from.
+// The length is in UTF-16 units, and pString can only be used as a wchar_t string where wchar_t is 2 bytes, the same as
+// IMAGE_RESOURCE_DIR_STRING_U. IPEVersionInfo::ConvertToUTF8 converts it everywhere.
+struct PEStringView {
+    const wchar_t   *pString;
+    UINT32          nLength;
+};
+
 #define LIBPE_DEFINE_FIELD_ACCESSOR(FieldType, FuncName)                                    \
     virtual FieldType LIBPE_CALLTYPE GetField ## FuncName() = 0
 
@@ -145,11 +237,21 @@ public:
     virtual HRESULT LIBPE_CALLTYPE RemoveDelayImportTable() = 0;
     virtual HRESULT LIBPE_CALLTYPE RemoveCLRHeader() = 0;
 
+    // Import resolution across the import, delay import and bound import tables, which all index the module names
+    // the same way. GetModuleImportKinds returns the PE_IMPORT_KIND_XXX flags of the tables which import the module.
+    virtual UINT32 LIBPE_CALLTYPE GetModuleImportKinds(const char *pModuleName) = 0;
+    virtual HRESULT LIBPE_CALLTYPE FindImportedFunction(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppFunction) = 0;
+
     // PE Verification
     virtual BOOL LIBPE_CALLTYPE ValidatePEHeader() = 0;
 
     // Rebuild
     virtual HRESULT LIBPE_CALLTYPE Rebuild(const file_char_t *pFilePath) = 0;
+
+    // Rebase
+    // Lay out the image in pImageBuffer as it would be loaded, then apply the base relocations for nNewImageBase.
+    // pImageBuffer must be able to hold GetImageSize() bytes, and it must not overlap the buffer the file is parsed from.
+    virtual HRESULT LIBPE_CALLTYPE Rebase(PEAddress nNewImageBase, void *pImageBuffer, UINT64 nImageBufferSize) = 0;
 };
 
 class IPEElement : public ILibPEInterface
@@ -298,6 +400,9 @@ public:
     virtual UINT32 LIBPE_CALLTYPE GetFunctionCount() = 0;
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByIndex(UINT32 nIndex, IPEExportFunction **ppFunction) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pFunctionName, IPEExportFunction **ppFunction) = 0;
+
+    // The ordinal is the biased one, which is Base plus the index of the function.
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByOrdinal(UINT32 nOrdinal, IPEExportFunction **ppFunction) = 0;
 };
 
 class IPEExportFunction: public IPEElement
@@ -305,6 +410,11 @@ class IPEExportFunction: public IPEElement
 public:
     virtual const char * LIBPE_CALLTYPE GetName() = 0;
     virtual UINT16 LIBPE_CALLTYPE GetHint() = 0;
+    virtual UINT32 LIBPE_CALLTYPE GetOrdinal() = 0;
+
+    // A forwarded function is implemented in another module, GetForwarder returns where, such as "NTDLL.RtlAllocateHeap".
+    virtual BOOL LIBPE_CALLTYPE IsForwarded() = 0;
+    virtual const char * LIBPE_CALLTYPE GetForwarder() = 0;
 };
 
 class IPEImportTable : public IPEElement
@@ -314,6 +424,19 @@ public:
     virtual HRESULT LIBPE_CALLTYPE GetModuleByIndex(UINT32 nIndex, IPEImportModule **ppImportModule) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetModuleByName(const char *pModuleName, IPEImportModule **ppImportModule) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppImportFunction) = 0;
+
+    // The raw descriptors and thunks are hashed directly, so no module or function object is created. The functions of
+    // a bound module without its lookup table can't be named, because its thunks hold addresses, so they are left out.
+    virtual HRESULT LIBPE_CALLTYPE ComputeImportHash(PEImportHashType nHashType, UINT8 *pHashBuffer, UINT32 nHashBufferSize) = 0;
+
+    // Decode all the modules and functions at once. The arrays are owned by the table and are built on the first call only.
+    // The functions of a bound module without its lookup table have neither a name nor an ordinal, only their IAT slots.
+    virtual HRESULT LIBPE_CALLTYPE Materialize(PEMaterializedImportTable *pMaterializedTable) = 0;
+
+    // Find the imports the IAT slots belong to. The IAT blocks of all the modules are indexed by RVA on the first call,
+    // so each lookup is a binary search. ResolveIATSlots returns the number of RVAs resolved.
+    virtual HRESULT LIBPE_CALLTYPE ResolveIATSlot(PEAddress nSlotRVA, PEImportSlot *pSlot) = 0;
+    virtual UINT32 LIBPE_CALLTYPE ResolveIATSlots(const PEAddress *pSlotRVAs, UINT32 nSlotCount, PEImportSlot *pSlots) = 0;
 };
 
 class IPEImportModule: public IPEElement
@@ -329,6 +452,8 @@ public:
     virtual BOOL LIBPE_CALLTYPE IsBound() = 0;
     virtual const char * LIBPE_CALLTYPE GetName() = 0;
     virtual UINT32 LIBPE_CALLTYPE GetFunctionCount() = 0;
+
+    // The thunks of a bound module without its lookup table hold addresses, so its functions can't be got as objects.
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByIndex(UINT32 nFunctionId, IPEImportFunction **ppFunction) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pFunctionName, IPEImportFunction **ppFunction) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetRelatedImportAddressBlock(IPEImportAddressBlock **ppBlock) = 0;
@@ -340,6 +465,9 @@ public:
     //virtual LibPERawThunkData(T) * LIBPE_CALLTYPE GetRawThunkData() = 0;
     LIBPE_DEFINE_FIELD_ACCESSOR(UINT16, Hint);
 
+    // The functions imported by ordinal have no IMAGE_IMPORT_BY_NAME, so GetName returns NULL and the hint is 0 for them.
+    virtual BOOL LIBPE_CALLTYPE IsByOrdinal() = 0;
+    virtual UINT16 LIBPE_CALLTYPE GetOrdinal() = 0;
     virtual const char * LIBPE_CALLTYPE GetName() = 0;
     virtual PEAddress LIBPE_CALLTYPE GetEntry() = 0;
 };
@@ -348,6 +476,23 @@ class IPEResourceTable : public IPEElement
 {
 public:
     virtual HRESULT LIBPE_CALLTYPE GetRootDirectory(IPEResourceDirectory **ppDirectory) = 0;
+
+    // Flatten the whole tree into records sorted by type, name and language, ids before strings. The records are owned
+    // by the table and are built on the first call only, without creating any directory or entry object.
+    virtual HRESULT LIBPE_CALLTYPE GetResourceRecords(const PEResourceRecord **ppRecords, UINT32 *pRecordCount) = 0;
+
+    // The type and the name are passed the same way as to ::FindResourceEx, so ids are passed with MAKEINTRESOURCEW.
+    // With PE_RESOURCE_ANY_LANGUAGE, the record with the lowest language is returned.
+    virtual HRESULT LIBPE_CALLTYPE FindResourceRecord(const wchar_t *pType, const wchar_t *pName, UINT32 nLanguage, const PEResourceRecord **ppRecord) = 0;
+
+    // Get the string of a type or name with PE_RESOURCE_NAME_IS_STRING set. The string is not null-terminated.
+    virtual const wchar_t * LIBPE_CALLTYPE GetResourceRecordName(UINT32 nNameKey, UINT32 *pNameLength) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetResourceByRecord(const PEResourceRecord *pRecord, IPEResource **ppResource) = 0;
+
+    // Get the first RT_MANIFEST or RT_GROUP_ICON resource, in its first language. Only the directories on the way to it
+    // are read, so these are much cheaper than walking the tree or building the records.
+    virtual HRESULT LIBPE_CALLTYPE GetManifest(IPEResource **ppResource) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetIconGroup(IPEResource **ppResource) = 0;
 };
 
 class IPEResourceDirectory : public IPEElement
@@ -402,6 +547,49 @@ public:
 class IPEResource : public IPEElement
 {
 public:
+    // Decode the resource as a VS_VERSIONINFO. It fails if the resource is not one.
+    virtual HRESULT LIBPE_CALLTYPE GetVersionInfo(IPEVersionInfo **ppVersionInfo) = 0;
+
+    // Copy the bytes from nOffset in the resource into the buffer. The read stops at the end of the resource, and the
+    // size copied is returned in pReadSize. Nothing is kept by the parser, so the resource needn't fit in memory.
+    virtual HRESULT LIBPE_CALLTYPE Read(UINT32 nOffset, void *pBuffer, UINT32 nSize, UINT32 *pReadSize) = 0;
+
+    // Pass the whole resource to the sink in order, through a single window of nWindowSize bytes (64KB if 0).
+    // It stops at the first failure returned by the sink, and returns that failure.
+    virtual HRESULT LIBPE_CALLTYPE ReadInChunks(IPEResourceDataSink *pSink, UINT32 nWindowSize) = 0;
+};
+
+// Implemented by the caller of IPEResource::ReadInChunks, e.g. to hash or carve the resource. The chunk is only valid
+// during the call.
+class IPEResourceDataSink
+{
+public:
+    virtual HRESULT LIBPE_CALLTYPE OnData(UINT32 nOffset, const void *pChunk, UINT32 nChunkSize) = 0;
+};
+
+// The strings of a version resource are views into the resource itself. Nothing out of the resource is read.
+class IPEVersionInfo : public IPEElement
+{
+public:
+    // NULL when the resource has no VS_FIXEDFILEINFO.
+    virtual PERawFixedFileInfo * LIBPE_CALLTYPE GetFixedFileInfo() = 0;
+
+    // The StringTable blocks in StringFileInfo, whose keys are the language and code page in hex, such as "040904b0".
+    virtual UINT32 LIBPE_CALLTYPE GetStringTableCount() = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetStringTableKey(UINT32 nTableIndex, PEStringView *pKey) = 0;
+    virtual UINT32 LIBPE_CALLTYPE GetStringCount(UINT32 nTableIndex) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetStringByIndex(UINT32 nTableIndex, UINT32 nStringIndex, PEStringView *pKey, PEStringView *pValue) = 0;
+
+    // Find a string, such as "CompanyName", in the first string table which has it. The key is case-insensitive.
+    virtual HRESULT LIBPE_CALLTYPE GetString(const wchar_t *pKey, PEStringView *pValue) = 0;
+
+    // The language and code page pairs of the Translation value in VarFileInfo.
+    virtual UINT32 LIBPE_CALLTYPE GetTranslationCount() = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetTranslation(UINT32 nIndex, UINT16 *pLanguage, UINT16 *pCodePage) = 0;
+
+    // Convert a string into null-terminated UTF-8. The size needed, with the terminator, is always returned in pSize,
+    // and E_INVALIDARG is returned if the buffer is smaller than that, so the buffer can be NULL to get the size only.
+    virtual HRESULT LIBPE_CALLTYPE ConvertToUTF8(const PEStringView *pString, char *pBuffer, UINT32 nBufferSize, UINT32 *pSize) = 0;
 };
 
 class IPEExceptionTable : public IPEElement {};
@@ -413,8 +601,19 @@ class IPERelocationTable : public IPEElement
 public:
     virtual UINT32 LIBPE_CALLTYPE GetPageCount() = 0;
     virtual HRESULT LIBPE_CALLTYPE GetPageByIndex(UINT32 nIndex, IPERelocationPage **ppRelocationPage) = 0;
+
+    // Items can be enumerated in batches without creating any item object.
+    // GetItems returns the number of entries filled, 0 means there is no more item. The item after a HIGHADJ one holds
+    // its parameter rather than a relocation, so it is filled as IMAGE_REL_BASED_ABSOLUTE.
+    virtual UINT32 LIBPE_CALLTYPE GetItemCount() = 0;
+    virtual UINT32 LIBPE_CALLTYPE GetItems(UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount) = 0;
+
     virtual BOOL LIBPE_CALLTYPE IsRVANeedRelocation(PEAddress nRVA) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetItemByRVA(PEAddress nRVA, IPERelocationItem **ppRelocationItem) = 0;
+
+    // Fill the relocations in [nBeginRVA, nEndRVA) sorted by RVA, IMAGE_REL_BASED_ABSOLUTE paddings are not included.
+    // If pEntries is NULL, the number of relocations in the range is returned.
+    virtual UINT32 LIBPE_CALLTYPE GetRelocationsInRange(PEAddress nBeginRVA, PEAddress nEndRVA, PERelocationEntry *pEntries, UINT32 nMaxCount) = 0;
 };
 
 class IPERelocationPage : public IPEElement
@@ -426,6 +625,7 @@ public:
     virtual PEAddress LIBPE_CALLTYPE GetPageRVA() = 0;
     virtual UINT32 LIBPE_CALLTYPE GetItemCount() = 0;
     virtual HRESULT LIBPE_CALLTYPE GetItemByIndex(UINT32 nIndex, IPERelocationItem **ppRelocationItem) = 0;
+    virtual UINT32 LIBPE_CALLTYPE GetItems(UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount) = 0;
     virtual BOOL LIBPE_CALLTYPE IsRVANeedRelocation(PEAddress nRVA) = 0;
     virtual HRESULT LIBPE_CALLTYPE GetItemByRVA(PEAddress nRVA, IPERelocationItem **ppRelocationItem) = 0;
 };
@@ -444,7 +644,28 @@ class IPEGlobalRegister : public IPEElement {};
 
 class IPETlsTable : public IPEElement {};
 
-class IPEBoundImportTable : public IPEElement {};
+class IPEBoundImportTable : public IPEElement
+{
+public:
+    virtual UINT32 LIBPE_CALLTYPE GetModuleCount() = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByIndex(UINT32 nIndex, IPEBoundImportModule **ppModule) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByName(const char *pModuleName, IPEBoundImportModule **ppModule) = 0;
+};
+
+class IPEBoundImportModule : public IPEElement
+{
+public:
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, TimeDateStamp);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT16, OffsetModuleName);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT16, NumberOfModuleForwarderRefs);
+
+    virtual const char * LIBPE_CALLTYPE GetName() = 0;
+
+    // The forwarder refs are the modules which this module forwards some of its exports to, bound along with it.
+    virtual UINT32 LIBPE_CALLTYPE GetForwarderRefCount() = 0;
+    virtual const char * LIBPE_CALLTYPE GetForwarderRefName(UINT32 nIndex) = 0;
+    virtual UINT32 LIBPE_CALLTYPE GetForwarderRefTimeDateStamp(UINT32 nIndex) = 0;
+};
 
 class IPEImportAddressTable : public IPEElement
 {
@@ -472,7 +693,34 @@ public:
     LIBPE_DEFINE_FIELD_ACCESSOR(PEAddress, AddressOfData);
 };
 
-class IPEDelayImportTable : public IPEElement {};
+class IPEDelayImportTable : public IPEElement
+{
+public:
+    virtual UINT32 LIBPE_CALLTYPE GetModuleCount() = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByIndex(UINT32 nIndex, IPEDelayImportModule **ppModule) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByName(const char *pModuleName, IPEDelayImportModule **ppModule) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppFunction) = 0;
+};
+
+class IPEDelayImportModule : public IPEElement
+{
+public:
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, Attributes);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, DllNameRVA);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, ModuleHandleRVA);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, ImportAddressTableRVA);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, ImportNameTableRVA);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, BoundImportAddressTableRVA);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, UnloadInformationTableRVA);
+    LIBPE_DEFINE_FIELD_ACCESSOR(UINT32, TimeDateStamp);
+
+    // The descriptors of the old linkers hold VAs instead of RVAs. Their functions are not decoded.
+    virtual BOOL LIBPE_CALLTYPE IsRVABased() = 0;
+    virtual const char * LIBPE_CALLTYPE GetName() = 0;
+    virtual UINT32 LIBPE_CALLTYPE GetFunctionCount() = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByIndex(UINT32 nIndex, IPEImportFunction **ppFunction) = 0;
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pFunctionName, IPEImportFunction **ppFunction) = 0;
+};
 
 class IPECLRHeader : public IPEElement {};
 
@@ -1,12 +1,30 @@
 #pragma once
 
 #include "LibPEBase.h"
+#include "LibPEWinNT.h"
 
 LIBPE_NAMESPACE_BEGIN
 
 struct PE32 {};
 struct PE64 {};
 
+// IMAGE_DELAYLOAD_DESCRIPTOR is only in the newer SDKs, so we keep its layout here.
+struct PEDelayLoadDescriptor {
+    UINT32  Attributes;
+    UINT32  DllNameRVA;
+    UINT32  ModuleHandleRVA;
+    UINT32  ImportAddressTableRVA;
+    UINT32  ImportNameTableRVA;
+    UINT32  BoundImportAddressTableRVA;
+    UINT32  UnloadInformationTableRVA;
+    UINT32  TimeDateStamp;
+};
+
+// The descriptors written by the old linkers don't have it set, and hold VAs instead of RVAs.
+enum {
+    PE_DELAY_IMPORT_ATTRIBUTE_RVA_BASED = 0x01,
+};
+
 struct PETraitBase {
     typedef IMAGE_DOS_HEADER                    RawDosHeader;
     typedef IMAGE_FILE_HEADER                   RawFileHeader;
@@ -15,12 +33,16 @@ struct PETraitBase {
     typedef IMAGE_EXPORT_DIRECTORY              RawExportDirectory;
     typedef IMAGE_IMPORT_DESCRIPTOR             RawImportDescriptor;
     typedef IMAGE_IMPORT_BY_NAME                RawImportByName;
+    typedef IMAGE_BOUND_IMPORT_DESCRIPTOR       RawBoundImportDescriptor;
+    typedef IMAGE_BOUND_FORWARDER_REF           RawBoundForwarderRef;
+    typedef PEDelayLoadDescriptor               RawDelayImportDescriptor;
     typedef IMAGE_BASE_RELOCATION               RawBaseRelocation;
     typedef IMAGE_RESOURCE_DIRECTORY            RawResourceDirectory;
     typedef IMAGE_RESOURCE_DIRECTORY_ENTRY      RawResourceDirectoryEntry;
     typedef IMAGE_RESOURCE_DATA_ENTRY           RawResourceDataEntry;
     typedef IMAGE_RESOURCE_DIRECTORY_STRING     RawResourceString;
     typedef IMAGE_RESOURCE_DIR_STRING_U         RawResourceStringU;
+    typedef VS_FIXEDFILEINFO                    RawFixedFileInfo;
 };
 
 template <class T> struct PETrait {};
@@ -28,6 +50,7 @@ template <class T> struct PETrait {};
 template <>
 struct PETrait<PE32> : PETraitBase {
     static const BOOL                           Is32Bit = true;
+    static const UINT64                         OrdinalFlag = IMAGE_ORDINAL_FLAG32;
     typedef UINT32                              RawAddress;
     typedef IMAGE_NT_HEADERS32                  RawNtHeaders;
     typedef IMAGE_OPTIONAL_HEADER32             RawOptionalHeader;
@@ -37,6 +60,7 @@ struct PETrait<PE32> : PETraitBase {
 template <>
 struct PETrait<PE64> : PETraitBase {
     static const BOOL                           Is32Bit = false;
+    static const UINT64                         OrdinalFlag = IMAGE_ORDINAL_FLAG64;
     typedef UINT64                              RawAddress;
     typedef IMAGE_NT_HEADERS64                  RawNtHeaders;
     typedef IMAGE_OPTIONAL_HEADER64             RawOptionalHeader;
@@ -54,12 +78,16 @@ struct PETrait<PE64> : PETraitBase {
 #define LibPERawImportDescriptor(T)             typename PETrait<T>::RawImportDescriptor
 #define LibPERawThunkData(T)                    typename PETrait<T>::RawThunkData
 #define LibPERawImportByName(T)                 typename PETrait<T>::RawImportByName
+#define LibPERawBoundImportDescriptor(T)        typename PETrait<T>::RawBoundImportDescriptor
+#define LibPERawBoundForwarderRef(T)            typename PETrait<T>::RawBoundForwarderRef
+#define LibPERawDelayImportDescriptor(T)        typename PETrait<T>::RawDelayImportDescriptor
 #define LibPERawBaseRelocation(T)               typename PETrait<T>::RawBaseRelocation
 #define LibPERawResourceDirectory(T)            typename PETrait<T>::RawResourceDirectory
 #define LibPERawResourceDirectoryEntry(T)       typename PETrait<T>::RawResourceDirectoryEntry
 #define LibPERawResourceDataEntry(T)            typename PETrait<T>::RawResourceDataEntry
 #define LibPERawResourceString(T)               typename PETrait<T>::RawResourceString
 #define LibPERawResourceStringU(T)              typename PETrait<T>::RawResourceStringU
+#define LibPERawFixedFileInfo(T)                typename PETrait<T>::RawFixedFileInfo
 
 typedef UINT64                                  PEAddress;
 
@@ -70,12 +98,16 @@ typedef PETraitBase::RawSectionHeader           PERawSectionHeader;
 typedef PETraitBase::RawExportDirectory         PERawExportDirectory;
 typedef PETraitBase::RawImportDescriptor        PERawImportDescriptor;
 typedef PETraitBase::RawImportByName            PERawImportByName;
+typedef PETraitBase::RawBoundImportDescriptor   PERawBoundImportDescriptor;
+typedef PETraitBase::RawBoundForwarderRef       PERawBoundForwarderRef;
+typedef PETraitBase::RawDelayImportDescriptor   PERawDelayImportDescriptor;
 typedef PETraitBase::RawBaseRelocation          PERawBaseRelocation;
 typedef PETraitBase::RawResourceDirectory       PERawResourceDirectory;
 typedef PETraitBase::RawResourceDirectoryEntry  PERawResourceDirectoryEntry;
 typedef PETraitBase::RawResourceDataEntry       PERawResourceDataEntry;
 typedef PETraitBase::RawResourceString          PERawResourceString;
 typedef PETraitBase::RawResourceStringU         PERawResourceStringU;
+typedef PETraitBase::RawFixedFileInfo           PERawFixedFileInfo;
 
 typedef PETrait<PE32>::RawNtHeaders             PERawNtHeaders32;
 typedef PETrait<PE32>::RawOptionalHeader        PERawOptionalHeader32;
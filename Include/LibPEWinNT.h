@@ -0,0 +1,316 @@
+#pragma once
+
+#include "LibPEBase.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+// The PE structures and constants come from WinNT.h on Windows. Elsewhere we keep the parts of it that we use here,
+// with the same names and the same layout.
+#ifndef LIBPE_WINOS
+
+#define IMAGE_DOS_SIGNATURE                     0x5A4D
+#define IMAGE_NT_SIGNATURE                      0x00004550
+
+#define IMAGE_NUMBEROF_DIRECTORY_ENTRIES        16
+#define IMAGE_SIZEOF_SHORT_NAME                 8
+
+#define IMAGE_DIRECTORY_ENTRY_EXPORT            0
+#define IMAGE_DIRECTORY_ENTRY_IMPORT            1
+#define IMAGE_DIRECTORY_ENTRY_RESOURCE          2
+#define IMAGE_DIRECTORY_ENTRY_EXCEPTION         3
+#define IMAGE_DIRECTORY_ENTRY_SECURITY          4
+#define IMAGE_DIRECTORY_ENTRY_BASERELOC         5
+#define IMAGE_DIRECTORY_ENTRY_DEBUG             6
+#define IMAGE_DIRECTORY_ENTRY_ARCHITECTURE      7
+#define IMAGE_DIRECTORY_ENTRY_GLOBALPTR         8
+#define IMAGE_DIRECTORY_ENTRY_TLS               9
+#define IMAGE_DIRECTORY_ENTRY_LOAD_CONFIG       10
+#define IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT      11
+#define IMAGE_DIRECTORY_ENTRY_IAT               12
+#define IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT      13
+#define IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR    14
+
+#define IMAGE_ORDINAL_FLAG32                    0x80000000
+#define IMAGE_ORDINAL_FLAG64                    0x8000000000000000ULL
+
+#define IMAGE_REL_BASED_ABSOLUTE                0
+#define IMAGE_REL_BASED_HIGH                    1
+#define IMAGE_REL_BASED_LOW                     2
+#define IMAGE_REL_BASED_HIGHLOW                 3
+#define IMAGE_REL_BASED_HIGHADJ                 4
+#define IMAGE_REL_BASED_DIR64                   10
+
+#define IMAGE_RESOURCE_NAME_IS_STRING           0x80000000
+#define IMAGE_RESOURCE_DATA_IS_DIRECTORY        0x80000000
+
+#define VS_FFI_SIGNATURE                        0xFEEF04BDL
+
+#pragma pack(push, 4)
+
+struct IMAGE_DOS_HEADER {
+    UINT16  e_magic;
+    UINT16  e_cblp;
+    UINT16  e_cp;
+    UINT16  e_crlc;
+    UINT16  e_cparhdr;
+    UINT16  e_minalloc;
+    UINT16  e_maxalloc;
+    UINT16  e_ss;
+    UINT16  e_sp;
+    UINT16  e_csum;
+    UINT16  e_ip;
+    UINT16  e_cs;
+    UINT16  e_lfarlc;
+    UINT16  e_ovno;
+    UINT16  e_res[4];
+    UINT16  e_oemid;
+    UINT16  e_oeminfo;
+    UINT16  e_res2[10];
+    INT32   e_lfanew;
+};
+
+struct IMAGE_FILE_HEADER {
+    UINT16  Machine;
+    UINT16  NumberOfSections;
+    UINT32  TimeDateStamp;
+    UINT32  PointerToSymbolTable;
+    UINT32  NumberOfSymbols;
+    UINT16  SizeOfOptionalHeader;
+    UINT16  Characteristics;
+};
+
+struct IMAGE_DATA_DIRECTORY {
+    UINT32  VirtualAddress;
+    UINT32  Size;
+};
+
+struct IMAGE_OPTIONAL_HEADER32 {
+    UINT16  Magic;
+    UINT8   MajorLinkerVersion;
+    UINT8   MinorLinkerVersion;
+    UINT32  SizeOfCode;
+    UINT32  SizeOfInitializedData;
+    UINT32  SizeOfUninitializedData;
+    UINT32  AddressOfEntryPoint;
+    UINT32  BaseOfCode;
+    UINT32  BaseOfData;
+    UINT32  ImageBase;
+    UINT32  SectionAlignment;
+    UINT32  FileAlignment;
+    UINT16  MajorOperatingSystemVersion;
+    UINT16  MinorOperatingSystemVersion;
+    UINT16  MajorImageVersion;
+    UINT16  MinorImageVersion;
+    UINT16  MajorSubsystemVersion;
+    UINT16  MinorSubsystemVersion;
+    UINT32  Win32VersionValue;
+    UINT32  SizeOfImage;
+    UINT32  SizeOfHeaders;
+    UINT32  CheckSum;
+    UINT16  Subsystem;
+    UINT16  DllCharacteristics;
+    UINT32  SizeOfStackReserve;
+    UINT32  SizeOfStackCommit;
+    UINT32  SizeOfHeapReserve;
+    UINT32  SizeOfHeapCommit;
+    UINT32  LoaderFlags;
+    UINT32  NumberOfRvaAndSizes;
+    IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+};
+
+struct IMAGE_OPTIONAL_HEADER64 {
+    UINT16  Magic;
+    UINT8   MajorLinkerVersion;
+    UINT8   MinorLinkerVersion;
+    UINT32  SizeOfCode;
+    UINT32  SizeOfInitializedData;
+    UINT32  SizeOfUninitializedData;
+    UINT32  AddressOfEntryPoint;
+    UINT32  BaseOfCode;
+    UINT64  ImageBase;
+    UINT32  SectionAlignment;
+    UINT32  FileAlignment;
+    UINT16  MajorOperatingSystemVersion;
+    UINT16  MinorOperatingSystemVersion;
+    UINT16  MajorImageVersion;
+    UINT16  MinorImageVersion;
+    UINT16  MajorSubsystemVersion;
+    UINT16  MinorSubsystemVersion;
+    UINT32  Win32VersionValue;
+    UINT32  SizeOfImage;
+    UINT32  SizeOfHeaders;
+    UINT32  CheckSum;
+    UINT16  Subsystem;
+    UINT16  DllCharacteristics;
+    UINT64  SizeOfStackReserve;
+    UINT64  SizeOfStackCommit;
+    UINT64  SizeOfHeapReserve;
+    UINT64  SizeOfHeapCommit;
+    UINT32  LoaderFlags;
+    UINT32  NumberOfRvaAndSizes;
+    IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+};
+
+struct IMAGE_NT_HEADERS32 {
+    UINT32  Signature;
+    IMAGE_FILE_HEADER FileHeader;
+    IMAGE_OPTIONAL_HEADER32 OptionalHeader;
+};
+
+struct IMAGE_NT_HEADERS64 {
+    UINT32  Signature;
+    IMAGE_FILE_HEADER FileHeader;
+    IMAGE_OPTIONAL_HEADER64 OptionalHeader;
+};
+
+struct IMAGE_SECTION_HEADER {
+    UINT8   Name[IMAGE_SIZEOF_SHORT_NAME];
+    union {
+        UINT32  PhysicalAddress;
+        UINT32  VirtualSize;
+    } Misc;
+    UINT32  VirtualAddress;
+    UINT32  SizeOfRawData;
+    UINT32  PointerToRawData;
+    UINT32  PointerToRelocations;
+    UINT32  PointerToLinenumbers;
+    UINT16  NumberOfRelocations;
+    UINT16  NumberOfLinenumbers;
+    UINT32  Characteristics;
+};
+
+struct IMAGE_EXPORT_DIRECTORY {
+    UINT32  Characteristics;
+    UINT32  TimeDateStamp;
+    UINT16  MajorVersion;
+    UINT16  MinorVersion;
+    UINT32  Name;
+    UINT32  Base;
+    UINT32  NumberOfFunctions;
+    UINT32  NumberOfNames;
+    UINT32  AddressOfFunctions;
+    UINT32  AddressOfNames;
+    UINT32  AddressOfNameOrdinals;
+};
+
+struct IMAGE_IMPORT_DESCRIPTOR {
+    union {
+        UINT32  Characteristics;
+        UINT32  OriginalFirstThunk;
+    };
+    UINT32  TimeDateStamp;
+    UINT32  ForwarderChain;
+    UINT32  Name;
+    UINT32  FirstThunk;
+};
+
+struct IMAGE_IMPORT_BY_NAME {
+    UINT16  Hint;
+    char    Name[1];
+};
+
+struct IMAGE_THUNK_DATA32 {
+    union {
+        UINT32  ForwarderString;
+        UINT32  Function;
+        UINT32  Ordinal;
+        UINT32  AddressOfData;
+    } u1;
+};
+
+#pragma pack(push, 8)
+
+struct IMAGE_THUNK_DATA64 {
+    union {
+        UINT64  ForwarderString;
+        UINT64  Function;
+        UINT64  Ordinal;
+        UINT64  AddressOfData;
+    } u1;
+};
+
+#pragma pack(pop)
+
+struct IMAGE_BOUND_IMPORT_DESCRIPTOR {
+    UINT32  TimeDateStamp;
+    UINT16  OffsetModuleName;
+    UINT16  NumberOfModuleForwarderRefs;
+};
+
+struct IMAGE_BOUND_FORWARDER_REF {
+    UINT32  TimeDateStamp;
+    UINT16  OffsetModuleName;
+    UINT16  Reserved;
+};
+
+struct IMAGE_BASE_RELOCATION {
+    UINT32  VirtualAddress;
+    UINT32  SizeOfBlock;
+};
+
+struct IMAGE_RESOURCE_DIRECTORY {
+    UINT32  Characteristics;
+    UINT32  TimeDateStamp;
+    UINT16  MajorVersion;
+    UINT16  MinorVersion;
+    UINT16  NumberOfNamedEntries;
+    UINT16  NumberOfIdEntries;
+};
+
+struct IMAGE_RESOURCE_DIRECTORY_ENTRY {
+    union {
+        struct {
+            UINT32  NameOffset:31;
+            UINT32  NameIsString:1;
+        };
+        UINT32  Name;
+        UINT16  Id;
+    };
+    union {
+        UINT32  OffsetToData;
+        struct {
+            UINT32  OffsetToDirectory:31;
+            UINT32  DataIsDirectory:1;
+        };
+    };
+};
+
+struct IMAGE_RESOURCE_DATA_ENTRY {
+    UINT32  OffsetToData;
+    UINT32  Size;
+    UINT32  CodePage;
+    UINT32  Reserved;
+};
+
+struct IMAGE_RESOURCE_DIRECTORY_STRING {
+    UINT16  Length;
+    char    NameString[1];
+};
+
+// The names are in UTF-16, so they can only be used as wchar_t strings where wchar_t is 2 bytes, such as with -fshort-wchar.
+struct IMAGE_RESOURCE_DIR_STRING_U {
+    UINT16  Length;
+    UINT16  NameString[1];
+};
+
+struct VS_FIXEDFILEINFO {
+    UINT32  dwSignature;
+    UINT32  dwStrucVersion;
+    UINT32  dwFileVersionMS;
+    UINT32  dwFileVersionLS;
+    UINT32  dwProductVersionMS;
+    UINT32  dwProductVersionLS;
+    UINT32  dwFileFlagsMask;
+    UINT32  dwFileFlags;
+    UINT32  dwFileOS;
+    UINT32  dwFileType;
+    UINT32  dwFileSubtype;
+    UINT32  dwFileDateMS;
+    UINT32  dwFileDateLS;
+};
+
+#pragma pack(pop)
+
+#endif
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -34,9 +34,49 @@ ParsePEFromDiskFile(const file_char_t *pFilePath, IPEFile **ppFile)
 }
 
 HRESULT LIBPE_API
-ParsePEFromMappedFile(void *pMemory, IPEFile **ppFile)
+ParsePEFromMappedDiskFile(const file_char_t *pFilePath, IPEFile **ppFile)
 {
-    return E_NOTIMPL;
+    LibPEPtr<DataLoader> pDataLoader = new DataLoaderMappedFile;
+    LIBPE_ASSERT_RET(NULL != pDataLoader, E_OUTOFMEMORY);
+
+    DataLoaderMappedFile *pRawDataLoader = (DataLoaderMappedFile *)pDataLoader.p;
+    if(!pRawDataLoader->LoadFile(pFilePath)) {
+        return E_FAIL;
+    }
+
+    return ParsePEFromDataLoader(pDataLoader, ppFile);
+}
+
+HRESULT LIBPE_API
+ParsePEFromMappedFile(void *pMemory, UINT64 nSize, IPEFile **ppFile)
+{
+    LIBPE_ASSERT_RET(NULL != pMemory && 0 != nSize, E_INVALIDARG);
+
+    LibPEPtr<DataLoader> pDataLoader = new DataLoaderMemory;
+    LIBPE_ASSERT_RET(NULL != pDataLoader, E_OUTOFMEMORY);
+
+    DataLoaderMemory *pRawDataLoader = (DataLoaderMemory *)pDataLoader.p;
+    if(!pRawDataLoader->LoadBuffer(pMemory, nSize)) {
+        return E_FAIL;
+    }
+
+    return ParsePEFromDataLoader(pDataLoader, ppFile);
+}
+
+HRESULT LIBPE_API
+ParsePEFromImageBuffer(void *pMemory, UINT64 nSize, IPEFile **ppFile)
+{
+    LIBPE_ASSERT_RET(NULL != pMemory && 0 != nSize, E_INVALIDARG);
+
+    LibPEPtr<DataLoader> pDataLoader = new DataLoaderImageBuffer;
+    LIBPE_ASSERT_RET(NULL != pDataLoader, E_OUTOFMEMORY);
+
+    DataLoaderImageBuffer *pRawDataLoader = (DataLoaderImageBuffer *)pDataLoader.p;
+    if(!pRawDataLoader->LoadBuffer(pMemory, nSize)) {
+        return E_FAIL;
+    }
+
+    return ParsePEFromDataLoader(pDataLoader, ppFile);
 }
 
 #ifdef LIBPE_WINOS
@@ -3,13 +3,18 @@
 LIBPE_NAMESPACE_BEGIN
 
 enum {
-    DEFAULT_IO_MIN_BLOCK_SIZE  = 16 * 1024,
-    DEFAULT_IO_MAX_BLOCK_SIZE  = 2 * 1024 * 1024,
-    DEFAULT_IO_COUNT           = 3,
+    DEFAULT_IO_MIN_BLOCK_SIZE            = 16 * 1024,
+    DEFAULT_IO_MAX_BLOCK_SIZE            = 2 * 1024 * 1024,
+    DEFAULT_IO_COUNT                     = 3,
+    DEFAULT_CACHE_SIZE                   = 8 * 1024 * 1024,
+    DEFAULT_EXPORT_NAME_INDEX_THRESHOLD  = 8,
 };
 
 UINT64 s_nPELoaderMinBlockSize = 0;
 UINT64 s_nPELoaderMaxBlockSize = 0;
+UINT64 s_nPELoaderCacheSize = 0;
+BOOL s_bPELoaderAsyncReadAhead = false;
+UINT32 s_nPEExportNameIndexThreshold = 0;
 
 void LIBPE_API
 SetPELoaderIOBlockSize(UINT64 nMinBlockSize, UINT64 nMaxBlockSize)
@@ -24,9 +29,45 @@ GetPreferredPELoaderIOBlockSize(UINT64 nFileSize)
     UINT64 nMinBlockSize = (s_nPELoaderMaxBlockSize == 0) ? DEFAULT_IO_MIN_BLOCK_SIZE : s_nPELoaderMinBlockSize;
     UINT64 nMaxBlockSize = (s_nPELoaderMaxBlockSize == 0) ? DEFAULT_IO_MAX_BLOCK_SIZE : s_nPELoaderMaxBlockSize;
     UINT64 nBlockSize = nFileSize / DEFAULT_IO_COUNT;
-    if(nBlockSize < nMinBlockSize) { return nBlockSize; }
+    if(nBlockSize < nMinBlockSize) { return nMinBlockSize; }
     if(nBlockSize > nMaxBlockSize) { return nMaxBlockSize; }
     return (((nBlockSize & 0x3FFF) != 0) ? ((nBlockSize | 0x3FFF) + 1) : nBlockSize);
 }
 
+void LIBPE_API
+SetPELoaderCacheSize(UINT64 nMaxCacheSize)
+{
+    s_nPELoaderCacheSize = nMaxCacheSize;
+}
+
+UINT64
+GetPreferredPELoaderCacheSize()
+{
+    return (s_nPELoaderCacheSize == 0) ? DEFAULT_CACHE_SIZE : s_nPELoaderCacheSize;
+}
+
+void LIBPE_API
+SetPELoaderAsyncReadAhead(BOOL bEnable)
+{
+    s_bPELoaderAsyncReadAhead = bEnable;
+}
+
+BOOL
+IsPELoaderAsyncReadAheadEnabled()
+{
+    return s_bPELoaderAsyncReadAhead;
+}
+
+void LIBPE_API
+SetPEExportNameIndexThreshold(UINT32 nLookupCount)
+{
+    s_nPEExportNameIndexThreshold = nLookupCount;
+}
+
+UINT32
+GetPreferredPEExportNameIndexThreshold()
+{
+    return (s_nPEExportNameIndexThreshold == 0) ? DEFAULT_EXPORT_NAME_INDEX_THRESHOLD : s_nPEExportNameIndexThreshold;
+}
+
 LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -5,5 +5,8 @@
 LIBPE_NAMESPACE_BEGIN
 
 UINT64 GetPreferredPELoaderIOBlockSize(UINT64 nFileSize);
+UINT64 GetPreferredPELoaderCacheSize();
+BOOL IsPELoaderAsyncReadAheadEnabled();
+UINT32 GetPreferredPEExportNameIndexThreshold();
 
 LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -3,17 +3,30 @@
 #include "LibPE.h"
 #include "LibPEConfig.h"
 
+// Define LIBPE_NO_SIMD to force the scalar code paths.
+#if !defined(LIBPE_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define LIBPE_USE_SSE2
+#endif
+
 LIBPE_NAMESPACE_BEGIN
 
 #define LIBPE_ASSERT(cond)              do { if(!(cond)) { assert(false); } } while(0)
 #define LIBPE_ASSERT_RET(cond, ret)     do { if(!(cond)) { assert(false); return (ret); } } while(0)
 #define LIBPE_ASSERT_RET_VOID(cond)     do { if(!(cond)) { assert(false); return; } } while(0)
 
+// The other compilers don't convert a member function pointer to void *, so the classes are instantiated explicitly
+// there, which covers their member functions too.
+#ifdef _MSC_VER
 #define LIBPE_FORCE_TEMPLATE_REDUCTION_FUNCTION_T(f, trait)              static void *__dummy_function_## f ## _ ## trait = (void *)&f<trait>
 #define LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS_FUNCTION_T(t, f, trait)     static void *__dummy_class_function_## t ## _ ## f ## _ ## trait = (void *)&t<trait>::f
 #define LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS_T(t, trait)                               \
     static void __dummy_function_## t ## _ ## trait(t<trait> *dummy) { dummy->t<trait>::~t(); }             \
     static void *__dummy_function_ref_ ## t ## _ ## trait= &__dummy_function_## t ## _ ## trait
+#else
+#define LIBPE_FORCE_TEMPLATE_REDUCTION_FUNCTION_T(f, trait)              static void *__dummy_function_## f ## _ ## trait = (void *)&f<trait>
+#define LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS_FUNCTION_T(t, f, trait)     typedef t<trait> __dummy_class_function_## t ## _ ## f ## _ ## trait
+#define LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS_T(t, trait)                 template class t<trait>
+#endif
 
 #define LIBPE_FORCE_TEMPLATE_REDUCTION_FUNCTION(f)                              \
     LIBPE_FORCE_TEMPLATE_REDUCTION_FUNCTION_T(f, PE32);                         \
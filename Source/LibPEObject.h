@@ -77,13 +77,143 @@ public:
     RefCountThreadSafe() : m_nRefCount(0) {}
     ~RefCountThreadSafe() {}
 
+#ifdef LIBPE_WINOS
     UINT32 AddRef(void) { return (UINT32)::InterlockedIncrement((volatile LONG *)&m_nRefCount); }
     UINT32 Release(void) { return (UINT32)::InterlockedDecrement((volatile LONG *)&m_nRefCount); }
+#else
+    UINT32 AddRef(void) { return __sync_add_and_fetch(&m_nRefCount, 1); }
+    UINT32 Release(void) { return __sync_sub_and_fetch(&m_nRefCount, 1); }
+#endif
 
 private:
     UINT32 m_nRefCount;
 };
 
+class Mutex
+{
+public:
+#ifdef LIBPE_WINOS
+    Mutex() { ::InitializeCriticalSection(&m_oLock); }
+    ~Mutex() { ::DeleteCriticalSection(&m_oLock); }
+
+    void Lock() { ::EnterCriticalSection(&m_oLock); }
+    void Unlock() { ::LeaveCriticalSection(&m_oLock); }
+#else
+    Mutex() { ::pthread_mutex_init(&m_oLock, NULL); }
+    ~Mutex() { ::pthread_mutex_destroy(&m_oLock); }
+
+    void Lock() { ::pthread_mutex_lock(&m_oLock); }
+    void Unlock() { ::pthread_mutex_unlock(&m_oLock); }
+#endif
+
+private:
+    friend class Condition;
+
+#ifdef LIBPE_WINOS
+    CRITICAL_SECTION    m_oLock;
+#else
+    pthread_mutex_t     m_oLock;
+#endif
+};
+
+class ScopedLock
+{
+public:
+    ScopedLock(Mutex &oMutex) : m_oMutex(oMutex) { m_oMutex.Lock(); }
+    ~ScopedLock() { m_oMutex.Unlock(); }
+
+private:
+    Mutex &m_oMutex;
+};
+
+class Condition
+{
+public:
+#ifdef LIBPE_WINOS
+    Condition() { ::InitializeConditionVariable(&m_oCondition); }
+    ~Condition() {}
+
+    void Wait(Mutex &oMutex) { ::SleepConditionVariableCS(&m_oCondition, &oMutex.m_oLock, INFINITE); }
+    void NotifyAll() { ::WakeAllConditionVariable(&m_oCondition); }
+#else
+    Condition() { ::pthread_cond_init(&m_oCondition, NULL); }
+    ~Condition() { ::pthread_cond_destroy(&m_oCondition); }
+
+    void Wait(Mutex &oMutex) { ::pthread_cond_wait(&m_oCondition, &oMutex.m_oLock); }
+    void NotifyAll() { ::pthread_cond_broadcast(&m_oCondition); }
+#endif
+
+private:
+#ifdef LIBPE_WINOS
+    CONDITION_VARIABLE  m_oCondition;
+#else
+    pthread_cond_t      m_oCondition;
+#endif
+};
+
+class Thread
+{
+public:
+    typedef void (*ThreadProc)(void *pParam);
+
+public:
+    Thread() : m_pProc(NULL), m_pParam(NULL), m_bStarted(false) {}
+    ~Thread() { Join(); }
+
+    BOOL Start(ThreadProc pProc, void *pParam)
+    {
+        LIBPE_ASSERT_RET(!m_bStarted && NULL != pProc, false);
+        m_pProc = pProc;
+        m_pParam = pParam;
+#ifdef LIBPE_WINOS
+        m_hThread = ::CreateThread(NULL, 0, ThreadEntry, this, 0, NULL);
+        m_bStarted = (NULL != m_hThread);
+#else
+        m_bStarted = (0 == ::pthread_create(&m_hThread, NULL, ThreadEntry, this));
+#endif
+        return m_bStarted;
+    }
+
+    void Join()
+    {
+        if(!m_bStarted) {
+            return;
+        }
+#ifdef LIBPE_WINOS
+        ::WaitForSingleObject(m_hThread, INFINITE);
+        ::CloseHandle(m_hThread);
+#else
+        ::pthread_join(m_hThread, NULL);
+#endif
+        m_bStarted = false;
+    }
+
+private:
+#ifdef LIBPE_WINOS
+    static DWORD WINAPI ThreadEntry(LPVOID pThread)
+    {
+        ((Thread *)pThread)->m_pProc(((Thread *)pThread)->m_pParam);
+        return 0;
+    }
+#else
+    static void * ThreadEntry(void *pThread)
+    {
+        ((Thread *)pThread)->m_pProc(((Thread *)pThread)->m_pParam);
+        return NULL;
+    }
+#endif
+
+private:
+    ThreadProc  m_pProc;
+    void        *m_pParam;
+    BOOL        m_bStarted;
+#ifdef LIBPE_WINOS
+    HANDLE      m_hThread;
+#else
+    pthread_t   m_hThread;
+#endif
+};
+
 #define LIBPE_INTERFACE_IMPL()                                              \
     public:                                                                 \
         LIBPE_METHOD_(UINT32, AddRef)()                                   \
@@ -0,0 +1,149 @@
+#include "stdafx.h"
+#include "PE/PEArena.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+enum {
+    ARENA_CHUNK_SIZE        = 64 * 1024,
+    ARENA_ALIGNMENT         = 16,
+};
+
+// Every allocation begins with this header, so Free() knows where the memory comes from.
+// The header takes a whole alignment unit, so the object after it is still aligned.
+union PEArenaHeader {
+    struct {
+        union {
+            PEArena         *pArena;        // While the memory is in use.
+            PEArenaHeader   *pNextFree;     // While the memory is in the free list of its arena.
+        };
+        size_t              nSize;          // Aligned size of the whole allocation, for the memory from an arena only.
+    } oInfo;
+    INT8    nPadding[ARENA_ALIGNMENT];
+};
+
+static size_t
+GetAlignedSize(size_t nSize)
+{
+    return (nSize + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+}
+
+PEArena::PEArena()
+    : m_pChunkCursor(NULL)
+    , m_nChunkLeftSize(0)
+{
+
+}
+
+PEArena::~PEArena()
+{
+    std::vector<INT8 *>::iterator itChunk = m_vChunks.begin();
+    while(itChunk != m_vChunks.end()) {
+        delete [] *itChunk;
+        ++itChunk;
+    }
+    m_vChunks.clear();
+}
+
+void *
+PEArena::Allocate(PEArena *pArena, size_t nSize)
+{
+    size_t nTotalSize = sizeof(PEArenaHeader) + nSize;
+
+    PEArenaHeader *pHeader = NULL;
+    if(NULL == pArena) {
+        pHeader = (PEArenaHeader *)::operator new(nTotalSize);
+    } else {
+        nTotalSize = GetAlignedSize(nTotalSize);
+        pHeader = pArena->AllocateFromFreeList(nTotalSize);
+        if(NULL == pHeader) {
+            pHeader = (PEArenaHeader *)pArena->AllocateFromChunk(nTotalSize);
+        }
+    }
+
+    if(NULL == pHeader) {
+        return NULL;
+    }
+
+    // Each living allocation holds a reference, so the arena is kept until the last element is gone.
+    pHeader->oInfo.pArena = pArena;
+    pHeader->oInfo.nSize = nTotalSize;
+    if(NULL != pArena) {
+        pArena->AddRef();
+    }
+
+    return &(pHeader[1]);
+}
+
+void
+PEArena::Free(void *pMemory)
+{
+    if(NULL == pMemory) {
+        return;
+    }
+
+    PEArenaHeader *pHeader = &(((PEArenaHeader *)pMemory)[-1]);
+    PEArena *pArena = pHeader->oInfo.pArena;
+    if(NULL == pArena) {
+        ::operator delete(pHeader);
+        return;
+    }
+
+    // The memory goes back to the arena for the next allocation of the same size, and the chunks are freed with the
+    // arena. Release() must be the last one, because it might delete the arena.
+    pArena->AddToFreeList(pHeader);
+    pArena->Release();
+}
+
+PEArenaHeader *
+PEArena::AllocateFromFreeList(size_t nSize)
+{
+    std::map<size_t, PEArenaHeader *>::iterator itFreeList = m_mapFreeLists.find(nSize);
+    if(itFreeList == m_mapFreeLists.end() || NULL == itFreeList->second) {
+        return NULL;
+    }
+
+    PEArenaHeader *pHeader = itFreeList->second;
+    itFreeList->second = pHeader->oInfo.pNextFree;
+
+    return pHeader;
+}
+
+void
+PEArena::AddToFreeList(PEArenaHeader *pHeader)
+{
+    PEArenaHeader *&pFreeList = m_mapFreeLists[pHeader->oInfo.nSize];
+    pHeader->oInfo.pNextFree = pFreeList;
+    pFreeList = pHeader;
+}
+
+void *
+PEArena::AllocateFromChunk(size_t nSize)
+{
+    // The size is aligned by the caller.
+
+    if(nSize > m_nChunkLeftSize) {
+        size_t nChunkSize = (nSize > ARENA_CHUNK_SIZE) ? nSize : ARENA_CHUNK_SIZE;
+        INT8 *pChunk = new INT8[nChunkSize];
+        if(NULL == pChunk) {
+            return NULL;
+        }
+
+        m_vChunks.push_back(pChunk);
+
+        // A large allocation takes its own chunk, so we keep on using the rest of the current chunk.
+        if(nChunkSize == nSize && 0 != m_nChunkLeftSize) {
+            return pChunk;
+        }
+
+        m_pChunkCursor = pChunk;
+        m_nChunkLeftSize = nChunkSize;
+    }
+
+    void *pMemory = m_pChunkCursor;
+    m_pChunkCursor += nSize;
+    m_nChunkLeftSize -= nSize;
+
+    return pMemory;
+}
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+LIBPE_NAMESPACE_BEGIN
+
+union PEArenaHeader;
+
+// PEArena owns the storage of the parsed elements of one PE file. The elements are bump allocated from large chunks,
+// and all the chunks are freed at once when the arena is released by the parser and by the last living element.
+// The memory of a freed element is kept in a free list of its size, and it is reused by the next element of that size,
+// so creating and releasing the same elements again and again doesn't grow the arena.
+class PEArena :
+    public ILibPEInterface
+{
+public:
+    PEArena();
+    virtual ~PEArena();
+
+    LIBPE_SINGLE_THREAD_OBJECT();
+
+    // If pArena is NULL, the memory is allocated from the heap, so it can be freed by Free() as well.
+    static void * Allocate(PEArena *pArena, size_t nSize);
+    static void Free(void *pMemory);
+
+protected:
+    PEArenaHeader * AllocateFromFreeList(size_t nSize);
+    void AddToFreeList(PEArenaHeader *pHeader);
+    void * AllocateFromChunk(size_t nSize);
+
+private:
+    std::vector<INT8 *>                 m_vChunks;
+    INT8                                *m_pChunkCursor;
+    size_t                              m_nChunkLeftSize;
+    std::map<size_t, PEArenaHeader *>   m_mapFreeLists;
+};
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "PE/PEBoundImportTable.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+template <class T>
+HRESULT
+PEBoundImportTableT<T>::GetModuleByIndex(UINT32 nIndex, IPEBoundImportModule **ppModule)
+{
+    LIBPE_ASSERT_RET(NULL != ppModule, E_POINTER);
+    LIBPE_ASSERT_RET(nIndex < GetModuleCount(), E_INVALIDARG);
+
+    ModuleInfo &oInfo = m_vModules[nIndex];
+    if(NULL == oInfo.m_pBoundImportModule) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseBoundImportModule(GetRVA(), oInfo.m_nBoundImportDescRVA, oInfo.m_nBoundImportDescFOA, oInfo.m_pBoundImportDesc, &oInfo.m_pBoundImportModule)) || NULL == oInfo.m_pBoundImportModule) {
+            return E_FAIL;
+        }
+    }
+
+    return oInfo.m_pBoundImportModule.CopyTo(ppModule);
+}
+
+template <class T>
+HRESULT
+PEBoundImportTableT<T>::GetModuleByName(const char *pModuleName, IPEBoundImportModule **ppModule)
+{
+    LIBPE_ASSERT_RET(NULL != pModuleName && NULL != ppModule, E_POINTER);
+    *ppModule = NULL;
+
+    if(!m_bIsModuleNameIndexBuilt && !BuildModuleNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nModuleIndex = 0;
+    if(!m_oModuleNameIndex.Find(pModuleName, nModuleIndex)) {
+        return E_FAIL;
+    }
+
+    return GetModuleByIndex(nModuleIndex, ppModule);
+}
+
+template <class T>
+BOOL
+PEBoundImportTableT<T>::BuildModuleNameIndex()
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    // The index points to the names, so they are kept as long as the table.
+    UINT32 nModuleCount = GetModuleCount();
+    m_oModuleNameIndex.Reserve(nModuleCount);
+    for(UINT32 nModuleIndex = 0; nModuleIndex < nModuleCount; ++nModuleIndex) {
+        UINT64 nNameSize = 0;
+        const char *pName = KeepAnsiString(GetRVA() + m_vModules[nModuleIndex].m_pBoundImportDesc->OffsetModuleName, 0, nNameSize);
+        if(NULL != pName) {
+            m_oModuleNameIndex.Add(pName, nModuleIndex);
+        }
+    }
+
+    m_bIsModuleNameIndexBuilt = true;
+
+    return true;
+}
+
+template <class T>
+const char *
+PEBoundImportModuleT<T>::GetForwarderRefName(UINT32 nIndex)
+{
+    LIBPE_ASSERT_RET(nIndex < m_nForwarderRefCount && NULL != m_pForwarderRefs, NULL);
+    LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
+
+    // Each name is parsed once and kept as long as the module, so asking for it again doesn't load it again.
+    if(m_vForwarderRefNames.size() != m_nForwarderRefCount) {
+        m_vForwarderRefNames.assign(m_nForwarderRefCount, (const char *)NULL);
+    }
+
+    if(NULL == m_vForwarderRefNames[nIndex]) {
+        UINT64 nNameSize = 0;
+        m_vForwarderRefNames[nIndex] = KeepAnsiString(m_nBoundImportTableRVA + m_pForwarderRefs[nIndex].OffsetModuleName, 0, nNameSize);
+    }
+
+    return m_vForwarderRefNames[nIndex];
+}
+
+template <class T>
+UINT32
+PEBoundImportModuleT<T>::GetForwarderRefTimeDateStamp(UINT32 nIndex)
+{
+    LIBPE_ASSERT_RET(nIndex < m_nForwarderRefCount && NULL != m_pForwarderRefs, 0);
+    return m_pForwarderRefs[nIndex].TimeDateStamp;
+}
+
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEBoundImportTableT);
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEBoundImportModuleT);
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "PE/PEElement.h"
+#include "PE/PENameIndex.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+template <class T>
+class PEBoundImportTableT :
+    public IPEBoundImportTable,
+    public PEElementT<T>
+{
+    struct ModuleInfo {
+        PEAddress                               m_nBoundImportDescRVA;
+        PEAddress                               m_nBoundImportDescFOA;
+        LibPERawBoundImportDescriptor(T)        *m_pBoundImportDesc;
+        LibPEPtr<IPEBoundImportModule>          m_pBoundImportModule;
+    };
+    typedef std::vector<ModuleInfo> ModuleList;
+
+public:
+    PEBoundImportTableT() : m_oModuleNameIndex(true), m_bIsModuleNameIndexBuilt(false) {}
+    virtual ~PEBoundImportTableT() {}
+
+    DECLARE_PE_ELEMENT(LibPERawBoundImportDescriptor(T))
+
+    void InnerAddBoundImportDescriptor(PEAddress nBoundImportDescRVA, PEAddress nBoundImportDescFOA, LibPERawBoundImportDescriptor(T) *pBoundImportDesc) {
+        LIBPE_ASSERT_RET_VOID(NULL != pBoundImportDesc);
+        ModuleInfo oInfo;
+        oInfo.m_nBoundImportDescRVA = nBoundImportDescRVA;
+        oInfo.m_nBoundImportDescFOA = nBoundImportDescFOA;
+        oInfo.m_pBoundImportDesc = pBoundImportDesc;
+        m_vModules.push_back(oInfo);
+    }
+
+    virtual UINT32 LIBPE_CALLTYPE GetModuleCount() { return (UINT32)m_vModules.size(); }
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByIndex(UINT32 nIndex, IPEBoundImportModule **ppModule);
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByName(const char *pModuleName, IPEBoundImportModule **ppModule);
+
+protected:
+    BOOL BuildModuleNameIndex();
+
+private:
+    ModuleList      m_vModules;
+    PENameIndex     m_oModuleNameIndex;
+    BOOL            m_bIsModuleNameIndexBuilt;
+};
+
+template <class T>
+class PEBoundImportModuleT :
+    public IPEBoundImportModule,
+    public PEElementT<T>
+{
+public:
+    PEBoundImportModuleT() : m_nBoundImportTableRVA(0), m_pName(NULL), m_pForwarderRefs(NULL), m_nForwarderRefCount(0) {}
+    virtual ~PEBoundImportModuleT() {}
+
+    DECLARE_PE_ELEMENT(LibPERawBoundImportDescriptor(T))
+
+    // All the names are at offsets from the beginning of the bound import table.
+    void InnerSetBoundImportTableRVA(PEAddress nRVA) { m_nBoundImportTableRVA = nRVA; }
+    void InnerSetName(const char *pName) { m_pName = pName; }
+    void InnerSetForwarderRefs(LibPERawBoundForwarderRef(T) *pForwarderRefs, UINT32 nCount) { m_pForwarderRefs = pForwarderRefs; m_nForwarderRefCount = nCount; }
+
+    LIBPE_FIELD_ACCESSOR(UINT32, TimeDateStamp)
+    LIBPE_FIELD_ACCESSOR(UINT16, OffsetModuleName)
+    LIBPE_FIELD_ACCESSOR(UINT16, NumberOfModuleForwarderRefs)
+
+    virtual const char * LIBPE_CALLTYPE GetName() { return m_pName; }
+    virtual UINT32 LIBPE_CALLTYPE GetForwarderRefCount() { return m_nForwarderRefCount; }
+    virtual const char * LIBPE_CALLTYPE GetForwarderRefName(UINT32 nIndex);
+    virtual UINT32 LIBPE_CALLTYPE GetForwarderRefTimeDateStamp(UINT32 nIndex);
+
+private:
+    PEAddress                           m_nBoundImportTableRVA;
+    const char                          *m_pName;
+    LibPERawBoundForwarderRef(T)        *m_pForwarderRefs;
+    UINT32                              m_nForwarderRefCount;
+    std::vector<const char *>           m_vForwarderRefNames;
+};
+
+typedef PEBoundImportTableT<PE32> PEBoundImportTable32;
+typedef PEBoundImportModuleT<PE32> PEBoundImportModule32;
+
+typedef PEBoundImportTableT<PE64> PEBoundImportTable64;
+typedef PEBoundImportModuleT<PE64> PEBoundImportModule64;
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "stdafx.h"
+#include "PE/PEDelayImportTable.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+template <class T>
+HRESULT
+PEDelayImportTableT<T>::GetModuleByIndex(UINT32 nIndex, IPEDelayImportModule **ppModule)
+{
+    LIBPE_ASSERT_RET(NULL != ppModule, E_POINTER);
+    LIBPE_ASSERT_RET(nIndex < GetModuleCount(), E_INVALIDARG);
+
+    ModuleInfo &oInfo = m_vModules[nIndex];
+    if(NULL == oInfo.m_pDelayImportModule) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseDelayImportModule(oInfo.m_nDelayImportDescRVA, oInfo.m_nDelayImportDescFOA, oInfo.m_pDelayImportDesc, &oInfo.m_pDelayImportModule)) || NULL == oInfo.m_pDelayImportModule) {
+            return E_FAIL;
+        }
+    }
+
+    return oInfo.m_pDelayImportModule.CopyTo(ppModule);
+}
+
+template <class T>
+HRESULT
+PEDelayImportTableT<T>::GetModuleByName(const char *pModuleName, IPEDelayImportModule **ppModule)
+{
+    LIBPE_ASSERT_RET(NULL != pModuleName && NULL != ppModule, E_POINTER);
+    *ppModule = NULL;
+
+    if(!m_bIsModuleNameIndexBuilt && !BuildModuleNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nModuleIndex = 0;
+    if(!m_oModuleNameIndex.Find(pModuleName, nModuleIndex)) {
+        return E_FAIL;
+    }
+
+    return GetModuleByIndex(nModuleIndex, ppModule);
+}
+
+template <class T>
+HRESULT
+PEDelayImportTableT<T>::GetFunctionByName(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppFunction)
+{
+    LIBPE_ASSERT_RET(NULL != pModuleName && NULL != pFunctionName && NULL != ppFunction, E_POINTER);
+    *ppFunction = NULL;
+
+    if(!m_bIsModuleNameIndexBuilt && !BuildModuleNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nModuleIndex = 0;
+    if(!m_oModuleNameIndex.Find(pModuleName, nModuleIndex)) {
+        return E_FAIL;
+    }
+
+    // A module can be delay imported by more than one descriptor, so all of them are searched.
+    while(DELAY_IMPORT_NO_MODULE_INDEX != nModuleIndex) {
+        LibPEPtr<IPEDelayImportModule> pModule;
+        if(SUCCEEDED(GetModuleByIndex(nModuleIndex, &pModule)) && NULL != pModule) {
+            if(SUCCEEDED(pModule->GetFunctionByName(pFunctionName, ppFunction)) && NULL != *ppFunction) {
+                return S_OK;
+            }
+        }
+        nModuleIndex = m_vModules[nModuleIndex].m_nNextSameNameModuleIndex;
+    }
+
+    return E_FAIL;
+}
+
+template <class T>
+BOOL
+PEDelayImportTableT<T>::BuildModuleNameIndex()
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    UINT32 nModuleCount = GetModuleCount();
+    m_oModuleNameIndex.Reserve(nModuleCount);
+
+    // The index keeps the first descriptor of each module, and the other descriptors with the same name are chained to it.
+    // The index points to the names, so they are kept as long as the table.
+    std::vector<UINT32> vLastSameNameModuleIndexes(nModuleCount, (UINT32)DELAY_IMPORT_NO_MODULE_INDEX);
+    for(UINT32 nModuleIndex = 0; nModuleIndex < nModuleCount; ++nModuleIndex) {
+        LibPERawDelayImportDescriptor(T) *pDelayImportDesc = m_vModules[nModuleIndex].m_pDelayImportDesc;
+        PEAddress nNameRVA = pDelayImportDesc->DllNameRVA;
+        if(0 == (pDelayImportDesc->Attributes & PE_DELAY_IMPORT_ATTRIBUTE_RVA_BASED)) {
+            nNameRVA = m_pParser->GetRVAFromVA(nNameRVA);
+        }
+
+        UINT64 nNameSize = 0;
+        const char *pName = KeepAnsiString(nNameRVA, 0, nNameSize);
+        if(NULL == pName) {
+            continue;
+        }
+
+        UINT32 nFirstModuleIndex = 0;
+        if(!m_oModuleNameIndex.Find(pName, nFirstModuleIndex)) {
+            m_oModuleNameIndex.Add(pName, nModuleIndex);
+            vLastSameNameModuleIndexes[nModuleIndex] = nModuleIndex;
+            continue;
+        }
+
+        m_vModules[vLastSameNameModuleIndexes[nFirstModuleIndex]].m_nNextSameNameModuleIndex = nModuleIndex;
+        vLastSameNameModuleIndexes[nFirstModuleIndex] = nModuleIndex;
+    }
+
+    m_bIsModuleNameIndexBuilt = true;
+
+    return true;
+}
+
+template <class T>
+BOOL
+PEDelayImportModuleT<T>::IsRVABased()
+{
+    LibPERawDelayImportDescriptor(T) *pDelayImportDesc = GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pDelayImportDesc, false);
+    return (0 != (pDelayImportDesc->Attributes & PE_DELAY_IMPORT_ATTRIBUTE_RVA_BASED));
+}
+
+template <class T>
+HRESULT
+PEDelayImportModuleT<T>::GetFunctionByIndex(UINT32 nIndex, IPEImportFunction **ppFunction)
+{
+    LIBPE_ASSERT_RET(NULL != ppFunction, E_POINTER);
+    LIBPE_ASSERT_RET(nIndex < GetFunctionCount(), E_INVALIDARG);
+
+    FunctionInfo &oInfo = m_vFunctions[nIndex];
+    if(NULL == oInfo.m_pFunction) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseImportFunction(&oInfo.m_oThunkData, &oInfo.m_pFunction)) || NULL == oInfo.m_pFunction) {
+            return E_FAIL;
+        }
+    }
+
+    return oInfo.m_pFunction.CopyTo(ppFunction);
+}
+
+template <class T>
+HRESULT
+PEDelayImportModuleT<T>::GetFunctionByName(const char *pFunctionName, IPEImportFunction **ppFunction)
+{
+    LIBPE_ASSERT_RET(NULL != pFunctionName && NULL != ppFunction, E_POINTER);
+    *ppFunction = NULL;
+
+    if(!m_bIsFunctionNameIndexBuilt && !BuildFunctionNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nFunctionIndex = 0;
+    if(!m_oFunctionNameIndex.Find(pFunctionName, nFunctionIndex)) {
+        return E_FAIL;
+    }
+
+    return GetFunctionByIndex(nFunctionIndex, ppFunction);
+}
+
+template <class T>
+BOOL
+PEDelayImportModuleT<T>::BuildFunctionNameIndex()
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    // The name table of the delay imports has the same thunks as the regular one. The index points to the names,
+    // so they are kept as long as the module.
+    UINT32 nFunctionCount = GetFunctionCount();
+    m_oFunctionNameIndex.Reserve(nFunctionCount);
+    for(UINT32 nFunctionIndex = 0; nFunctionIndex < nFunctionCount; ++nFunctionIndex) {
+        LibPERawThunkData(T) *pThunkData = &m_vFunctions[nFunctionIndex].m_oThunkData;
+        if(0 != (pThunkData->u1.Ordinal & PETrait<T>::OrdinalFlag)) {
+            continue;
+        }
+
+        UINT64 nNameSize = 0;
+        const char *pName = KeepAnsiString(pThunkData->u1.AddressOfData + sizeof(UINT16), 0, nNameSize);
+        if(NULL != pName) {
+            m_oFunctionNameIndex.Add(pName, nFunctionIndex);
+        }
+    }
+
+    m_bIsFunctionNameIndexBuilt = true;
+
+    return true;
+}
+
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEDelayImportTableT);
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEDelayImportModuleT);
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "PE/PEElement.h"
+#include "PE/PENameIndex.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+enum {
+    DELAY_IMPORT_NO_MODULE_INDEX    = 0xFFFFFFFF,
+};
+
+template <class T>
+class PEDelayImportTableT :
+    public IPEDelayImportTable,
+    public PEElementT<T>
+{
+    struct ModuleInfo {
+        PEAddress                               m_nDelayImportDescRVA;
+        PEAddress                               m_nDelayImportDescFOA;
+        LibPERawDelayImportDescriptor(T)        *m_pDelayImportDesc;
+        UINT32                                  m_nNextSameNameModuleIndex;
+        LibPEPtr<IPEDelayImportModule>          m_pDelayImportModule;
+    };
+    typedef std::vector<ModuleInfo> ModuleList;
+
+public:
+    PEDelayImportTableT() : m_oModuleNameIndex(true), m_bIsModuleNameIndexBuilt(false) {}
+    virtual ~PEDelayImportTableT() {}
+
+    DECLARE_PE_ELEMENT(LibPERawDelayImportDescriptor(T))
+
+    void InnerAddDelayImportDescriptor(PEAddress nDelayImportDescRVA, PEAddress nDelayImportDescFOA, LibPERawDelayImportDescriptor(T) *pDelayImportDesc) {
+        LIBPE_ASSERT_RET_VOID(NULL != pDelayImportDesc);
+        ModuleInfo oInfo;
+        oInfo.m_nDelayImportDescRVA = nDelayImportDescRVA;
+        oInfo.m_nDelayImportDescFOA = nDelayImportDescFOA;
+        oInfo.m_pDelayImportDesc = pDelayImportDesc;
+        oInfo.m_nNextSameNameModuleIndex = DELAY_IMPORT_NO_MODULE_INDEX;
+        m_vModules.push_back(oInfo);
+    }
+
+    virtual UINT32 LIBPE_CALLTYPE GetModuleCount() { return (UINT32)m_vModules.size(); }
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByIndex(UINT32 nIndex, IPEDelayImportModule **ppModule);
+    virtual HRESULT LIBPE_CALLTYPE GetModuleByName(const char *pModuleName, IPEDelayImportModule **ppModule);
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppFunction);
+
+protected:
+    BOOL BuildModuleNameIndex();
+
+private:
+    ModuleList      m_vModules;
+    PENameIndex     m_oModuleNameIndex;
+    BOOL            m_bIsModuleNameIndexBuilt;
+};
+
+template <class T>
+class PEDelayImportModuleT :
+    public IPEDelayImportModule,
+    public PEElementT<T>
+{
+    struct FunctionInfo {
+        LibPERawThunkData(T)            m_oThunkData;
+        LibPEPtr<IPEImportFunction>     m_pFunction;
+    };
+    typedef std::vector<FunctionInfo> FunctionList;
+
+public:
+    PEDelayImportModuleT() : m_pName(NULL), m_bIsFunctionNameIndexBuilt(false) {}
+    virtual ~PEDelayImportModuleT() {}
+
+    DECLARE_PE_ELEMENT(LibPERawDelayImportDescriptor(T))
+
+    void InnerSetName(const char *pName) { m_pName = pName; }
+    void InnerAddImportFunctionThunk(const LibPERawThunkData(T) &oThunk) {
+        FunctionInfo oInfo;
+        oInfo.m_oThunkData = oThunk;
+        m_vFunctions.push_back(oInfo);
+    }
+
+    LIBPE_FIELD_ACCESSOR(UINT32, Attributes)
+    LIBPE_FIELD_ACCESSOR(UINT32, DllNameRVA)
+    LIBPE_FIELD_ACCESSOR(UINT32, ModuleHandleRVA)
+    LIBPE_FIELD_ACCESSOR(UINT32, ImportAddressTableRVA)
+    LIBPE_FIELD_ACCESSOR(UINT32, ImportNameTableRVA)
+    LIBPE_FIELD_ACCESSOR(UINT32, BoundImportAddressTableRVA)
+    LIBPE_FIELD_ACCESSOR(UINT32, UnloadInformationTableRVA)
+    LIBPE_FIELD_ACCESSOR(UINT32, TimeDateStamp)
+
+    virtual BOOL LIBPE_CALLTYPE IsRVABased();
+    virtual const char * LIBPE_CALLTYPE GetName() { return m_pName; }
+    virtual UINT32 LIBPE_CALLTYPE GetFunctionCount() { return (UINT32)m_vFunctions.size(); }
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByIndex(UINT32 nIndex, IPEImportFunction **ppFunction);
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pFunctionName, IPEImportFunction **ppFunction);
+
+protected:
+    BOOL BuildFunctionNameIndex();
+
+private:
+    const char      *m_pName;
+    FunctionList    m_vFunctions;
+    PENameIndex     m_oFunctionNameIndex;
+    BOOL            m_bIsFunctionNameIndexBuilt;
+};
+
+typedef PEDelayImportTableT<PE32> PEDelayImportTable32;
+typedef PEDelayImportModuleT<PE32> PEDelayImportModule32;
+
+typedef PEDelayImportTableT<PE64> PEDelayImportTable64;
+typedef PEDelayImportModuleT<PE64> PEDelayImportModule64;
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
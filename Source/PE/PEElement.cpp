@@ -3,13 +3,64 @@
 
 LIBPE_NAMESPACE_BEGIN
 
+template <class T>
+PEElementT<T>::~PEElementT()
+{
+    // Only the buffer loaded by ourselves is given back. The one set by InnerSetRawMemory belongs to someone else.
+    if(m_bIsRawBufferLoaded && NULL != m_pParser) {
+        m_pParser->ReleaseRawMemory(m_pRawBuffer, m_nRawBufferOffset, m_nRawBufferSize);
+    }
+
+    if(NULL != m_pParser) {
+        typename KeptRawBufferList::iterator itKeptRawBuffer = m_vKeptRawBuffers.begin();
+        while(itKeptRawBuffer != m_vKeptRawBuffers.end()) {
+            m_pParser->ReleaseRawMemory(itKeptRawBuffer->m_pBuffer, itKeptRawBuffer->m_nOffset, itKeptRawBuffer->m_nSize);
+            ++itKeptRawBuffer;
+        }
+    }
+}
+
+template <class T>
+void
+PEElementT<T>::InnerKeepRawMemory(void *pBuffer, UINT64 nOffset, UINT64 nSize)
+{
+    if(NULL == pBuffer) {
+        return;
+    }
+
+    KeptRawBuffer oKeptRawBuffer;
+    oKeptRawBuffer.m_pBuffer = pBuffer;
+    oKeptRawBuffer.m_nOffset = nOffset;
+    oKeptRawBuffer.m_nSize = nSize;
+    m_vKeptRawBuffers.push_back(oKeptRawBuffer);
+}
+
+template <class T>
+const char *
+PEElementT<T>::KeepAnsiString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize)
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
+
+    const char *pString = m_pParser->ParseAnsiString(nRVA, nFOA, nSize);
+    if(NULL != pString) {
+        InnerKeepRawMemory((void *)pString, m_pParser->GetRawOffset(nRVA, nFOA), nSize);
+    }
+
+    return pString;
+}
+
 template <class T>
 void *
 PEElementT<T>::GetRawMemory()
 {
     if(NULL == m_pRawBuffer) {
         LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
-        m_pRawBuffer = m_pParser->GetRawMemory(GetRawOffset(), GetRawSize());
+
+        // The range is kept, because the buffer must be released with the same range even if the element has changed.
+        m_nRawBufferOffset = GetRawOffset();
+        m_nRawBufferSize = GetRawSize();
+        m_pRawBuffer = m_pParser->GetRawMemory(m_nRawBufferOffset, m_nRawBufferSize);
+        m_bIsRawBufferLoaded = (NULL != m_pRawBuffer);
     }
 
     return m_pRawBuffer;
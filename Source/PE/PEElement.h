@@ -10,12 +10,26 @@ template <class T>
 class PEElementT :
     public IPEElement
 {
+    struct KeptRawBuffer {
+        void    *m_pBuffer;
+        UINT64  m_nOffset;
+        UINT64  m_nSize;
+    };
+    typedef std::vector<KeptRawBuffer> KeptRawBufferList;
+
 public:
     PEElementT()
-        : m_pFile(NULL), m_pRawBuffer(NULL), m_nRVA(0), m_nVA(0), m_nSizeInMemory(0), m_nFOA(0), m_nSizeInFile(0)
+        : m_pFile(NULL), m_pRawBuffer(NULL), m_bIsRawBufferLoaded(false), m_nRawBufferOffset(0), m_nRawBufferSize(0)
+        , m_nRVA(0), m_nVA(0), m_nSizeInMemory(0), m_nFOA(0), m_nSizeInFile(0)
     {}
 
-    virtual ~PEElementT() {}
+    virtual ~PEElementT();
+
+    // Elements are allocated from the arena of the parser, see PEArena.
+    static void * operator new(size_t nSize) { return PEArena::Allocate(NULL, nSize); }
+    static void * operator new(size_t nSize, PEArena *pArena) { return PEArena::Allocate(pArena, nSize); }
+    static void operator delete(void *pMemory) { PEArena::Free(pMemory); }
+    static void operator delete(void *pMemory, PEArena *pArena) { PEArena::Free(pMemory); }
 
     void InnerSetBase(PEFileT<T> *pFile, PEParserT<T> *pParser)
     {
@@ -23,10 +37,18 @@ public:
         m_pParser = pParser;
     }
 
+    // The buffer is borrowed, so it is never released by this element, and its owner must outlive this element.
     void InnerSetRawMemory(void *pRawBuffer)
     {
         m_pRawBuffer = pRawBuffer;
     }
+
+    // The buffer is got from the parser for this element, such as a list or a name it points to, so it is released
+    // along with the element.
+    void InnerKeepRawMemory(void *pBuffer, UINT64 nOffset, UINT64 nSize);
+
+    // Parse a string which is used as long as this element is alive, so it is released along with the element too.
+    const char * KeepAnsiString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize);
     
     void InnerSetMemoryInfo(PEAddress nRVA, PEAddress nVA, PEAddress nSizeInMemory)
     {
@@ -57,17 +79,37 @@ protected:
     LibPEPtr<PEParserT<T>>  m_pParser;
     PEFileT<T>              *m_pFile;
     void                    *m_pRawBuffer;
+    BOOL                    m_bIsRawBufferLoaded;
+    UINT64                  m_nRawBufferOffset;
+    UINT64                  m_nRawBufferSize;
     PEAddress               m_nRVA;
     PEAddress               m_nVA;
     PEAddress               m_nSizeInMemory;
     PEAddress               m_nFOA;
     PEAddress               m_nSizeInFile;
+    KeptRawBufferList       m_vKeptRawBuffers;
 };
 
 typedef PEElementT<PE32> PEElement32;
 typedef PEElementT<PE64> PEElement64;
 
+// The members of PEElementT<T> are brought into the derived templates, which would not see them otherwise under the
+// two-phase name lookup of the other compilers.
 #define DECLARE_PE_ELEMENT(struct_type)                                                                 \
+    protected:                                                                                          \
+        using PEElementT<T>::m_pParser;                                                                 \
+        using PEElementT<T>::m_pFile;                                                                   \
+        using PEElementT<T>::m_pRawBuffer;                                                              \
+        using PEElementT<T>::m_nRVA;                                                                    \
+        using PEElementT<T>::m_nVA;                                                                     \
+        using PEElementT<T>::m_nSizeInMemory;                                                           \
+        using PEElementT<T>::m_nFOA;                                                                    \
+        using PEElementT<T>::m_nSizeInFile;                                                             \
+                                                                                                        \
+    public:                                                                                             \
+        using PEElementT<T>::InnerKeepRawMemory;                                                        \
+        using PEElementT<T>::KeepAnsiString;                                                            \
+                                                                                                        \
     LIBPE_SINGLE_THREAD_OBJECT()                                                                        \
                                                                                                         \
     virtual void * LIBPE_CALLTYPE GetRawMemory() { return PEElementT<T>::GetRawMemory(); }              \
@@ -33,7 +33,160 @@ template <class T>
 HRESULT
 PEExportTableT<T>::GetFunctionByName(const char *pFunctionName, IPEExportFunction **ppFunction)
 {
-    return E_NOTIMPL;
+    LIBPE_ASSERT_RET(NULL != pFunctionName && NULL != ppFunction, E_POINTER);
+    *ppFunction = NULL;
+
+    LIBPE_ASSERT_RET(NULL != m_pNameOrdinalList, E_FAIL);
+
+    // A few lookups are served by binary search, which needs no extra memory. The tables which are looked up
+    // repeatedly, such as the ones of the system dlls, get a hash index.
+    if(!m_bIsNameIndexBuilt && ++m_nNameLookupCount >= GetPreferredPEExportNameIndexThreshold()) {
+        BuildNameIndex();
+    }
+
+    UINT32 nNameIndex = 0;
+    BOOL bIsFound = m_bIsNameIndexBuilt ? m_oNameIndex.Find(pFunctionName, nNameIndex) : SearchNameIndex(pFunctionName, nNameIndex);
+    if(!bIsFound) {
+        return E_FAIL;
+    }
+
+    UINT32 nFunctionIndex = m_pNameOrdinalList[nNameIndex];
+    if(nFunctionIndex >= GetFunctionCount()) {
+        return E_FAIL;
+    }
+
+    return GetFunctionByIndex(nFunctionIndex, ppFunction);
+}
+
+template <class T>
+HRESULT
+PEExportTableT<T>::GetFunctionByOrdinal(UINT32 nOrdinal, IPEExportFunction **ppFunction)
+{
+    LIBPE_ASSERT_RET(NULL != ppFunction, E_POINTER);
+    *ppFunction = NULL;
+
+    LibPERawExportDirectory(T) *pExportDirectory = GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pExportDirectory && NULL != m_pFunctionList, E_FAIL);
+
+    UINT32 nFunctionIndex = nOrdinal - pExportDirectory->Base;
+    if(nOrdinal < pExportDirectory->Base || nFunctionIndex >= GetFunctionCount()) {
+        return E_INVALIDARG;
+    }
+
+    // The unused slots in the function table are not exported.
+    if(0 == m_pFunctionList[nFunctionIndex]) {
+        return E_FAIL;
+    }
+
+    return GetFunctionByIndex(nFunctionIndex, ppFunction);
+}
+
+template <class T>
+UINT32
+PEExportTableT<T>::GetNameCount()
+{
+    LibPERawExportDirectory(T) *pExportDirectory = GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pExportDirectory, 0);
+    return pExportDirectory->NumberOfNames;
+}
+
+template <class T>
+PEAddress
+PEExportTableT<T>::GetNameRVAByNameIndex(UINT32 nNameIndex)
+{
+    LIBPE_ASSERT_RET(NULL != m_pNameList && nNameIndex < GetNameCount(), 0);
+    return m_pNameList[nNameIndex];
+}
+
+template <class T>
+UINT32
+PEExportTableT<T>::GetNameIndexByFunctionIndex(UINT32 nFunctionIndex)
+{
+    if(!m_bIsFunctionNameIndexBuilt && !BuildFunctionNameIndex()) {
+        return EXPORT_NO_NAME_INDEX;
+    }
+
+    LIBPE_ASSERT_RET(nFunctionIndex < m_vFunctionNameIndexes.size(), EXPORT_NO_NAME_INDEX);
+    return m_vFunctionNameIndexes[nFunctionIndex];
+}
+
+template <class T>
+BOOL
+PEExportTableT<T>::SearchNameIndex(const char *pFunctionName, UINT32 &nNameIndex)
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    // The export name pointer table is sorted, so we can binary search it without creating any function.
+    // Each name is only used for one comparison, so it is given back to the loader right away.
+    UINT32 nBegin = 0, nEnd = GetNameCount();
+    while(nBegin < nEnd) {
+        UINT32 nMiddle = nBegin + (nEnd - nBegin) / 2;
+        PEAddress nNameRVA = GetNameRVAByNameIndex(nMiddle);
+        UINT64 nNameSize = 0;
+        const char *pName = m_pParser->ParseAnsiString(nNameRVA, 0, nNameSize);
+        if(NULL == pName) {
+            return false;
+        }
+
+        int nResult = strcmp(pFunctionName, pName);
+        m_pParser->ReleaseAnsiString(pName, nNameRVA, 0, nNameSize);
+        if(0 == nResult) {
+            nNameIndex = nMiddle;
+            return true;
+        }
+
+        if(nResult < 0) {
+            nEnd = nMiddle;
+        } else {
+            nBegin = nMiddle + 1;
+        }
+    }
+
+    return false;
+}
+
+template <class T>
+BOOL
+PEExportTableT<T>::BuildNameIndex()
+{
+    // The index points to the names, so they are kept as long as the table.
+    UINT32 nNameCount = GetNameCount();
+    m_oNameIndex.Reserve(nNameCount);
+    for(UINT32 nNameIndex = 0; nNameIndex < nNameCount; ++nNameIndex) {
+        UINT64 nNameSize = 0;
+        const char *pName = KeepAnsiString(GetNameRVAByNameIndex(nNameIndex), 0, nNameSize);
+        if(NULL != pName) {
+            m_oNameIndex.Add(pName, nNameIndex);
+        }
+    }
+
+    m_bIsNameIndexBuilt = true;
+
+    return true;
+}
+
+template <class T>
+BOOL
+PEExportTableT<T>::BuildFunctionNameIndex()
+{
+    LIBPE_ASSERT_RET(NULL != m_pNameOrdinalList, false);
+
+    // The name ordinal table maps names to functions, so one pass over it gives the inverse map as well.
+    // When a function has more than one name, the first one is kept, which is also the lowest in order.
+    m_vFunctionNameIndexes.assign(GetFunctionCount(), (UINT32)EXPORT_NO_NAME_INDEX);
+
+    UINT32 nFunctionCount = GetFunctionCount();
+    UINT32 nNameCount = GetNameCount();
+    for(UINT32 nNameIndex = 0; nNameIndex < nNameCount; ++nNameIndex) {
+        UINT32 nFunctionIndex = m_pNameOrdinalList[nNameIndex];
+        if(nFunctionIndex < nFunctionCount && EXPORT_NO_NAME_INDEX == m_vFunctionNameIndexes[nFunctionIndex]) {
+            m_vFunctionNameIndexes[nFunctionIndex] = nNameIndex;
+        }
+    }
+
+    m_bIsFunctionNameIndexBuilt = true;
+
+    return true;
 }
 
 template <class T>
@@ -50,6 +203,27 @@ PEExportFunctionT<T>::GetHint()
     return m_nHint;
 }
 
+template <class T>
+UINT32
+PEExportFunctionT<T>::GetOrdinal()
+{
+    return m_nOrdinal;
+}
+
+template <class T>
+BOOL
+PEExportFunctionT<T>::IsForwarded()
+{
+    return (NULL != m_pForwarder);
+}
+
+template <class T>
+const char *
+PEExportFunctionT<T>::GetForwarder()
+{
+    return m_pForwarder;
+}
+
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEExportTableT);
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEExportFunctionT);
 
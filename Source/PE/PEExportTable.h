@@ -1,9 +1,14 @@
 #pragma once
 
 #include "PE/PEElement.h"
+#include "PE/PENameIndex.h"
 
 LIBPE_NAMESPACE_BEGIN
 
+enum {
+    EXPORT_NO_NAME_INDEX    = 0xFFFFFFFF,
+};
+
 template <class T>
 class PEExportTableT :
     public IPEExportTable,
@@ -12,7 +17,10 @@ class PEExportTableT :
     typedef std::vector<LibPEPtr<IPEExportFunction>> FunctionList;
 
 public:
-    PEExportTableT() : m_pFunctionList(NULL), m_pNameList(NULL), m_pNameOrdinalList(NULL) {}
+    PEExportTableT()
+        : m_pFunctionList(NULL), m_pNameList(NULL), m_pNameOrdinalList(NULL), m_nNameLookupCount(0), m_bIsNameIndexBuilt(false)
+        , m_bIsFunctionNameIndexBuilt(false)
+    {}
     virtual ~PEExportTableT() {}
 
     DECLARE_PE_ELEMENT(LibPERawExportDirectory(T))
@@ -24,6 +32,11 @@ public:
     UINT32 * GetRawFunctionList() { return m_pFunctionList; }
     UINT32 * GetRawNameList() { return m_pNameList; }
     UINT16 * GetRawNameOrdinalList() { return m_pNameOrdinalList; }
+    UINT32 GetNameCount();
+    PEAddress GetNameRVAByNameIndex(UINT32 nNameIndex);
+
+    // Get the index of the name of a function in the name table, or EXPORT_NO_NAME_INDEX if the function has no name.
+    UINT32 GetNameIndexByFunctionIndex(UINT32 nFunctionIndex);
 
     BOOL PrepareForUsing() {
         LibPERawExportDirectory(T) *pExportDirectory = GetRawStruct();
@@ -47,12 +60,23 @@ public:
     virtual UINT32 LIBPE_CALLTYPE GetFunctionCount();
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByIndex(UINT32 nIndex, IPEExportFunction **ppFunction);
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pFunctionName, IPEExportFunction **ppFunction);
+    virtual HRESULT LIBPE_CALLTYPE GetFunctionByOrdinal(UINT32 nOrdinal, IPEExportFunction **ppFunction);
+
+protected:
+    BOOL SearchNameIndex(const char *pFunctionName, UINT32 &nNameIndex);
+    BOOL BuildNameIndex();
+    BOOL BuildFunctionNameIndex();
 
 private:
     FunctionList        m_vExportFunctions;
     UINT32            *m_pFunctionList;
     UINT32            *m_pNameList;
     UINT16            *m_pNameOrdinalList;
+    PENameIndex         m_oNameIndex;
+    UINT32              m_nNameLookupCount;
+    BOOL                m_bIsNameIndexBuilt;
+    std::vector<UINT32> m_vFunctionNameIndexes;
+    BOOL                m_bIsFunctionNameIndexBuilt;
 };
 
 template <class T>
@@ -61,20 +85,27 @@ class PEExportFunctionT :
     public PEElementT<T>
 {
 public:
-    PEExportFunctionT() : m_pName(NULL), m_nHint(0) {}
+    PEExportFunctionT() : m_pName(NULL), m_nHint(0), m_nOrdinal(0), m_pForwarder(NULL) {}
     virtual ~PEExportFunctionT() {}
 
     DECLARE_PE_ELEMENT(void)
 
     void InnerSetName(const char *pName) { m_pName = pName; }
     void InnerSetHint(UINT16 nHint) { m_nHint = nHint; }
+    void InnerSetOrdinal(UINT32 nOrdinal) { m_nOrdinal = nOrdinal; }
+    void InnerSetForwarder(const char *pForwarder) { m_pForwarder = pForwarder; }
 
     virtual const char * LIBPE_CALLTYPE GetName();
     virtual UINT16 LIBPE_CALLTYPE GetHint();
+    virtual UINT32 LIBPE_CALLTYPE GetOrdinal();
+    virtual BOOL LIBPE_CALLTYPE IsForwarded();
+    virtual const char * LIBPE_CALLTYPE GetForwarder();
 
 private:
     const char *    m_pName;
     UINT16          m_nHint;
+    UINT32          m_nOrdinal;
+    const char *    m_pForwarder;
 };
 
 typedef PEExportTableT<PE32> PEExportTable32;
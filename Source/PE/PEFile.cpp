@@ -1,8 +1,15 @@
 #include "stdafx.h"
 #include "PE/PEFile.h"
+#include "PE/PERelocationTable.h"
 
 LIBPE_NAMESPACE_BEGIN
 
+static bool
+IsSectionRangeBefore(const PESectionRange &oLeft, const PESectionRange &oRight)
+{
+    return oLeft.nBegin < oRight.nBegin;
+}
+
 template <class T>
 HRESULT
 PEFileT<T>::Create(DataLoader *pLoader, IPEFile **ppFile)
@@ -33,8 +40,100 @@ PEFileT<T>::PEFileT()
     , m_pFileHeader(NULL)
     , m_pNtHeaders(NULL)
     , m_pOptionalHeader(NULL)
+    , m_nLastRVARangeIndex(0)
+    , m_nLastFOARangeIndex(0)
+{
+
+}
+
+template <class T>
+void
+PEFileT<T>::BuildSectionRangeIndex()
+{
+    m_vRVARanges.clear();
+    m_vFOARanges.clear();
+    m_nLastRVARangeIndex = 0;
+    m_nLastFOARangeIndex = 0;
+
+    // Read the section headers directly. The section objects compute their missing addresses through the
+    // address converters, which are exactly what we are building here.
+    UINT32 nSectionCount = GetSectionCount();
+    m_vRVARanges.reserve(nSectionCount);
+    m_vFOARanges.reserve(nSectionCount);
+    for(UINT32 nSectionIndex = 0; nSectionIndex < nSectionCount; ++nSectionIndex) {
+        LibPERawSectionHeaderT(T) *pRawSectionHeader = (LibPERawSectionHeaderT(T) *)m_vSectionHeaders[nSectionIndex]->GetRawMemory();
+        if(NULL == pRawSectionHeader) {
+            continue;
+        }
+
+        PEAddress nSizeInMemory = (0 != pRawSectionHeader->Misc.VirtualSize) ? pRawSectionHeader->Misc.VirtualSize : pRawSectionHeader->SizeOfRawData;
+
+        PESectionRange oRange;
+        oRange.nBegin = pRawSectionHeader->VirtualAddress;
+        oRange.nEnd = oRange.nBegin + nSizeInMemory;
+        oRange.nTargetBegin = pRawSectionHeader->PointerToRawData;
+        oRange.nSectionIndex = nSectionIndex;
+        m_vRVARanges.push_back(oRange);
+
+        // Sections without raw data, such as .bss, take no space in the file, so no FOA can belong to them.
+        if(0 == pRawSectionHeader->PointerToRawData || 0 == pRawSectionHeader->SizeOfRawData) {
+            continue;
+        }
+
+        oRange.nBegin = pRawSectionHeader->PointerToRawData;
+        oRange.nEnd = oRange.nBegin + pRawSectionHeader->SizeOfRawData;
+        oRange.nTargetBegin = pRawSectionHeader->VirtualAddress;
+        m_vFOARanges.push_back(oRange);
+    }
+
+    std::sort(m_vRVARanges.begin(), m_vRVARanges.end(), IsSectionRangeBefore);
+    std::sort(m_vFOARanges.begin(), m_vFOARanges.end(), IsSectionRangeBefore);
+}
+
+template <class T>
+const PESectionRange *
+PEFileT<T>::FindSectionRange(const SectionRangeList &vRanges, UINT32 &nLastRangeIndex, PEAddress nAddress)
+{
+    UINT32 nRangeCount = (UINT32)vRanges.size();
+    if(0 == nRangeCount || nAddress < vRanges[0].nBegin) {
+        return NULL;
+    }
+
+    // Lookups are usually clustered in the same section, so try the last hit first.
+    if(nLastRangeIndex < nRangeCount) {
+        const PESectionRange &oLastRange = vRanges[nLastRangeIndex];
+        if(oLastRange.nBegin <= nAddress && nAddress < oLastRange.nEnd) {
+            return &oLastRange;
+        }
+    }
+
+    // Find the last range which begins at or before the address.
+    UINT32 nLow = 0, nHigh = nRangeCount;
+    while(nHigh - nLow > 1) {
+        UINT32 nMiddle = nLow + (nHigh - nLow) / 2;
+        if(vRanges[nMiddle].nBegin <= nAddress) {
+            nLow = nMiddle;
+        } else {
+            nHigh = nMiddle;
+        }
+    }
+
+    nLastRangeIndex = nLow;
+
+    return &(vRanges[nLow]);
+}
+
+template <class T>
+HRESULT
+PEFileT<T>::GetSectionByRange(const PESectionRange *pRange, PEAddress nAddress, IPESection **ppSection)
 {
+    LIBPE_ASSERT_RET(NULL != ppSection, E_POINTER);
 
+    if(NULL == pRange || nAddress >= pRange->nEnd) {
+        return E_FAIL;
+    }
+
+    return GetSection(pRange->nSectionIndex, ppSection);
 }
 
 template <class T>
@@ -197,20 +296,7 @@ template <class T>
 HRESULT
 PEFileT<T>::GetSectionByRVA(PEAddress nRVA, IPESection **ppSection)
 {
-    LIBPE_ASSERT_RET(NULL != ppSection, E_POINTER);
-
-    UINT32 nSectionCount = GetSectionCount();
-    for(UINT32 nSectionIndex = 0; nSectionIndex < nSectionCount; ++nSectionIndex) {
-        LibPEPtr<IPESection> pSection;
-        if(SUCCEEDED(GetSection(nSectionIndex, &pSection)) && NULL != pSection) {
-            if(pSection->GetRVA() <= nRVA && nRVA <= pSection->GetRVA() + pSection->GetSizeInMemory()) {
-                *ppSection = pSection.Detach();
-                return S_OK;
-            }
-        }
-    }
-
-    return E_FAIL;
+    return GetSectionByRange(FindSectionRangeByRVA(nRVA), nRVA, ppSection);
 }
 
 template <class T>
@@ -224,20 +310,7 @@ template <class T>
 HRESULT
 PEFileT<T>::GetSectionByFOA(PEAddress nFOA, IPESection **ppSection)
 {
-    LIBPE_ASSERT_RET(NULL != ppSection, E_POINTER);
-
-    UINT32 nSectionCount = GetSectionCount();
-    for(UINT32 nSectionIndex = 0; nSectionIndex < nSectionCount; ++nSectionIndex) {
-        LibPEPtr<IPESection> pSection;
-        if(SUCCEEDED(GetSection(nSectionIndex, &pSection)) && NULL != pSection) {
-            if(pSection->GetFOA() <= nFOA && nFOA <= pSection->GetFOA() + pSection->GetSizeInMemory()) {
-                *ppSection = pSection.Detach();
-                return S_OK;
-            }
-        }
-    }
-
-    return E_FAIL;
+    return GetSectionByRange(FindSectionRangeByFOA(nFOA), nFOA, ppSection);
 }
 
 template <class T>
@@ -381,6 +454,174 @@ PEFileT<T>::GetImportAddressTable(IPEImportAddressTable **ppImportAddressTable)
     return m_pImportAddressTable.CopyTo(ppImportAddressTable);
 }
 
+template <class T>
+HRESULT
+PEFileT<T>::GetBoundImportTable(IPEBoundImportTable **ppBoundImportTable)
+{
+    if(NULL == m_pBoundImportTable) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseBoundImportTable(&m_pBoundImportTable)) || NULL == m_pBoundImportTable) {
+            return E_FAIL;
+        }
+    }
+
+    return m_pBoundImportTable.CopyTo(ppBoundImportTable);
+}
+
+template <class T>
+HRESULT
+PEFileT<T>::GetDelayImportTable(IPEDelayImportTable **ppDelayImportTable)
+{
+    if(NULL == m_pDelayImportTable) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseDelayImportTable(&m_pDelayImportTable)) || NULL == m_pDelayImportTable) {
+            return E_FAIL;
+        }
+    }
+
+    return m_pDelayImportTable.CopyTo(ppDelayImportTable);
+}
+
+template <class T>
+UINT32
+PEFileT<T>::GetModuleImportKinds(const char *pModuleName)
+{
+    LIBPE_ASSERT_RET(NULL != pModuleName, 0);
+
+    UINT32 nImportKinds = 0;
+
+    LibPEPtr<IPEImportTable> pImportTable;
+    LibPEPtr<IPEImportModule> pImportModule;
+    if(SUCCEEDED(GetImportTable(&pImportTable)) && SUCCEEDED(pImportTable->GetModuleByName(pModuleName, &pImportModule))) {
+        nImportKinds |= PE_IMPORT_KIND_NORMAL;
+    }
+
+    LibPEPtr<IPEDelayImportTable> pDelayImportTable;
+    LibPEPtr<IPEDelayImportModule> pDelayImportModule;
+    if(SUCCEEDED(GetDelayImportTable(&pDelayImportTable)) && SUCCEEDED(pDelayImportTable->GetModuleByName(pModuleName, &pDelayImportModule))) {
+        nImportKinds |= PE_IMPORT_KIND_DELAY;
+    }
+
+    LibPEPtr<IPEBoundImportTable> pBoundImportTable;
+    LibPEPtr<IPEBoundImportModule> pBoundImportModule;
+    if(SUCCEEDED(GetBoundImportTable(&pBoundImportTable)) && SUCCEEDED(pBoundImportTable->GetModuleByName(pModuleName, &pBoundImportModule))) {
+        nImportKinds |= PE_IMPORT_KIND_BOUND;
+    }
+
+    return nImportKinds;
+}
+
+template <class T>
+HRESULT
+PEFileT<T>::FindImportedFunction(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppFunction)
+{
+    LIBPE_ASSERT_RET(NULL != pModuleName && NULL != pFunctionName && NULL != ppFunction, E_POINTER);
+    *ppFunction = NULL;
+
+    // The bound import table only lists the modules, so the functions are in the other two tables.
+    LibPEPtr<IPEImportTable> pImportTable;
+    if(SUCCEEDED(GetImportTable(&pImportTable)) && SUCCEEDED(pImportTable->GetFunctionByName(pModuleName, pFunctionName, ppFunction))) {
+        return S_OK;
+    }
+
+    LibPEPtr<IPEDelayImportTable> pDelayImportTable;
+    if(SUCCEEDED(GetDelayImportTable(&pDelayImportTable)) && SUCCEEDED(pDelayImportTable->GetFunctionByName(pModuleName, pFunctionName, ppFunction))) {
+        return S_OK;
+    }
+
+    return E_FAIL;
+}
+
+template <class T>
+HRESULT
+PEFileT<T>::Rebase(PEAddress nNewImageBase, void *pImageBuffer, UINT64 nImageBufferSize)
+{
+    LIBPE_ASSERT_RET(NULL != pImageBuffer, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pParser && NULL != m_pOptionalHeader, E_FAIL);
+
+    LibPERawOptionalHeaderT(T) *pRawOptionalHeader = (LibPERawOptionalHeaderT(T) *)GetRawOptionalHeader();
+    LIBPE_ASSERT_RET(NULL != pRawOptionalHeader, E_FAIL);
+
+    UINT64 nImageSize = pRawOptionalHeader->SizeOfImage;
+    if(nImageBufferSize < nImageSize) {
+        return E_INVALIDARG;
+    }
+
+    // The image is laid out from the data of the loader, so it can't be laid out over that data, such as the buffer
+    // passed to ParsePEFromImageBuffer.
+    if(m_pParser->IsRawDataOverlapped(pImageBuffer, nImageSize)) {
+        return E_INVALIDARG;
+    }
+
+    // Everything needed from the raw headers is read before the image is written.
+    PEAddress nSizeOfHeaders = pRawOptionalHeader->SizeOfHeaders;
+    UINT64 nDelta = nNewImageBase - pRawOptionalHeader->ImageBase;
+
+    UINT8 *pImage = (UINT8 *)pImageBuffer;
+    memset(pImage, 0, (size_t)nImageSize);
+
+    // The headers are at the same offset in the file and in the memory.
+    if(FAILED(CopyImageData(pImage, nImageSize, 0, 0, nSizeOfHeaders))) {
+        return E_FAIL;
+    }
+
+    BOOL bIsRawAddressVA = m_pParser->IsRawAddressVA();
+    UINT32 nSectionCount = GetSectionCount();
+    for(UINT32 nSectionIndex = 0; nSectionIndex < nSectionCount; ++nSectionIndex) {
+        LibPERawSectionHeaderT(T) *pRawSectionHeader = (LibPERawSectionHeaderT(T) *)m_vSectionHeaders[nSectionIndex]->GetRawMemory();
+        if(NULL == pRawSectionHeader) {
+            return E_FAIL;
+        }
+
+        PEAddress nSizeInMemory = (0 != pRawSectionHeader->Misc.VirtualSize) ? pRawSectionHeader->Misc.VirtualSize : pRawSectionHeader->SizeOfRawData;
+        PEAddress nRawOffset = bIsRawAddressVA ? pRawSectionHeader->VirtualAddress : pRawSectionHeader->PointerToRawData;
+        PEAddress nRawSize = bIsRawAddressVA ? nSizeInMemory : pRawSectionHeader->SizeOfRawData;
+        if(nRawSize > nSizeInMemory) {
+            nRawSize = nSizeInMemory;
+        }
+
+        if(FAILED(CopyImageData(pImage, nImageSize, pRawSectionHeader->VirtualAddress, nRawOffset, nRawSize))) {
+            return E_FAIL;
+        }
+    }
+
+    PEAddress nOptionalHeaderOffset = m_pOptionalHeader->GetRawOffset();
+    LIBPE_ASSERT_RET(nOptionalHeaderOffset + sizeof(LibPERawOptionalHeaderT(T)) <= nImageSize, E_FAIL);
+    ((LibPERawOptionalHeaderT(T) *)(pImage + nOptionalHeaderOffset))->ImageBase = (LibPERawAddressT(T))nNewImageBase;
+
+    if(0 == nDelta) {
+        return S_OK;
+    }
+
+    // An image without relocations can only be loaded at its preferred base.
+    LibPEPtr<IPERelocationTable> pRelocationTable;
+    if(FAILED(GetRelocationTable(&pRelocationTable)) || NULL == pRelocationTable) {
+        return E_FAIL;
+    }
+
+    return static_cast<PERelocationTableT<T> *>(pRelocationTable.p)->ApplyRelocations(nDelta, pImage, nImageSize);
+}
+
+template <class T>
+HRESULT
+PEFileT<T>::CopyImageData(UINT8 *pImage, UINT64 nImageSize, PEAddress nRVA, PEAddress nRawOffset, PEAddress nSize)
+{
+    if(nRVA >= nImageSize || 0 == nSize) {
+        return S_OK;
+    }
+
+    if(nSize > nImageSize - nRVA) {
+        nSize = nImageSize - nRVA;
+    }
+
+    // The data is read straight into the image, so a large section doesn't need to fit in the cache of the loader.
+    if(!m_pParser->ReadRawData(nRawOffset, pImage + nRVA, nSize)) {
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEFileT);
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS_FUNCTION(PEFileT, Create);
 
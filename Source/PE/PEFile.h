@@ -4,11 +4,21 @@
 
 LIBPE_NAMESPACE_BEGIN
 
+// One section in one address space (RVA or FOA). nTargetBegin is where the same section begins in the other
+// address space, so an address in [nBegin, nEnd) can be converted with a single add.
+struct PESectionRange {
+    PEAddress   nBegin;
+    PEAddress   nEnd;
+    PEAddress   nTargetBegin;
+    UINT32      nSectionIndex;
+};
+
 template <class T>
 class PEFileT :
     public IPEFile
 {
     typedef std::vector<LibPEPtr<IPESectionHeader>> SectionHeaderList;
+    typedef std::vector<PESectionRange> SectionRangeList;
 
 public:
     static HRESULT Create(DataLoader *pLoader, IPEFile **ppFile);
@@ -32,9 +42,16 @@ public:
         m_pNtHeaders->GetFileHeader(&m_pFileHeader);
         m_pNtHeaders->GetOptionalHeader(&m_pOptionalHeader);
 
+        BuildSectionRangeIndex();
+        pParser->PrefetchDataDirectories();
+
         return S_OK;
     }
 
+    // Section range index, the range returned is the last section which begins at or before the address.
+    const PESectionRange * FindSectionRangeByRVA(PEAddress nRVA) { return FindSectionRange(m_vRVARanges, m_nLastRVARangeIndex, nRVA); }
+    const PESectionRange * FindSectionRangeByFOA(PEAddress nFOA) { return FindSectionRange(m_vFOARanges, m_nLastFOARangeIndex, nFOA); }
+
     // Override IPEFile
     // Raw PE Header
     virtual PERawDosHeader * LIBPE_CALLTYPE GetRawDosHeader();
@@ -86,9 +103,9 @@ public:
     virtual HRESULT LIBPE_CALLTYPE GetDebugInfoTable(IPEDebugInfoTable **ppDebugInfoTable) { return E_NOTIMPL; }
     virtual HRESULT LIBPE_CALLTYPE GetGlobalRegister(IPEGlobalRegister **ppGlobalRegister) { return E_NOTIMPL; }
     virtual HRESULT LIBPE_CALLTYPE GetTlsTable(IPETlsTable **ppTlsTable) { return E_NOTIMPL; }
-    virtual HRESULT LIBPE_CALLTYPE GetBoundImportTable(IPEBoundImportTable **ppBoundImportTable) { return E_NOTIMPL; }
+    virtual HRESULT LIBPE_CALLTYPE GetBoundImportTable(IPEBoundImportTable **ppBoundImportTable);
     virtual HRESULT LIBPE_CALLTYPE GetImportAddressTable(IPEImportAddressTable **ppImportAddressTable);
-    virtual HRESULT LIBPE_CALLTYPE GetDelayImportTable(IPEDelayImportTable **ppDelayImportTable) { return E_NOTIMPL; }
+    virtual HRESULT LIBPE_CALLTYPE GetDelayImportTable(IPEDelayImportTable **ppDelayImportTable);
     virtual HRESULT LIBPE_CALLTYPE GetCLRHeader(IPECLRHeader **ppCLRHeader) { return E_NOTIMPL; }
 
     virtual HRESULT LIBPE_CALLTYPE RemoveExportTable() { return E_NOTIMPL; };
@@ -105,12 +122,25 @@ public:
     virtual HRESULT LIBPE_CALLTYPE RemoveDelayImportTable() { return E_NOTIMPL; };
     virtual HRESULT LIBPE_CALLTYPE RemoveCLRHeader() { return E_NOTIMPL; };
 
+    // Import resolution
+    virtual UINT32 LIBPE_CALLTYPE GetModuleImportKinds(const char *pModuleName);
+    virtual HRESULT LIBPE_CALLTYPE FindImportedFunction(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppFunction);
+
     // PE Verification
     virtual BOOL LIBPE_CALLTYPE ValidatePEHeader() { return true; }
 
     // Rebuild
     virtual HRESULT LIBPE_CALLTYPE Rebuild(const file_char_t *pFilePath) { return S_OK; }
 
+    // Rebase
+    virtual HRESULT LIBPE_CALLTYPE Rebase(PEAddress nNewImageBase, void *pImageBuffer, UINT64 nImageBufferSize);
+
+protected:
+    void BuildSectionRangeIndex();
+    const PESectionRange * FindSectionRange(const SectionRangeList &vRanges, UINT32 &nLastRangeIndex, PEAddress nAddress);
+    HRESULT GetSectionByRange(const PESectionRange *pRange, PEAddress nAddress, IPESection **ppSection);
+    HRESULT CopyImageData(UINT8 *pImage, UINT64 nImageSize, PEAddress nRVA, PEAddress nRawOffset, PEAddress nSize);
+
 private:
     LibPEPtr<PEParserT<T>>                  m_pParser;
     LibPEPtr<IPEDosHeader>                  m_pDosHeader;
@@ -119,11 +149,17 @@ private:
     LibPEPtr<IPEOptionalHeader>             m_pOptionalHeader;
     SectionHeaderList                       m_vSectionHeaders;
     LibPEPtr<IPEOverlay>                    m_pOverlay;
+    SectionRangeList                        m_vRVARanges;
+    SectionRangeList                        m_vFOARanges;
+    UINT32                                  m_nLastRVARangeIndex;
+    UINT32                                  m_nLastFOARangeIndex;
     LibPEPtr<IPEExportTable>                m_pExportTable;
     LibPEPtr<IPEImportTable>                m_pImportTable;
     LibPEPtr<IPEResourceTable>              m_pResourceTable;
     LibPEPtr<IPERelocationTable>            m_pRelocationTable;
     LibPEPtr<IPEImportAddressTable>         m_pImportAddressTable;
+    LibPEPtr<IPEBoundImportTable>           m_pBoundImportTable;
+    LibPEPtr<IPEDelayImportTable>           m_pDelayImportTable;
 };
 
 typedef PEFileT<PE32> PEFile32;
@@ -22,23 +22,36 @@ PEImportAddressTableT<T>::GetBlockByIndex(UINT32 nIndex, IPEImportAddressBlock *
     return m_vBlocks[nIndex].CopyTo(ppBlock);
 }
 
+template <class T>
+HRESULT
+PEImportAddressTableT<T>::GetBlockByRVA(PEAddress nBlockRVA, IPEImportAddressBlock **ppBlock)
+{
+    LIBPE_ASSERT_RET(NULL != ppBlock, E_POINTER);
+    *ppBlock = NULL;
+
+    IPEImportAddressBlock *pBlock = FindBlockByRVA(nBlockRVA);
+    if(NULL == pBlock || pBlock->GetRVA() != nBlockRVA) {
+        return E_FAIL;
+    }
+
+    pBlock->AddRef();
+    *ppBlock = pBlock;
+
+    return S_OK;
+}
+
 template <class T>
 BOOL
 PEImportAddressTableT<T>::IsBlockExists(IPEImportAddressBlock *pBlock)
 {
     LIBPE_ASSERT_RET(NULL != pBlock, false);
 
-    void *pArgRawBlock = pBlock->GetRawMemory();
-    LIBPE_ASSERT_RET(NULL != pArgRawBlock, false);
-
-    BlockList::iterator oBlockIt;
-    for(oBlockIt = m_vBlocks.begin(); oBlockIt != m_vBlocks.end(); ++oBlockIt) {
-        if((*oBlockIt)->GetRawMemory() == pArgRawBlock) {
-            return true;
-        }
-    }
+    // The blocks may also be parsed on their own, e.g. by IPEImportModule::GetRelatedImportAddressBlock, so they are
+    // matched by RVA instead of by object.
+    PEAddress nBlockRVA = pBlock->GetRVA();
+    IPEImportAddressBlock *pFoundBlock = FindBlockByRVA(nBlockRVA);
 
-    return false;
+    return (NULL != pFoundBlock && pFoundBlock->GetRVA() == nBlockRVA);
 }
 
 template <class T>
@@ -47,14 +60,39 @@ PEImportAddressTableT<T>::IsItemExist(IPEImportAddressItem *pItem)
 {
     LIBPE_ASSERT_RET(NULL != pItem, false);
 
-    BlockList::iterator oBlockIt;
-    for(oBlockIt = m_vBlocks.begin(); oBlockIt != m_vBlocks.end(); ++oBlockIt) {
-        if((*oBlockIt)->IsItemExist(pItem)) {
-            return true;
+    IPEImportAddressBlock *pBlock = FindBlockByRVA(pItem->GetRVA());
+    if(NULL == pBlock) {
+        return false;
+    }
+
+    return pBlock->IsItemExist(pItem);
+}
+
+template <class T>
+IPEImportAddressBlock *
+PEImportAddressTableT<T>::FindBlockByRVA(PEAddress nRVA)
+{
+    // The blocks are parsed one after another from the beginning of the IAT, so they are sorted by RVA already.
+    UINT32 nLowIndex = 0, nHighIndex = GetBlockCount();
+    while(nLowIndex < nHighIndex) {
+        UINT32 nMiddleIndex = nLowIndex + (nHighIndex - nLowIndex) / 2;
+        if(nRVA < m_vBlocks[nMiddleIndex]->GetRVA()) {
+            nHighIndex = nMiddleIndex;
+        } else {
+            nLowIndex = nMiddleIndex + 1;
         }
     }
 
-    return false;
+    if(0 == nLowIndex) {
+        return NULL;
+    }
+
+    IPEImportAddressBlock *pBlock = m_vBlocks[nLowIndex - 1];
+    if(nRVA >= pBlock->GetRVA() + pBlock->GetSizeInMemory()) {
+        return NULL;
+    }
+
+    return pBlock;
 }
 
 template <class T>
@@ -82,17 +120,13 @@ PEImportAddressBlockT<T>::IsItemExist(IPEImportAddressItem *pItem)
 {
     LIBPE_ASSERT_RET(NULL != pItem, false);
 
-    void *pArgRawItem = pItem->GetRawMemory();
-    LIBPE_ASSERT_RET(NULL != pArgRawItem, false);
-
-    ItemList::iterator oItemIt;
-    for(oItemIt = m_vItems.begin(); oItemIt != m_vItems.end(); ++oItemIt) {
-        if((*oItemIt)->GetRawMemory() == pArgRawItem) {
-            return true;
-        }
+    // The items are the adjacent slots of the block, so the index of the item follows from its RVA.
+    PEAddress nBlockRVA = GetRVA(), nItemRVA = pItem->GetRVA();
+    if(nItemRVA < nBlockRVA || 0 != (nItemRVA - nBlockRVA) % sizeof(LibPERawThunkData(T))) {
+        return false;
     }
 
-    return false;
+    return ((nItemRVA - nBlockRVA) / sizeof(LibPERawThunkData(T)) < GetItemCount());
 }
 
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEImportAddressTableT);
@@ -22,11 +22,16 @@ public:
         m_vBlocks.push_back(pBlock);
     }
 
+    HRESULT GetBlockByRVA(PEAddress nBlockRVA, IPEImportAddressBlock **ppBlock);
+
     virtual UINT32 LIBPE_CALLTYPE GetBlockCount();
     virtual HRESULT LIBPE_CALLTYPE GetBlockByIndex(UINT32 nIndex, IPEImportAddressBlock **ppBlock);
     virtual BOOL LIBPE_CALLTYPE IsBlockExists(IPEImportAddressBlock *pBlock);
     virtual BOOL LIBPE_CALLTYPE IsItemExist(IPEImportAddressItem *pItem);
 
+protected:
+    IPEImportAddressBlock * FindBlockByRVA(PEAddress nRVA);
+
 private:
     BlockList   m_vBlocks;
 };
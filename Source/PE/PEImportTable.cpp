@@ -1,8 +1,63 @@
 #include "stdafx.h"
 #include "PEImportTable.h"
+#include "PE/PEMD5.h"
+#include "PE/PEImportAddressTable.h"
 
 LIBPE_NAMESPACE_BEGIN
 
+static void
+AppendLowerCaseName(std::vector<char> &vEntry, const char *pName)
+{
+    while(0 != *pName) {
+        char nChar = *pName;
+        vEntry.push_back((nChar >= 'A' && nChar <= 'Z') ? (char)(nChar - 'A' + 'a') : nChar);
+        ++pName;
+    }
+}
+
+static void
+AppendOrdinalName(std::vector<char> &vEntry, UINT16 nOrdinal)
+{
+    char pDigits[8];
+    UINT32 nDigitCount = 0;
+    do {
+        pDigits[nDigitCount++] = (char)('0' + nOrdinal % 10);
+        nOrdinal /= 10;
+    } while(0 != nOrdinal);
+
+    vEntry.push_back('o');
+    vEntry.push_back('r');
+    vEntry.push_back('d');
+    while(nDigitCount > 0) {
+        vEntry.push_back(pDigits[--nDigitCount]);
+    }
+}
+
+static UINT64
+HashImportEntry(const char *pEntry, size_t nEntrySize)
+{
+    // FNV-1a, 64-bit
+    UINT64 nHash = 14695981039346656037ull;
+    for(size_t nIndex = 0; nIndex < nEntrySize; ++nIndex) {
+        nHash ^= (UINT8)pEntry[nIndex];
+        nHash *= 1099511628211ull;
+    }
+
+    return nHash;
+}
+
+static bool
+IsImportAddressRangeBefore(const PEImportAddressRange &oLeft, const PEImportAddressRange &oRight)
+{
+    return oLeft.nBeginRVA < oRight.nBeginRVA;
+}
+
+static bool
+IsRVABeforeImportAddressRange(PEAddress nRVA, const PEImportAddressRange &oRange)
+{
+    return nRVA < oRange.nBeginRVA;
+}
+
 template <class T>
 UINT32
 PEImportTableT<T>::GetModuleCount()
@@ -34,14 +89,387 @@ template <class T>
 HRESULT
 PEImportTableT<T>::GetModuleByName(const char *pModuleName, IPEImportModule **ppImportModule)
 {
-    return E_NOTIMPL;
+    LIBPE_ASSERT_RET(NULL != pModuleName && NULL != ppImportModule, E_POINTER);
+    *ppImportModule = NULL;
+
+    if(!m_bIsModuleNameIndexBuilt && !BuildModuleNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nModuleIndex = 0;
+    if(!m_oModuleNameIndex.Find(pModuleName, nModuleIndex)) {
+        return E_FAIL;
+    }
+
+    return GetModuleByIndex(nModuleIndex, ppImportModule);
 }
 
 template <class T>
 HRESULT
 PEImportTableT<T>::GetFunctionByName(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppImportFunction)
 {
-    return E_NOTIMPL;
+    LIBPE_ASSERT_RET(NULL != pModuleName && NULL != pFunctionName && NULL != ppImportFunction, E_POINTER);
+    *ppImportFunction = NULL;
+
+    if(!m_bIsModuleNameIndexBuilt && !BuildModuleNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nModuleIndex = 0;
+    if(!m_oModuleNameIndex.Find(pModuleName, nModuleIndex)) {
+        return E_FAIL;
+    }
+
+    // A module can be imported by more than one descriptor, so all of them are searched.
+    while(IMPORT_NO_MODULE_INDEX != nModuleIndex) {
+        LibPEPtr<IPEImportModule> pImportModule;
+        if(SUCCEEDED(GetModuleByIndex(nModuleIndex, &pImportModule)) && NULL != pImportModule) {
+            if(SUCCEEDED(pImportModule->GetFunctionByName(pFunctionName, ppImportFunction)) && NULL != *ppImportFunction) {
+                return S_OK;
+            }
+        }
+        nModuleIndex = m_vModules[nModuleIndex].m_nNextSameNameModuleIndex;
+    }
+
+    return E_FAIL;
+}
+
+template <class T>
+HRESULT
+PEImportTableT<T>::ComputeImportHash(PEImportHashType nHashType, UINT8 *pHashBuffer, UINT32 nHashBufferSize)
+{
+    LIBPE_ASSERT_RET(NULL != pHashBuffer, E_POINTER);
+    LIBPE_ASSERT_RET(PE_IMPORT_HASH_MD5 == nHashType || PE_IMPORT_HASH_FNV64 == nHashType, E_INVALIDARG);
+    LIBPE_ASSERT_RET(nHashBufferSize >= ((PE_IMPORT_HASH_MD5 == nHashType) ? (UINT32)PEMD5::DIGEST_SIZE : (UINT32)sizeof(UINT64)), E_INVALIDARG);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+
+    PEMD5 oMD5;
+    UINT64 nSetHash = 0;
+    BOOL bIsFirstEntry = true;
+
+    // The entries are normalized the same way as the imphash: "module.function" in lower case, where the module name
+    // loses its .dll, .ocx or .sys extension and the functions imported by ordinal are named "ord<N>". Each entry is
+    // built in the scratch buffer, whose module part is only written once per module, so no import allocates anything.
+    // The names are copied into the buffer, so they are given back to the loader right away.
+    std::vector<char> vEntry;
+    vEntry.reserve(256);
+
+    typename PEParserT<T>::ThunkDataList vThunks;
+
+    UINT32 nModuleCount = GetModuleCount();
+    for(UINT32 nModuleIndex = 0; nModuleIndex < nModuleCount; ++nModuleIndex) {
+        LibPERawImportDescriptor(T) *pImportDesc = m_vModules[nModuleIndex].m_pImportDesc;
+
+        // A bound module without the lookup table has the addresses in its thunks, so there are no names to hash.
+        if(0 == pImportDesc->OriginalFirstThunk && 0 != pImportDesc->TimeDateStamp) {
+            continue;
+        }
+
+        UINT64 nNameSize = 0;
+        const char *pModuleName = m_pParser->ParseAnsiString(pImportDesc->Name, 0, nNameSize);
+        if(NULL == pModuleName) {
+            continue;
+        }
+
+        vEntry.clear();
+        AppendLowerCaseName(vEntry, pModuleName);
+        m_pParser->ReleaseAnsiString(pModuleName, pImportDesc->Name, 0, nNameSize);
+
+        if(FAILED(m_pParser->ParseImportThunks(pImportDesc, vThunks))) {
+            continue;
+        }
+
+        size_t nModuleNameSize = vEntry.size();
+        if(nModuleNameSize >= 4 && '.' == vEntry[nModuleNameSize - 4]) {
+            const char *pExtension = &vEntry[nModuleNameSize - 3];
+            if(0 == memcmp(pExtension, "dll", 3) || 0 == memcmp(pExtension, "ocx", 3) || 0 == memcmp(pExtension, "sys", 3)) {
+                vEntry.resize(nModuleNameSize - 4);
+            }
+        }
+
+        vEntry.push_back('.');
+        size_t nEntryPrefixSize = vEntry.size();
+
+        UINT32 nThunkCount = (UINT32)vThunks.size();
+        for(UINT32 nThunkIndex = 0; nThunkIndex < nThunkCount; ++nThunkIndex) {
+            LibPERawThunkData(T) *pThunkData = &vThunks[nThunkIndex];
+
+            vEntry.resize(nEntryPrefixSize);
+            if(0 != (pThunkData->u1.Ordinal & PETrait<T>::OrdinalFlag)) {
+                AppendOrdinalName(vEntry, (UINT16)(pThunkData->u1.Ordinal & 0xFFFF));
+            } else {
+                PEAddress nFunctionNameRVA = pThunkData->u1.AddressOfData + sizeof(UINT16);
+                const char *pFunctionName = m_pParser->ParseAnsiString(nFunctionNameRVA, 0, nNameSize);
+                if(NULL == pFunctionName) {
+                    continue;
+                }
+                AppendLowerCaseName(vEntry, pFunctionName);
+                m_pParser->ReleaseAnsiString(pFunctionName, nFunctionNameRVA, 0, nNameSize);
+            }
+
+            if(PE_IMPORT_HASH_MD5 == nHashType) {
+                if(!bIsFirstEntry) {
+                    oMD5.Update(",", 1);
+                }
+                oMD5.Update(&vEntry[0], (UINT32)vEntry.size());
+            } else {
+                nSetHash += HashImportEntry(&vEntry[0], vEntry.size());
+            }
+
+            bIsFirstEntry = false;
+        }
+    }
+
+    if(PE_IMPORT_HASH_MD5 == nHashType) {
+        oMD5.Final(pHashBuffer);
+    } else {
+        for(UINT32 nByteIndex = 0; nByteIndex < sizeof(UINT64); ++nByteIndex) {
+            pHashBuffer[nByteIndex] = (UINT8)(nSetHash >> (nByteIndex * 8));
+        }
+    }
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEImportTableT<T>::Materialize(PEMaterializedImportTable *pMaterializedTable)
+{
+    LIBPE_ASSERT_RET(NULL != pMaterializedTable, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+
+    if(!m_bIsMaterialized) {
+        UINT32 nModuleCount = GetModuleCount();
+        m_vMaterializedModules.reserve(nModuleCount);
+
+        // The names are copied into the string pool, so they are given back to the loader as soon as they are copied.
+        typename PEParserT<T>::ThunkDataList vThunks;
+
+        for(UINT32 nModuleIndex = 0; nModuleIndex < nModuleCount; ++nModuleIndex) {
+            const ModuleInfo &oInfo = m_vModules[nModuleIndex];
+            LibPERawImportDescriptor(T) *pImportDesc = oInfo.m_pImportDesc;
+
+            PEImportModuleEntry oModule;
+            oModule.nImportDescRVA = (UINT32)oInfo.m_nImportDescRVA;
+            oModule.nFirstFunctionIndex = (UINT32)m_vMaterializedFunctions.size();
+            oModule.nFunctionCount = 0;
+
+            UINT64 nNameSize = 0;
+            const char *pModuleName = m_pParser->ParseAnsiString(pImportDesc->Name, 0, nNameSize);
+            oModule.nNameOffset = AddMaterializedName(pModuleName, nNameSize);
+            if(NULL != pModuleName) {
+                m_pParser->ReleaseAnsiString(pModuleName, pImportDesc->Name, 0, nNameSize);
+            }
+
+            // A bound module without the lookup table has the addresses in its thunks, so only the slots are recorded.
+            BOOL bHasAddressThunks = (0 == pImportDesc->OriginalFirstThunk && 0 != pImportDesc->TimeDateStamp);
+
+            // The thunks of one module are read as one array, and only the IMAGE_IMPORT_BY_NAME entries are visited one by one.
+            if(SUCCEEDED(m_pParser->ParseImportThunks(pImportDesc, vThunks))) {
+                UINT32 nThunkCount = (UINT32)vThunks.size();
+                for(UINT32 nThunkIndex = 0; nThunkIndex < nThunkCount; ++nThunkIndex) {
+                    LibPERawThunkData(T) *pThunkData = &vThunks[nThunkIndex];
+
+                    PEImportFunctionEntry oFunction;
+                    oFunction.nNameOffset = PE_IMPORT_NO_NAME;
+                    oFunction.nThunkRVA = (0 != pImportDesc->FirstThunk) ? (UINT32)(pImportDesc->FirstThunk + nThunkIndex * sizeof(LibPERawThunkData(T))) : 0;
+                    oFunction.nHint = 0;
+                    oFunction.nOrdinal = 0;
+
+                    if(bHasAddressThunks) {
+                        m_vMaterializedFunctions.push_back(oFunction);
+                        continue;
+                    }
+
+                    if(0 != (pThunkData->u1.Ordinal & PETrait<T>::OrdinalFlag)) {
+                        oFunction.nOrdinal = (UINT16)(pThunkData->u1.Ordinal & 0xFFFF);
+                    } else {
+                        LibPERawImportByName(T) *pImportByName = m_pParser->ParseImportByName(pThunkData->u1.AddressOfData, nNameSize);
+                        if(NULL != pImportByName) {
+                            oFunction.nHint = pImportByName->Hint;
+                            oFunction.nNameOffset = AddMaterializedName((const char *)pImportByName->Name, nNameSize);
+                            m_pParser->ReleaseImportByName(pImportByName, pThunkData->u1.AddressOfData, nNameSize);
+                        }
+                    }
+
+                    m_vMaterializedFunctions.push_back(oFunction);
+                }
+                oModule.nFunctionCount = nThunkCount;
+            }
+
+            m_vMaterializedModules.push_back(oModule);
+        }
+
+        m_bIsMaterialized = true;
+    }
+
+    pMaterializedTable->pModules = m_vMaterializedModules.empty() ? NULL : &m_vMaterializedModules[0];
+    pMaterializedTable->nModuleCount = (UINT32)m_vMaterializedModules.size();
+    pMaterializedTable->pFunctions = m_vMaterializedFunctions.empty() ? NULL : &m_vMaterializedFunctions[0];
+    pMaterializedTable->nFunctionCount = (UINT32)m_vMaterializedFunctions.size();
+    pMaterializedTable->pStringPool = m_vMaterializedStringPool.empty() ? NULL : &m_vMaterializedStringPool[0];
+    pMaterializedTable->nStringPoolSize = (UINT32)m_vMaterializedStringPool.size();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEImportTableT<T>::ResolveIATSlot(PEAddress nSlotRVA, PEImportSlot *pSlot)
+{
+    LIBPE_ASSERT_RET(NULL != pSlot, E_POINTER);
+
+    pSlot->nModuleIndex = PE_IMPORT_NO_INDEX;
+    pSlot->nFunctionIndex = PE_IMPORT_NO_INDEX;
+
+    const PEImportAddressRange *pRange = FindImportAddressRange(nSlotRVA);
+    if(NULL == pRange) {
+        return E_FAIL;
+    }
+
+    pSlot->nModuleIndex = pRange->nModuleIndex;
+    pSlot->nFunctionIndex = (UINT32)((nSlotRVA - pRange->nBeginRVA) / sizeof(LibPERawThunkData(T)));
+
+    return S_OK;
+}
+
+template <class T>
+UINT32
+PEImportTableT<T>::ResolveIATSlots(const PEAddress *pSlotRVAs, UINT32 nSlotCount, PEImportSlot *pSlots)
+{
+    LIBPE_ASSERT_RET(NULL != pSlotRVAs && NULL != pSlots, 0);
+
+    // The calls through the IAT usually come in runs on the same module, so the last range found is tried first.
+    const PEImportAddressRange *pRange = NULL;
+    UINT32 nResolvedCount = 0;
+    for(UINT32 nSlotIndex = 0; nSlotIndex < nSlotCount; ++nSlotIndex) {
+        PEAddress nSlotRVA = pSlotRVAs[nSlotIndex];
+        if(NULL == pRange || nSlotRVA < pRange->nBeginRVA || nSlotRVA >= pRange->nEndRVA) {
+            const PEImportAddressRange *pFoundRange = FindImportAddressRange(nSlotRVA);
+            if(NULL == pFoundRange) {
+                pSlots[nSlotIndex].nModuleIndex = PE_IMPORT_NO_INDEX;
+                pSlots[nSlotIndex].nFunctionIndex = PE_IMPORT_NO_INDEX;
+                continue;
+            }
+            pRange = pFoundRange;
+        }
+
+        pSlots[nSlotIndex].nModuleIndex = pRange->nModuleIndex;
+        pSlots[nSlotIndex].nFunctionIndex = (UINT32)((nSlotRVA - pRange->nBeginRVA) / sizeof(LibPERawThunkData(T)));
+        ++nResolvedCount;
+    }
+
+    return nResolvedCount;
+}
+
+template <class T>
+UINT32
+PEImportTableT<T>::AddMaterializedName(const char *pName, UINT64 nNameSize)
+{
+    if(NULL == pName || 0 == nNameSize) {
+        return PE_IMPORT_NO_NAME;
+    }
+
+    // The size of the strings from the loaders counts the terminator, so it is copied along with the name.
+    UINT32 nNameOffset = (UINT32)m_vMaterializedStringPool.size();
+    m_vMaterializedStringPool.insert(m_vMaterializedStringPool.end(), pName, pName + nNameSize);
+
+    return nNameOffset;
+}
+
+template <class T>
+BOOL
+PEImportTableT<T>::BuildModuleNameIndex()
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    UINT32 nModuleCount = GetModuleCount();
+    m_oModuleNameIndex.Reserve(nModuleCount);
+
+    // The index keeps the first descriptor of each module, and the other descriptors with the same name are chained to it.
+    // The index points to the names, so they are kept as long as the table.
+    std::vector<UINT32> vLastSameNameModuleIndexes(nModuleCount, (UINT32)IMPORT_NO_MODULE_INDEX);
+    for(UINT32 nModuleIndex = 0; nModuleIndex < nModuleCount; ++nModuleIndex) {
+        UINT64 nNameSize = 0;
+        const char *pName = KeepAnsiString(m_vModules[nModuleIndex].m_pImportDesc->Name, 0, nNameSize);
+        if(NULL == pName) {
+            continue;
+        }
+
+        UINT32 nFirstModuleIndex = 0;
+        if(!m_oModuleNameIndex.Find(pName, nFirstModuleIndex)) {
+            m_oModuleNameIndex.Add(pName, nModuleIndex);
+            vLastSameNameModuleIndexes[nModuleIndex] = nModuleIndex;
+            continue;
+        }
+
+        m_vModules[vLastSameNameModuleIndexes[nFirstModuleIndex]].m_nNextSameNameModuleIndex = nModuleIndex;
+        vLastSameNameModuleIndexes[nFirstModuleIndex] = nModuleIndex;
+    }
+
+    m_bIsModuleNameIndexBuilt = true;
+
+    return true;
+}
+
+template <class T>
+BOOL
+PEImportTableT<T>::BuildImportAddressIndex()
+{
+    if(m_bIsImportAddressIndexBuilt) {
+        return true;
+    }
+
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    // The IAT block of a module has as many slots as its lookup table has thunks, so only the thunks are counted here.
+    UINT32 nModuleCount = GetModuleCount();
+    m_vImportAddressIndex.reserve(nModuleCount);
+    typename PEParserT<T>::ThunkDataList vThunks;
+    for(UINT32 nModuleIndex = 0; nModuleIndex < nModuleCount; ++nModuleIndex) {
+        LibPERawImportDescriptor(T) *pImportDesc = m_vModules[nModuleIndex].m_pImportDesc;
+        if(0 == pImportDesc->FirstThunk) {
+            continue;
+        }
+
+        if(FAILED(m_pParser->ParseImportThunks(pImportDesc, vThunks)) || vThunks.empty()) {
+            continue;
+        }
+
+        PEImportAddressRange oRange;
+        oRange.nBeginRVA = pImportDesc->FirstThunk;
+        oRange.nEndRVA = oRange.nBeginRVA + vThunks.size() * sizeof(LibPERawThunkData(T));
+        oRange.nModuleIndex = nModuleIndex;
+        m_vImportAddressIndex.push_back(oRange);
+    }
+
+    // The IAT blocks are usually laid out in the order of the descriptors, so the stable sort is cheap.
+    std::stable_sort(m_vImportAddressIndex.begin(), m_vImportAddressIndex.end(), IsImportAddressRangeBefore);
+
+    m_bIsImportAddressIndexBuilt = true;
+
+    return true;
+}
+
+template <class T>
+const PEImportAddressRange *
+PEImportTableT<T>::FindImportAddressRange(PEAddress nSlotRVA)
+{
+    if(!BuildImportAddressIndex()) {
+        return NULL;
+    }
+
+    ImportAddressRangeList::iterator itRange = std::upper_bound(m_vImportAddressIndex.begin(), m_vImportAddressIndex.end(), nSlotRVA, IsRVABeforeImportAddressRange);
+    if(itRange == m_vImportAddressIndex.begin()) {
+        return NULL;
+    }
+
+    --itRange;
+    if(nSlotRVA >= itRange->nEndRVA) {
+        return NULL;
+    }
+
+    return &(*itRange);
 }
 
 template <class T>
@@ -65,8 +493,15 @@ PEImportModuleT<T>::GetFunctionByIndex(UINT32 nIndex, IPEImportFunction **ppFunc
 
     FunctionInfo &oInfo = m_vFunctions[nIndex];
     if(NULL == oInfo.m_pFunction) {
-        LIBPE_ASSERT_RET(NULL != m_pParser && NULL != m_pFile && NULL != oInfo.m_pThunkData, E_FAIL);
-        if(FAILED(m_pParser->ParseImportFunction(GetRawStruct(), oInfo.m_pThunkData, &oInfo.m_pFunction)) || NULL == oInfo.m_pFunction) {
+        LIBPE_ASSERT_RET(NULL != m_pParser && NULL != m_pFile, E_FAIL);
+
+        // A bound module without the lookup table has the addresses in its thunks, which must not be read as names.
+        LibPERawImportDescriptor(T) *pImportDesc = GetRawStruct();
+        if(NULL == pImportDesc || (0 == pImportDesc->OriginalFirstThunk && 0 != pImportDesc->TimeDateStamp)) {
+            return E_FAIL;
+        }
+
+        if(FAILED(m_pParser->ParseImportFunction(&oInfo.m_oThunkData, &oInfo.m_pFunction)) || NULL == oInfo.m_pFunction) {
             return E_FAIL;
         }
     }
@@ -78,7 +513,54 @@ template <class T>
 HRESULT
 PEImportModuleT<T>::GetFunctionByName(const char *pFunctionName, IPEImportFunction **ppFunction)
 {
-    return E_NOTIMPL;
+    LIBPE_ASSERT_RET(NULL != pFunctionName && NULL != ppFunction, E_POINTER);
+    *ppFunction = NULL;
+
+    if(!m_bIsFunctionNameIndexBuilt && !BuildFunctionNameIndex()) {
+        return E_FAIL;
+    }
+
+    UINT32 nFunctionIndex = 0;
+    if(!m_oFunctionNameIndex.Find(pFunctionName, nFunctionIndex)) {
+        return E_FAIL;
+    }
+
+    return GetFunctionByIndex(nFunctionIndex, ppFunction);
+}
+
+template <class T>
+BOOL
+PEImportModuleT<T>::BuildFunctionNameIndex()
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    LibPERawImportDescriptor(T) *pImportDesc = GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pImportDesc, false);
+
+    // A bound module without the lookup table has the addresses in its thunks, so there are no names left to index.
+    m_bIsFunctionNameIndexBuilt = true;
+    if(0 == pImportDesc->OriginalFirstThunk && 0 != pImportDesc->TimeDateStamp) {
+        return true;
+    }
+
+    // The names are read from the thunks directly, so no function object is created for the entries which do not match.
+    // The index points to the names, so they are kept as long as the module.
+    UINT32 nFunctionCount = GetFunctionCount();
+    m_oFunctionNameIndex.Reserve(nFunctionCount);
+    for(UINT32 nFunctionIndex = 0; nFunctionIndex < nFunctionCount; ++nFunctionIndex) {
+        LibPERawThunkData(T) *pThunkData = &m_vFunctions[nFunctionIndex].m_oThunkData;
+        if(0 != (pThunkData->u1.Ordinal & PETrait<T>::OrdinalFlag)) {
+            continue;
+        }
+
+        UINT64 nNameSize = 0;
+        const char *pName = KeepAnsiString(pThunkData->u1.AddressOfData + sizeof(UINT16), 0, nNameSize);
+        if(NULL != pName) {
+            m_oFunctionNameIndex.Add(pName, nFunctionIndex);
+        }
+    }
+
+    return true;
 }
 
 template <class T>
@@ -89,13 +571,19 @@ PEImportModuleT<T>::GetRelatedImportAddressBlock(IPEImportAddressBlock **ppBlock
 
     // However, we should parse the related IAT block here. Very useful for bounded module.
     if(NULL == m_pRelatedIABlock) {
-        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        LIBPE_ASSERT_RET(NULL != m_pParser && NULL != m_pFile, E_FAIL);
 
         LibPERawImportDescriptor(T) *pImportDescriptor = GetRawStruct();
         LIBPE_ASSERT_RET(NULL != pImportDescriptor, E_FAIL);
 
+        // The block is shared with the IAT when the IAT directory covers it, and is only parsed on its own otherwise.
         PEAddress nImportAddressBlockRVA = pImportDescriptor->FirstThunk;
-        if(0 != nImportAddressBlockRVA) {
+        LibPEPtr<IPEImportAddressTable> pImportAddressTable;
+        if(0 != nImportAddressBlockRVA && SUCCEEDED(m_pFile->GetImportAddressTable(&pImportAddressTable)) && NULL != pImportAddressTable) {
+            static_cast<PEImportAddressTableT<T> *>((IPEImportAddressTable *)pImportAddressTable)->GetBlockByRVA(nImportAddressBlockRVA, &m_pRelatedIABlock);
+        }
+
+        if(0 != nImportAddressBlockRVA && NULL == m_pRelatedIABlock) {
             PEAddress nImportAddressBlockFOA = m_pParser->GetFOAFromRVA(nImportAddressBlockRVA);
             if(FAILED(m_pParser->ParseImportAddressBlock(NULL, nImportAddressBlockRVA, nImportAddressBlockFOA, &m_pRelatedIABlock)) || NULL == m_pRelatedIABlock) {
                 return E_FAIL;
@@ -106,17 +594,34 @@ PEImportModuleT<T>::GetRelatedImportAddressBlock(IPEImportAddressBlock **ppBlock
     return m_pRelatedIABlock.CopyTo(ppBlock);
 }
 
+template <class T>
+UINT16
+PEImportFunctionT<T>::GetFieldHint()
+{
+    if(m_bIsByOrdinal) {
+        return 0;
+    }
+
+    LibPERawImportByName(T) *pImportByName = GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pImportByName, 0);
+    return pImportByName->Hint;
+}
+
 template <class T>
 LibPERawThunkData(T) *  
 PEImportFunctionT<T>::GetRawThunkData()
 {
-    return m_pThunkData;
+    return &m_oThunkData;
 }
 
 template <class T>
 const char *  
 PEImportFunctionT<T>::GetName()
 {
+    if(m_bIsByOrdinal) {
+        return NULL;
+    }
+
     LibPERawImportByName(T) *pImportByName = GetRawStruct();
     LIBPE_ASSERT_RET(NULL != pImportByName, 0);
     return (const char *)pImportByName->Name;
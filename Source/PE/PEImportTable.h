@@ -1,9 +1,21 @@
 #pragma once
 
 #include "PE/PEElement.h"
+#include "PE/PENameIndex.h"
 
 LIBPE_NAMESPACE_BEGIN
 
+enum {
+    IMPORT_NO_MODULE_INDEX  = 0xFFFFFFFF,
+};
+
+// The RVA range of the IAT block of one module, not counting the terminating thunk.
+struct PEImportAddressRange {
+    PEAddress   nBeginRVA;
+    PEAddress   nEndRVA;
+    UINT32      nModuleIndex;
+};
+
 template <class T>
 class PEImportTableT :
     public IPEImportTable,
@@ -13,12 +25,14 @@ class PEImportTableT :
         PEAddress                       m_nImportDescRVA;
         PEAddress                       m_nImportDescFOA;
         LibPERawImportDescriptor(T)     *m_pImportDesc;
+        UINT32                          m_nNextSameNameModuleIndex;
         LibPEPtr<IPEImportModule>       m_pImportModule;
     };
     typedef std::vector<ModuleInfo> ModuleList;
+    typedef std::vector<PEImportAddressRange> ImportAddressRangeList;
 
 public:
-    PEImportTableT() {}
+    PEImportTableT() : m_oModuleNameIndex(true), m_bIsModuleNameIndexBuilt(false), m_bIsMaterialized(false), m_bIsImportAddressIndexBuilt(false) {}
     virtual ~PEImportTableT() {}
 
     DECLARE_PE_ELEMENT(LibPERawImportDescriptor(T))
@@ -29,6 +43,7 @@ public:
         oInfo.m_nImportDescRVA = nImportDescRVA;
         oInfo.m_nImportDescFOA = nImportDescFOA;
         oInfo.m_pImportDesc = pImportDesc;
+        oInfo.m_nNextSameNameModuleIndex = IMPORT_NO_MODULE_INDEX;
         m_vModules.push_back(oInfo);
         return;
     }
@@ -37,9 +52,27 @@ public:
     virtual HRESULT LIBPE_CALLTYPE GetModuleByIndex(UINT32 nModuleId, IPEImportModule **ppImportModule);
     virtual HRESULT LIBPE_CALLTYPE GetModuleByName(const char *pModuleName, IPEImportModule **ppImportModule);
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pModuleName, const char *pFunctionName, IPEImportFunction **ppImportFunction);
+    virtual HRESULT LIBPE_CALLTYPE ComputeImportHash(PEImportHashType nHashType, UINT8 *pHashBuffer, UINT32 nHashBufferSize);
+    virtual HRESULT LIBPE_CALLTYPE Materialize(PEMaterializedImportTable *pMaterializedTable);
+    virtual HRESULT LIBPE_CALLTYPE ResolveIATSlot(PEAddress nSlotRVA, PEImportSlot *pSlot);
+    virtual UINT32 LIBPE_CALLTYPE ResolveIATSlots(const PEAddress *pSlotRVAs, UINT32 nSlotCount, PEImportSlot *pSlots);
+
+protected:
+    BOOL BuildModuleNameIndex();
+    UINT32 AddMaterializedName(const char *pName, UINT64 nNameSize);
+    BOOL BuildImportAddressIndex();
+    const PEImportAddressRange * FindImportAddressRange(PEAddress nSlotRVA);
 
 private:
-    ModuleList m_vModules;
+    ModuleList                          m_vModules;
+    PENameIndex                         m_oModuleNameIndex;
+    BOOL                                m_bIsModuleNameIndexBuilt;
+    std::vector<PEImportModuleEntry>    m_vMaterializedModules;
+    std::vector<PEImportFunctionEntry>  m_vMaterializedFunctions;
+    std::vector<char>                   m_vMaterializedStringPool;
+    BOOL                                m_bIsMaterialized;
+    ImportAddressRangeList              m_vImportAddressIndex;
+    BOOL                                m_bIsImportAddressIndexBuilt;
 };
 
 template <class T>
@@ -47,21 +80,22 @@ class PEImportModuleT :
     public IPEImportModule,
     public PEElementT<T>
 {
+    // The thunks are copied, so the module doesn't keep any buffer of the loader for them.
     struct FunctionInfo {
-        LibPERawThunkData(T)            *m_pThunkData;
+        LibPERawThunkData(T)            m_oThunkData;
         LibPEPtr<IPEImportFunction> m_pFunction;
     };
     typedef std::vector<FunctionInfo> FunctionList;
 
 public:
-    PEImportModuleT() {}
+    PEImportModuleT() : m_pName(NULL), m_bIsFunctionNameIndexBuilt(false) {}
     virtual ~PEImportModuleT() {}
 
     DECLARE_PE_ELEMENT(LibPERawImportDescriptor(T))
 
-    void AddImportFunctionThunk(LibPERawThunkData(T) *pThunk) {
+    void AddImportFunctionThunk(const LibPERawThunkData(T) &oThunk) {
         FunctionInfo oInfo;
-        oInfo.m_pThunkData = pThunk;
+        oInfo.m_oThunkData = oThunk;
         m_vFunctions.push_back(oInfo);
     }
 
@@ -81,9 +115,14 @@ public:
     virtual HRESULT LIBPE_CALLTYPE GetFunctionByName(const char *pFunctionName, IPEImportFunction **ppFunction);
     virtual HRESULT LIBPE_CALLTYPE GetRelatedImportAddressBlock(IPEImportAddressBlock **ppBlock);
 
+protected:
+    BOOL BuildFunctionNameIndex();
+
 private:
     const char                          *m_pName;
     FunctionList                        m_vFunctions;
+    PENameIndex                         m_oFunctionNameIndex;
+    BOOL                                m_bIsFunctionNameIndexBuilt;
     LibPEPtr<IPEImportAddressBlock>     m_pRelatedIABlock;
 };
 
@@ -93,22 +132,26 @@ class PEImportFunctionT :
     public PEElementT<T>
 {
 public:
-    PEImportFunctionT() : m_pThunkData(NULL) {}
+    PEImportFunctionT() : m_nOrdinal(0), m_bIsByOrdinal(false) { memset(&m_oThunkData, 0, sizeof(m_oThunkData)); }
     virtual ~PEImportFunctionT() {}
 
     DECLARE_PE_ELEMENT(LibPERawImportByName(T))
 
-    void InnerSetThunkData(LibPERawThunkData(T) *pThunkData) { m_pThunkData = pThunkData; }
-    void InnerSetOrdinal(UINT16 nOrdinal) { m_nOrdinal = nOrdinal; }
+    void InnerSetThunkData(const LibPERawThunkData(T) *pThunkData) { m_oThunkData = *pThunkData; }
+    void InnerSetOrdinal(UINT16 nOrdinal) { m_nOrdinal = nOrdinal; m_bIsByOrdinal = true; }
 
-    LIBPE_FIELD_ACCESSOR(UINT16, Hint)
+    virtual UINT16 LIBPE_CALLTYPE GetFieldHint();
 
     virtual LibPERawThunkData(T) * LIBPE_CALLTYPE GetRawThunkData();
+    virtual BOOL LIBPE_CALLTYPE IsByOrdinal() { return m_bIsByOrdinal; }
+    virtual UINT16 LIBPE_CALLTYPE GetOrdinal() { return m_nOrdinal; }
     virtual const char * LIBPE_CALLTYPE GetName();
     virtual PEAddress LIBPE_CALLTYPE GetEntry();
 
 private:
-    LibPERawThunkData(T) *m_pThunkData;
+    LibPERawThunkData(T)    m_oThunkData;
+    UINT16                  m_nOrdinal;
+    BOOL                    m_bIsByOrdinal;
 };
 
 typedef PEImportTableT<PE32> PEImportTable32;
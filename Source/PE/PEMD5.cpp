@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include "PE/PEMD5.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+static const UINT32 s_pMD5Constants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const UINT8 s_pMD5Shifts[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+void
+PEMD5::Reset()
+{
+    m_pState[0] = 0x67452301;
+    m_pState[1] = 0xefcdab89;
+    m_pState[2] = 0x98badcfe;
+    m_pState[3] = 0x10325476;
+    m_nTotalSize = 0;
+}
+
+void
+PEMD5::Update(const void *pData, UINT32 nSize)
+{
+    const UINT8 *pInput = (const UINT8 *)pData;
+    UINT32 nBufferedSize = (UINT32)(m_nTotalSize & 63);
+    m_nTotalSize += nSize;
+
+    if(0 != nBufferedSize) {
+        UINT32 nCopySize = 64 - nBufferedSize;
+        if(nCopySize > nSize) {
+            nCopySize = nSize;
+        }
+
+        memcpy(m_pBuffer + nBufferedSize, pInput, nCopySize);
+        pInput += nCopySize;
+        nSize -= nCopySize;
+        if(nBufferedSize + nCopySize < 64) {
+            return;
+        }
+
+        Transform(m_pBuffer);
+    }
+
+    while(nSize >= 64) {
+        Transform(pInput);
+        pInput += 64;
+        nSize -= 64;
+    }
+
+    if(0 != nSize) {
+        memcpy(m_pBuffer, pInput, nSize);
+    }
+}
+
+void
+PEMD5::Final(UINT8 pDigest[DIGEST_SIZE])
+{
+    UINT64 nTotalBits = m_nTotalSize * 8;
+
+    static const UINT8 s_pPadding[64] = { 0x80 };
+    UINT32 nBufferedSize = (UINT32)(m_nTotalSize & 63);
+    Update(s_pPadding, (nBufferedSize < 56) ? (56 - nBufferedSize) : (120 - nBufferedSize));
+
+    UINT8 pSizeBytes[8];
+    for(UINT32 nByteIndex = 0; nByteIndex < 8; ++nByteIndex) {
+        pSizeBytes[nByteIndex] = (UINT8)(nTotalBits >> (nByteIndex * 8));
+    }
+    Update(pSizeBytes, 8);
+
+    for(UINT32 nByteIndex = 0; nByteIndex < DIGEST_SIZE; ++nByteIndex) {
+        pDigest[nByteIndex] = (UINT8)(m_pState[nByteIndex / 4] >> ((nByteIndex % 4) * 8));
+    }
+
+    Reset();
+}
+
+void
+PEMD5::Transform(const UINT8 *pBlock)
+{
+    UINT32 pWords[16];
+    for(UINT32 nWordIndex = 0; nWordIndex < 16; ++nWordIndex) {
+        const UINT8 *pWord = pBlock + nWordIndex * 4;
+        pWords[nWordIndex] = (UINT32)pWord[0] | ((UINT32)pWord[1] << 8) | ((UINT32)pWord[2] << 16) | ((UINT32)pWord[3] << 24);
+    }
+
+    UINT32 a = m_pState[0], b = m_pState[1], c = m_pState[2], d = m_pState[3];
+    for(UINT32 nStep = 0; nStep < 64; ++nStep) {
+        UINT32 f = 0, g = 0;
+        switch(nStep / 16) {
+        case 0:
+            f = (b & c) | (~b & d);
+            g = nStep;
+            break;
+        case 1:
+            f = (d & b) | (~d & c);
+            g = (5 * nStep + 1) % 16;
+            break;
+        case 2:
+            f = b ^ c ^ d;
+            g = (3 * nStep + 5) % 16;
+            break;
+        default:
+            f = c ^ (b | ~d);
+            g = (7 * nStep) % 16;
+            break;
+        }
+
+        UINT32 nTemp = d;
+        d = c;
+        c = b;
+        UINT32 nSum = a + f + s_pMD5Constants[nStep] + pWords[g];
+        b = b + ((nSum << s_pMD5Shifts[nStep]) | (nSum >> (32 - s_pMD5Shifts[nStep])));
+        a = nTemp;
+    }
+
+    m_pState[0] += a;
+    m_pState[1] += b;
+    m_pState[2] += c;
+    m_pState[3] += d;
+}
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
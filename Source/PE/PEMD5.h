@@ -0,0 +1,30 @@
+#pragma once
+
+LIBPE_NAMESPACE_BEGIN
+
+// PEMD5 is an incremental MD5 (RFC 1321), so the data can be fed in pieces without being copied into one buffer.
+class PEMD5
+{
+public:
+    enum {
+        DIGEST_SIZE = 16,
+    };
+
+public:
+    PEMD5() { Reset(); }
+    ~PEMD5() {}
+
+    void Reset();
+    void Update(const void *pData, UINT32 nSize);
+    void Final(UINT8 pDigest[DIGEST_SIZE]);
+
+protected:
+    void Transform(const UINT8 *pBlock);
+
+private:
+    UINT32  m_pState[4];
+    UINT64  m_nTotalSize;
+    UINT8   m_pBuffer[64];
+};
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include "PE/PENameIndex.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+enum {
+    NAME_INDEX_MIN_SLOT_COUNT   = 16,
+};
+
+static inline UINT8
+FoldNameChar(UINT8 nChar, BOOL bIgnoreCase)
+{
+    return (bIgnoreCase && nChar >= 'A' && nChar <= 'Z') ? (UINT8)(nChar - 'A' + 'a') : nChar;
+}
+
+UINT32
+PENameIndex::HashName(const char *pName, BOOL bIgnoreCase)
+{
+    // FNV-1a
+    UINT32 nHash = 2166136261u;
+    while(0 != *pName) {
+        nHash ^= FoldNameChar((UINT8)*pName, bIgnoreCase);
+        nHash *= 16777619u;
+        ++pName;
+    }
+
+    return nHash;
+}
+
+BOOL
+PENameIndex::IsSameName(const char *pName1, const char *pName2, BOOL bIgnoreCase)
+{
+    if(!bIgnoreCase) {
+        return (0 == strcmp(pName1, pName2));
+    }
+
+    while(0 != *pName1 && FoldNameChar((UINT8)*pName1, true) == FoldNameChar((UINT8)*pName2, true)) {
+        ++pName1;
+        ++pName2;
+    }
+
+    return (FoldNameChar((UINT8)*pName1, true) == FoldNameChar((UINT8)*pName2, true));
+}
+
+void
+PENameIndex::Reserve(UINT32 nCount)
+{
+    // Keep the load factor at or below 1/2, so the probe sequences stay short.
+    UINT32 nSlotCount = NAME_INDEX_MIN_SLOT_COUNT;
+    while(nSlotCount < nCount * 2) {
+        nSlotCount *= 2;
+    }
+
+    if(nSlotCount <= m_vSlots.size()) {
+        return;
+    }
+
+    std::vector<Slot> vOldSlots;
+    vOldSlots.swap(m_vSlots);
+
+    Slot oEmptySlot = { NULL, 0, 0 };
+    m_vSlots.resize(nSlotCount, oEmptySlot);
+    m_nCount = 0;
+
+    std::vector<Slot>::iterator itSlot = vOldSlots.begin();
+    while(itSlot != vOldSlots.end()) {
+        if(NULL != itSlot->pName) {
+            Add(itSlot->pName, itSlot->nValue);
+        }
+        ++itSlot;
+    }
+}
+
+void
+PENameIndex::Clear()
+{
+    m_vSlots.clear();
+    m_nCount = 0;
+}
+
+void
+PENameIndex::Add(const char *pName, UINT32 nValue)
+{
+    LIBPE_ASSERT_RET_VOID(NULL != pName);
+
+    if((m_nCount + 1) * 2 > m_vSlots.size()) {
+        Grow();
+    }
+
+    UINT32 nHash = HashName(pName, m_bIgnoreCase);
+    UINT32 nMask = (UINT32)m_vSlots.size() - 1;
+    UINT32 nSlotIndex = nHash & nMask;
+    while(NULL != m_vSlots[nSlotIndex].pName) {
+        if(m_vSlots[nSlotIndex].nHash == nHash && IsSameName(m_vSlots[nSlotIndex].pName, pName, m_bIgnoreCase)) {
+            return;
+        }
+        nSlotIndex = (nSlotIndex + 1) & nMask;
+    }
+
+    m_vSlots[nSlotIndex].pName = pName;
+    m_vSlots[nSlotIndex].nHash = nHash;
+    m_vSlots[nSlotIndex].nValue = nValue;
+    ++m_nCount;
+}
+
+BOOL
+PENameIndex::Find(const char *pName, UINT32 &nValue) const
+{
+    LIBPE_ASSERT_RET(NULL != pName, false);
+
+    if(0 == m_nCount) {
+        return false;
+    }
+
+    UINT32 nHash = HashName(pName, m_bIgnoreCase);
+    UINT32 nMask = (UINT32)m_vSlots.size() - 1;
+    UINT32 nSlotIndex = nHash & nMask;
+    while(NULL != m_vSlots[nSlotIndex].pName) {
+        if(m_vSlots[nSlotIndex].nHash == nHash && IsSameName(m_vSlots[nSlotIndex].pName, pName, m_bIgnoreCase)) {
+            nValue = m_vSlots[nSlotIndex].nValue;
+            return true;
+        }
+        nSlotIndex = (nSlotIndex + 1) & nMask;
+    }
+
+    return false;
+}
+
+void
+PENameIndex::Grow()
+{
+    Reserve((m_nCount + 1) * 2);
+}
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+LIBPE_NAMESPACE_BEGIN
+
+// PENameIndex is an open addressing hash table from names to UINT32 values, such as the indexes in a name table.
+// The names are not copied, so they must live as long as the index, which is true for the strings in the loaders.
+// An index which ignores case folds ASCII letters only, the same way the loader compares module names.
+class PENameIndex
+{
+public:
+    static UINT32 HashName(const char *pName, BOOL bIgnoreCase = false);
+    static BOOL IsSameName(const char *pName1, const char *pName2, BOOL bIgnoreCase = false);
+
+public:
+    explicit PENameIndex(BOOL bIgnoreCase = false) : m_bIgnoreCase(bIgnoreCase), m_nCount(0) {}
+    ~PENameIndex() {}
+
+    void Reserve(UINT32 nCount);
+    void Clear();
+
+    // The value of the first added name is kept when a name is added more than once.
+    void Add(const char *pName, UINT32 nValue);
+    BOOL Find(const char *pName, UINT32 &nValue) const;
+
+    UINT32 GetCount() const { return m_nCount; }
+
+protected:
+    void Grow();
+
+private:
+    struct Slot {
+        const char  *pName;
+        UINT32      nHash;
+        UINT32      nValue;
+    };
+
+    std::vector<Slot>   m_vSlots;
+    BOOL                m_bIgnoreCase;
+    UINT32              m_nCount;
+};
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -1,8 +1,68 @@
 #include "stdafx.h"
 #include "PERelocationTable.h"
 
+#ifdef LIBPE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 LIBPE_NAMESPACE_BEGIN
 
+// Add nDelta to nCount adjacent 32-bit slots.
+static void
+AddDeltaToSlots32(UINT8 *pSlot, UINT32 nCount, UINT32 nDelta)
+{
+#ifdef LIBPE_USE_SSE2
+    const __m128i oDelta = _mm_set1_epi32((int)nDelta);
+    for(; nCount >= 4; nCount -= 4, pSlot += 4 * sizeof(UINT32)) {
+        _mm_storeu_si128((__m128i *)pSlot, _mm_add_epi32(_mm_loadu_si128((const __m128i *)pSlot), oDelta));
+    }
+#endif
+
+    for(; nCount > 0; --nCount, pSlot += sizeof(UINT32)) {
+        UINT32 nValue = 0;
+        memcpy(&nValue, pSlot, sizeof(UINT32));
+        nValue += nDelta;
+        memcpy(pSlot, &nValue, sizeof(UINT32));
+    }
+}
+
+// Add nDelta to nCount adjacent 64-bit slots.
+static void
+AddDeltaToSlots64(UINT8 *pSlot, UINT32 nCount, UINT64 nDelta)
+{
+#ifdef LIBPE_USE_SSE2
+    const __m128i oDelta = _mm_set_epi32((int)(nDelta >> 32), (int)nDelta, (int)(nDelta >> 32), (int)nDelta);
+    for(; nCount >= 2; nCount -= 2, pSlot += 2 * sizeof(UINT64)) {
+        _mm_storeu_si128((__m128i *)pSlot, _mm_add_epi64(_mm_loadu_si128((const __m128i *)pSlot), oDelta));
+    }
+#endif
+
+    for(; nCount > 0; --nCount, pSlot += sizeof(UINT64)) {
+        UINT64 nValue = 0;
+        memcpy(&nValue, pSlot, sizeof(UINT64));
+        nValue += nDelta;
+        memcpy(pSlot, &nValue, sizeof(UINT64));
+    }
+}
+
+static bool
+IsItemIndexBeforeBlock(UINT32 nItemIndex, const PERelocationBlock &oBlock)
+{
+    return nItemIndex < oBlock.nFirstItemIndex;
+}
+
+static bool
+IsIndexEntryBefore(const PERelocationIndexEntry &oLeft, const PERelocationIndexEntry &oRight)
+{
+    return oLeft.nRVA < oRight.nRVA;
+}
+
+static bool
+IsIndexEntryBeforeRVA(const PERelocationIndexEntry &oEntry, PEAddress nRVA)
+{
+    return oEntry.nRVA < nRVA;
+}
+
 template <class T>
 UINT32
 PERelocationTableT<T>::GetPageCount()
@@ -19,15 +79,55 @@ PERelocationTableT<T>::GetPageByIndex(UINT32 nIndex, IPERelocationPage **ppReloc
     UINT32 nPageCount = GetPageCount();
     LIBPE_ASSERT_RET(nIndex < nPageCount, E_FAIL);
 
+    if(NULL == m_vPages[nIndex]) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseRelocationPage(this, nIndex, &m_vPages[nIndex])) || NULL == m_vPages[nIndex]) {
+            return E_FAIL;
+        }
+    }
+
     return m_vPages[nIndex].CopyTo(ppRelocationPage);
 }
 
+template <class T>
+UINT32
+PERelocationTableT<T>::GetItemCount()
+{
+    return m_nItemCount;
+}
+
+template <class T>
+UINT32
+PERelocationTableT<T>::GetItems(UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount)
+{
+    LIBPE_ASSERT_RET(NULL != pEntries, 0);
+
+    if(nStartIndex >= m_nItemCount) {
+        return 0;
+    }
+
+    UINT8 *pRawTable = (UINT8 *)GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pRawTable, 0);
+
+    // Find the block which holds the start item, then decode the blocks one by one from there.
+    typename RelocationBlockList::iterator itBlock = FindBlockByItemIndex(nStartIndex);
+
+    UINT32 nFilledCount = 0;
+    while(itBlock != m_vBlocks.end() && nFilledCount < nMaxCount) {
+        LibPERawBaseRelocation(T) *pRawBlock = (LibPERawBaseRelocation(T) *)(pRawTable + itBlock->nOffset);
+        UINT32 nItemIndex = (nStartIndex > itBlock->nFirstItemIndex) ? (nStartIndex - itBlock->nFirstItemIndex) : 0;
+        nFilledCount += PERelocationPageT<T>::DecodeItems(pRawBlock, itBlock->nItemCount, nItemIndex, pEntries + nFilledCount, nMaxCount - nFilledCount);
+        ++itBlock;
+    }
+
+    return nFilledCount;
+}
+
 template <class T>
 BOOL
 PERelocationTableT<T>::IsRVANeedRelocation(PEAddress nRVA)
 {
-    LibPEPtr<IPERelocationItem> pItem;
-    return ((SUCCEEDED(GetItemByRVA(nRVA, &pItem))) && NULL != pItem);
+    return (NULL != FindIndexEntry(nRVA));
 }
 
 template <class T>
@@ -37,17 +137,248 @@ PERelocationTableT<T>::GetItemByRVA(PEAddress nRVA, IPERelocationItem **ppReloca
     LIBPE_ASSERT_RET(NULL != ppRelocationItem, E_POINTER);
     *ppRelocationItem = NULL;
 
-    UINT32 nPageCount = GetPageCount();
-    for(UINT32 nPageIndex = 0; nPageIndex < nPageCount; ++nPageIndex) {
-        switch(m_vPages[nPageIndex]->GetItemByRVA(nRVA, ppRelocationItem)) {
-        case S_OK:
-            return S_OK;
-        case E_INVALIDARG:
-            return E_INVALIDARG;
+    const PERelocationIndexEntry *pIndexEntry = FindIndexEntry(nRVA);
+    if(NULL == pIndexEntry) {
+        return E_FAIL;
+    }
+
+    typename RelocationBlockList::iterator itBlock = FindBlockByItemIndex(pIndexEntry->nItemIndex);
+    UINT32 nBlockIndex = (UINT32)(itBlock - m_vBlocks.begin());
+
+    LibPEPtr<IPERelocationPage> pPage;
+    if(FAILED(GetPageByIndex(nBlockIndex, &pPage)) || NULL == pPage) {
+        return E_FAIL;
+    }
+
+    return pPage->GetItemByIndex(pIndexEntry->nItemIndex - itBlock->nFirstItemIndex, ppRelocationItem);
+}
+
+template <class T>
+UINT32
+PERelocationTableT<T>::GetRelocationsInRange(PEAddress nBeginRVA, PEAddress nEndRVA, PERelocationEntry *pEntries, UINT32 nMaxCount)
+{
+    if(nBeginRVA >= nEndRVA || !BuildRelocationIndex()) {
+        return 0;
+    }
+
+    typename RelocationIndex::iterator itBegin = std::lower_bound(m_vIndex.begin(), m_vIndex.end(), nBeginRVA, IsIndexEntryBeforeRVA);
+    typename RelocationIndex::iterator itEnd = std::lower_bound(itBegin, m_vIndex.end(), nEndRVA, IsIndexEntryBeforeRVA);
+    if(NULL == pEntries) {
+        return (UINT32)(itEnd - itBegin);
+    }
+
+    UINT32 nFilledCount = 0;
+    while(itBegin != itEnd && nFilledCount < nMaxCount) {
+        pEntries[nFilledCount].nType = itBegin->nType;
+        pEntries[nFilledCount].nRVA = itBegin->nRVA;
+        ++nFilledCount;
+        ++itBegin;
+    }
+
+    return nFilledCount;
+}
+
+template <class T>
+BOOL
+PERelocationTableT<T>::BuildRelocationIndex()
+{
+    if(m_bIsIndexBuilt) {
+        return true;
+    }
+
+    UINT8 *pRawTable = (UINT8 *)GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pRawTable, false);
+
+    m_vIndex.reserve(m_nItemCount);
+
+    typename RelocationBlockList::iterator itBlock = m_vBlocks.begin();
+    while(itBlock != m_vBlocks.end()) {
+        LibPERawBaseRelocation(T) *pRawBlock = (LibPERawBaseRelocation(T) *)(pRawTable + itBlock->nOffset);
+        UINT16 *pRawItemList = (UINT16 *)(&pRawBlock[1]);
+        for(UINT32 nItemIndex = 0; nItemIndex < itBlock->nItemCount; ++nItemIndex) {
+            UINT16 nType = (pRawItemList[nItemIndex] >> 12);
+            if(IMAGE_REL_BASED_ABSOLUTE == nType) {
+                continue;
+            }
+
+            PERelocationIndexEntry oEntry;
+            oEntry.nRVA = pRawBlock->VirtualAddress + (pRawItemList[nItemIndex] & 0x0FFF);
+            oEntry.nItemIndex = itBlock->nFirstItemIndex + nItemIndex;
+            oEntry.nType = nType;
+            m_vIndex.push_back(oEntry);
+
+            // The item after a HIGHADJ one holds the low 16 bits of the adjustment, it is not a relocation.
+            if(IMAGE_REL_BASED_HIGHADJ == nType) {
+                ++nItemIndex;
+            }
         }
+        ++itBlock;
     }
 
-    return E_FAIL;
+    // Blocks are usually sorted by page already, so the stable sort is cheap and keeps the item order for equal RVAs.
+    std::stable_sort(m_vIndex.begin(), m_vIndex.end(), IsIndexEntryBefore);
+
+    m_bIsIndexBuilt = true;
+
+    return true;
+}
+
+template <class T>
+const PERelocationIndexEntry *
+PERelocationTableT<T>::FindIndexEntry(PEAddress nRVA)
+{
+    if(!BuildRelocationIndex()) {
+        return NULL;
+    }
+
+    typename RelocationIndex::iterator itEntry = std::lower_bound(m_vIndex.begin(), m_vIndex.end(), nRVA, IsIndexEntryBeforeRVA);
+    if(itEntry == m_vIndex.end() || itEntry->nRVA != nRVA) {
+        return NULL;
+    }
+
+    return &(*itEntry);
+}
+
+template <class T>
+typename PERelocationTableT<T>::RelocationBlockList::iterator
+PERelocationTableT<T>::FindBlockByItemIndex(UINT32 nItemIndex)
+{
+    // The first block always starts from item 0, so the block found by upper_bound is never the first one.
+    typename RelocationBlockList::iterator itBlock = std::upper_bound(m_vBlocks.begin(), m_vBlocks.end(), nItemIndex, IsItemIndexBeforeBlock);
+    LIBPE_ASSERT_RET(itBlock != m_vBlocks.begin(), m_vBlocks.end());
+    return --itBlock;
+}
+
+template <class T>
+HRESULT
+PERelocationTableT<T>::ApplyRelocations(UINT64 nDelta, UINT8 *pImage, UINT64 nImageSize)
+{
+    LIBPE_ASSERT_RET(NULL != pImage, E_POINTER);
+
+    UINT8 *pRawTable = (UINT8 *)GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pRawTable, E_FAIL);
+
+    typename RelocationBlockList::iterator itBlock = m_vBlocks.begin();
+    while(itBlock != m_vBlocks.end()) {
+        LibPERawBaseRelocation(T) *pRawBlock = (LibPERawBaseRelocation(T) *)(pRawTable + itBlock->nOffset);
+        UINT16 *pRawItemList = (UINT16 *)(&pRawBlock[1]);
+        UINT32 nItemCount = itBlock->nItemCount;
+        UINT32 nItemIndex = 0;
+        while(nItemIndex < nItemCount) {
+            UINT16 nType = (pRawItemList[nItemIndex] >> 12);
+            UINT16 nOffsetInPage = (pRawItemList[nItemIndex] & 0x0FFF);
+            UINT32 nSlotSize = 0;
+            switch(nType) {
+            case IMAGE_REL_BASED_ABSOLUTE:
+                ++nItemIndex;
+                continue;
+            case IMAGE_REL_BASED_HIGHLOW:
+                nSlotSize = sizeof(UINT32);
+                break;
+            case IMAGE_REL_BASED_DIR64:
+                nSlotSize = sizeof(UINT64);
+                break;
+            case IMAGE_REL_BASED_HIGH:
+            case IMAGE_REL_BASED_LOW:
+            case IMAGE_REL_BASED_HIGHADJ:
+                nSlotSize = sizeof(UINT16);
+                break;
+            default:
+                return E_NOTIMPL;
+            }
+
+            // Pointer fixups on adjacent slots, such as the ones in vtables and pointer arrays, are applied together.
+            UINT32 nRunCount = 1;
+            if(IMAGE_REL_BASED_HIGHLOW == nType || IMAGE_REL_BASED_DIR64 == nType) {
+                while(nItemIndex + nRunCount < nItemCount
+                    && nOffsetInPage + nRunCount * nSlotSize <= 0x0FFF
+                    && pRawItemList[nItemIndex + nRunCount] == pRawItemList[nItemIndex] + nRunCount * nSlotSize) {
+                    ++nRunCount;
+                }
+            }
+
+            PEAddress nSlotRVA = pRawBlock->VirtualAddress + nOffsetInPage;
+            if(nSlotRVA + nRunCount * nSlotSize > nImageSize) {
+                return E_FAIL;
+            }
+
+            UINT8 *pSlot = pImage + nSlotRVA;
+            UINT16 nValue = 0;
+            UINT32 nAdjustedValue = 0;
+            switch(nType) {
+            case IMAGE_REL_BASED_HIGHLOW:
+                AddDeltaToSlots32(pSlot, nRunCount, (UINT32)nDelta);
+                break;
+            case IMAGE_REL_BASED_DIR64:
+                AddDeltaToSlots64(pSlot, nRunCount, nDelta);
+                break;
+            case IMAGE_REL_BASED_HIGH:
+                memcpy(&nValue, pSlot, sizeof(UINT16));
+                nAdjustedValue = ((UINT32)nValue << 16) + (UINT32)nDelta;
+                nValue = (UINT16)(nAdjustedValue >> 16);
+                memcpy(pSlot, &nValue, sizeof(UINT16));
+                break;
+            case IMAGE_REL_BASED_LOW:
+                memcpy(&nValue, pSlot, sizeof(UINT16));
+                nValue = (UINT16)(nValue + (UINT16)nDelta);
+                memcpy(pSlot, &nValue, sizeof(UINT16));
+                break;
+            case IMAGE_REL_BASED_HIGHADJ:
+                // The next item holds the low 16 bits of the original address, which decide the rounding.
+                if(nItemIndex + 1 >= nItemCount) {
+                    return E_FAIL;
+                }
+                memcpy(&nValue, pSlot, sizeof(UINT16));
+                nAdjustedValue = ((UINT32)nValue << 16) + (UINT32)(INT32)(INT16)pRawItemList[nItemIndex + 1];
+                nAdjustedValue += (UINT32)nDelta + 0x8000;
+                nValue = (UINT16)(nAdjustedValue >> 16);
+                memcpy(pSlot, &nValue, sizeof(UINT16));
+                ++nItemIndex;
+                break;
+            }
+
+            nItemIndex += nRunCount;
+        }
+
+        ++itBlock;
+    }
+
+    return S_OK;
+}
+
+template <class T>
+UINT32
+PERelocationPageT<T>::DecodeItems(LibPERawBaseRelocation(T) *pRawBlock, UINT32 nItemCount, UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount)
+{
+    LIBPE_ASSERT_RET(NULL != pRawBlock && NULL != pEntries, 0);
+
+    UINT16 *pRawItemList = (UINT16 *)(&pRawBlock[1]);
+    PEAddress nPageRVA = pRawBlock->VirtualAddress;
+
+    // The item after a HIGHADJ one holds the low 16 bits of the adjustment, it is not a relocation. Its type bits are
+    // just data, so we can only tell whether the start item is such a one by walking from the beginning of the block.
+    BOOL bIsParameterItem = false;
+    for(UINT32 nItemIndex = 0; nItemIndex < nStartIndex && nItemIndex < nItemCount; ++nItemIndex) {
+        bIsParameterItem = (!bIsParameterItem && IMAGE_REL_BASED_HIGHADJ == (pRawItemList[nItemIndex] >> 12));
+    }
+
+    // The parameter items are filled as IMAGE_REL_BASED_ABSOLUTE, so the entries still match the item indexes.
+    UINT32 nDecodedCount = 0;
+    for(UINT32 nItemIndex = nStartIndex; nItemIndex < nItemCount && nDecodedCount < nMaxCount; ++nItemIndex) {
+        UINT16 nRawItem = pRawItemList[nItemIndex];
+        if(bIsParameterItem) {
+            pEntries[nDecodedCount].nType = IMAGE_REL_BASED_ABSOLUTE;
+            pEntries[nDecodedCount].nRVA = nPageRVA;
+            bIsParameterItem = false;
+        } else {
+            pEntries[nDecodedCount].nType = (nRawItem >> 12);
+            pEntries[nDecodedCount].nRVA = nPageRVA + (nRawItem & 0x0FFF);
+            bIsParameterItem = (IMAGE_REL_BASED_HIGHADJ == pEntries[nDecodedCount].nType);
+        }
+        ++nDecodedCount;
+    }
+
+    return nDecodedCount;
 }
 
 template <class T>
@@ -78,9 +409,28 @@ PERelocationPageT<T>::GetItemByIndex(UINT32 nIndex, IPERelocationItem **ppReloca
     UINT32 nItemCount = GetItemCount();
     LIBPE_ASSERT_RET(nIndex < nItemCount, E_FAIL);
 
+    if(NULL == m_vItems[nIndex]) {
+        LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+        if(FAILED(m_pParser->ParseRelocationItem(this, nIndex, &m_vItems[nIndex])) || NULL == m_vItems[nIndex]) {
+            return E_FAIL;
+        }
+    }
+
     return m_vItems[nIndex].CopyTo(ppRelocationItem);
 }
 
+template <class T>
+UINT32
+PERelocationPageT<T>::GetItems(UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount)
+{
+    LibPERawBaseRelocation(T) *pRawStruct = GetRawStruct();
+    if(NULL == pRawStruct) {
+        return 0;
+    }
+
+    return DecodeItems(pRawStruct, GetItemCount(), nStartIndex, pEntries, nMaxCount);
+}
+
 template <class T>
 BOOL
 PERelocationPageT<T>::IsRVANeedRelocation(PEAddress nRVA)
@@ -96,15 +446,25 @@ PERelocationPageT<T>::GetItemByRVA(PEAddress nRVA, IPERelocationItem **ppRelocat
     LIBPE_ASSERT_RET(NULL != ppRelocationItem, E_POINTER);
     *ppRelocationItem = NULL;
 
-    PEAddress nRVABase = (nRVA & 0xFFFF0000);
+    PEAddress nRVABase = (nRVA & 0xFFFFF000);
     if(nRVABase != GetPageRVA()) {
         return E_INVALIDARG;
     }
 
+    LibPERawBaseRelocation(T) *pRawStruct = GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pRawStruct, E_FAIL);
+
+    UINT16 *pRawItemList = (UINT16 *)(&pRawStruct[1]);
     UINT32 nItemCount = GetItemCount();
     for(UINT32 nItemIndex = 0; nItemIndex < nItemCount; ++nItemIndex) {
-        if(m_vItems[nItemIndex]->GetAddressRVA() == nRVA) {
-            return m_vItems[nItemIndex].CopyTo(ppRelocationItem);
+        UINT16 nType = (pRawItemList[nItemIndex] >> 12);
+        if(IMAGE_REL_BASED_ABSOLUTE != nType && pRawStruct->VirtualAddress + (pRawItemList[nItemIndex] & 0x0FFF) == nRVA) {
+            return GetItemByIndex(nItemIndex, ppRelocationItem);
+        }
+
+        // The item after a HIGHADJ one holds the low 16 bits of the adjustment, it is not a relocation.
+        if(IMAGE_REL_BASED_HIGHADJ == nType) {
+            ++nItemIndex;
         }
     }
 
@@ -129,12 +489,20 @@ template <class T>
 PEAddress
 PERelocationItemT<T>::GetAddressContent()
 {
-    PEAddress *pAddressContent = GetRawAddressContent();
-    if(NULL == pAddressContent) {
+    LIBPE_ASSERT_RET(NULL != m_pParser, 0);
+
+    UINT32 nAddressContentSize = GetAddressContentSize();
+    if(0 == nAddressContentSize) {
+        return 0;
+    }
+
+    // The slot may be narrower than PEAddress, so only the bytes of the slot are read.
+    PEAddress nAddressContent = 0;
+    if(!m_pParser->ReadRawData(GetAddressRawOffset(), &nAddressContent, nAddressContentSize)) {
         return 0;
     }
-    
-    return *pAddressContent;
+
+    return nAddressContent;
 }
 
 template <class T>
@@ -142,8 +510,47 @@ PEAddress *
 PERelocationItemT<T>::GetRawAddressContent()
 {
     LIBPE_ASSERT_RET(NULL != m_pParser, 0);
-    PEAddress nAddressFOA = m_pParser->GetFOAFromRVA(m_nAddressRVA);
-    return (PEAddress *)m_pParser->GetRawMemory(nAddressFOA, sizeof(UINT16));
+
+    if(NULL != m_pRawAddressContent) {
+        return m_pRawAddressContent;
+    }
+
+    UINT32 nAddressContentSize = GetAddressContentSize();
+    if(0 == nAddressContentSize) {
+        return NULL;
+    }
+
+    // The pointer is handed out to the caller, so the slot is kept by the item and loaded only once.
+    PEAddress nAddressRawOffset = GetAddressRawOffset();
+    m_pRawAddressContent = (PEAddress *)m_pParser->GetRawMemory(nAddressRawOffset, nAddressContentSize);
+    InnerKeepRawMemory(m_pRawAddressContent, nAddressRawOffset, nAddressContentSize);
+
+    return m_pRawAddressContent;
+}
+
+template <class T>
+PEAddress
+PERelocationItemT<T>::GetAddressRawOffset()
+{
+    return m_pParser->IsRawAddressVA() ? m_nAddressRVA : m_pParser->GetFOAFromRVA(m_nAddressRVA);
+}
+
+template <class T>
+UINT32
+PERelocationItemT<T>::GetAddressContentSize()
+{
+    switch(m_nRelocateFlag >> 12) {
+    case IMAGE_REL_BASED_HIGHLOW:
+        return sizeof(UINT32);
+    case IMAGE_REL_BASED_DIR64:
+        return sizeof(UINT64);
+    case IMAGE_REL_BASED_HIGH:
+    case IMAGE_REL_BASED_LOW:
+    case IMAGE_REL_BASED_HIGHADJ:
+        return sizeof(UINT16);
+    }
+
+    return 0;
 }
 
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PERelocationTableT);
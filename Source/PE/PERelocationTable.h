@@ -4,31 +4,76 @@
 
 LIBPE_NAMESPACE_BEGIN
 
+// Only the position of each relocation block is recorded while parsing. The items are decoded from the raw block on access.
+struct PERelocationBlock {
+    UINT32  nOffset;            // Offset of the block from the beginning of the relocation table.
+    UINT32  nItemCount;
+    UINT32  nFirstItemIndex;    // Index of the first item of the block in the whole relocation table.
+};
+
+// The relocation index is sorted by RVA, so the lookups by RVA can be done with binary search.
+struct PERelocationIndexEntry {
+    UINT32  nRVA;
+    UINT32  nItemIndex;
+    UINT16  nType;
+};
+
 template <class T>
 class PERelocationTableT :
     public IPERelocationTable,
     public PEElementT<T>
 {
+    typedef std::vector<PERelocationBlock> RelocationBlockList;
     typedef std::vector<LibPEPtr<IPERelocationPage>> RelocationPageList;
+    typedef std::vector<PERelocationIndexEntry> RelocationIndex;
 
 public:
-    PERelocationTableT() {}
+    PERelocationTableT() : m_nItemCount(0), m_bIsIndexBuilt(false) {}
     virtual ~PERelocationTableT() {}
 
     DECLARE_PE_ELEMENT(LibPERawBaseRelocation(T))
 
-    void InnerAddRelocationPage(IPERelocationPage *pPage) {
-        LIBPE_ASSERT_RET_VOID(NULL != pPage);
-        m_vPages.push_back(pPage);
+    void InnerAddRelocationBlock(UINT32 nOffset, UINT32 nItemCount) {
+        PERelocationBlock oBlock;
+        oBlock.nOffset = nOffset;
+        oBlock.nItemCount = nItemCount;
+        oBlock.nFirstItemIndex = m_nItemCount;
+        m_vBlocks.push_back(oBlock);
+        m_nItemCount += nItemCount;
+    }
+
+    BOOL PrepareForUsing() {
+        m_vPages.resize(m_vBlocks.size(), NULL);
+        return true;
+    }
+
+    const PERelocationBlock * GetRelocationBlock(UINT32 nIndex) {
+        LIBPE_ASSERT_RET(nIndex < m_vBlocks.size(), NULL);
+        return &m_vBlocks[nIndex];
     }
 
     virtual UINT32 LIBPE_CALLTYPE GetPageCount();
     virtual HRESULT LIBPE_CALLTYPE GetPageByIndex(UINT32 nIndex, IPERelocationPage **ppRelocationPage);
+    virtual UINT32 LIBPE_CALLTYPE GetItemCount();
+    virtual UINT32 LIBPE_CALLTYPE GetItems(UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount);
     virtual BOOL LIBPE_CALLTYPE IsRVANeedRelocation(PEAddress nRVA);
     virtual HRESULT LIBPE_CALLTYPE GetItemByRVA(PEAddress nRVA, IPERelocationItem **ppRelocationItem);
+    virtual UINT32 LIBPE_CALLTYPE GetRelocationsInRange(PEAddress nBeginRVA, PEAddress nEndRVA, PERelocationEntry *pEntries, UINT32 nMaxCount);
+
+    // Add nDelta to every fixup of the image laid out in pImage.
+    HRESULT ApplyRelocations(UINT64 nDelta, UINT8 *pImage, UINT64 nImageSize);
+
+protected:
+    BOOL BuildRelocationIndex();
+    const PERelocationIndexEntry * FindIndexEntry(PEAddress nRVA);
+    typename RelocationBlockList::iterator FindBlockByItemIndex(UINT32 nItemIndex);
 
 private:
-    RelocationPageList m_vPages;
+    RelocationBlockList m_vBlocks;
+    RelocationPageList  m_vPages;
+    UINT32              m_nItemCount;
+    RelocationIndex     m_vIndex;
+    BOOL                m_bIsIndexBuilt;
 };
 
 template <class T>
@@ -38,15 +83,19 @@ class PERelocationPageT :
 {
     typedef std::vector<LibPEPtr<IPERelocationItem>> RelocationItemList;
 
+public:
+    // Decode the items of a raw relocation block into (type, rva) pairs, without creating any item object.
+    static UINT32 DecodeItems(LibPERawBaseRelocation(T) *pRawBlock, UINT32 nItemCount, UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount);
+
 public:
     PERelocationPageT() {}
     virtual ~PERelocationPageT() {}
 
     DECLARE_PE_ELEMENT(LibPERawBaseRelocation(T))
 
-    void InnerAddRelocationItem(IPERelocationItem *pItem) {
-        LIBPE_ASSERT_RET_VOID(NULL != pItem);
-        m_vItems.push_back(pItem);
+    BOOL PrepareForUsing(UINT32 nItemCount) {
+        m_vItems.resize(nItemCount, NULL);
+        return true;
     }
 
     LIBPE_FIELD_ACCESSOR(UINT32, VirtualAddress)
@@ -55,6 +104,7 @@ public:
     virtual PEAddress LIBPE_CALLTYPE GetPageRVA();
     virtual UINT32 LIBPE_CALLTYPE GetItemCount();
     virtual HRESULT LIBPE_CALLTYPE GetItemByIndex(UINT32 nIndex, IPERelocationItem **ppRelocationItem);
+    virtual UINT32 LIBPE_CALLTYPE GetItems(UINT32 nStartIndex, PERelocationEntry *pEntries, UINT32 nMaxCount);
     virtual BOOL LIBPE_CALLTYPE IsRVANeedRelocation(PEAddress nRVA);
     virtual HRESULT LIBPE_CALLTYPE GetItemByRVA(PEAddress nRVA, IPERelocationItem **ppRelocationItem);
 
@@ -68,7 +118,7 @@ class PERelocationItemT :
     public PEElementT<T>
 {
 public:
-    PERelocationItemT() : m_nAddressRVA(0) {}
+    PERelocationItemT() : m_nRelocateFlag(0), m_nAddressRVA(0), m_pRawAddressContent(NULL) {}
     virtual ~PERelocationItemT() {}
 
     DECLARE_PE_ELEMENT(void)
@@ -81,9 +131,14 @@ public:
     virtual PEAddress LIBPE_CALLTYPE GetAddressContent();
     virtual PEAddress * LIBPE_CALLTYPE GetRawAddressContent();
 
+protected:
+    UINT32 GetAddressContentSize();
+    PEAddress GetAddressRawOffset();
+
 private:
     UINT16      m_nRelocateFlag;
     PEAddress   m_nAddressRVA;
+    PEAddress   *m_pRawAddressContent;
 };
 
 typedef PERelocationTableT<PE32> PERelocationTable32;
@@ -3,6 +3,78 @@
 
 LIBPE_NAMESPACE_BEGIN
 
+// RT_XXX in WinUser.h are defined with MAKEINTRESOURCE, so we need the ids themselves here.
+enum {
+    PE_RESOURCE_TYPE_GROUP_ICON = 14,
+    PE_RESOURCE_TYPE_MANIFEST   = 24,
+};
+
+enum {
+    NAME_COMPARE_CHUNK_LENGTH   = 64,
+};
+
+// A name passed as MAKEINTRESOURCEW(id) is a pointer whose value fits in 16 bits, the same check as IS_INTRESOURCE.
+static BOOL
+IsResourceNameId(const wchar_t *pName)
+{
+    return (0 == (((size_t)pName) >> 16));
+}
+
+// The loader looks up the string names in upper case, so only the ASCII letters are folded here. The names in the file
+// are UTF-16 units, which are compared by value with the wchar_t of the caller, whatever the size of wchar_t is.
+template <class TRightChar>
+static INT32
+CompareResourceNames(const UINT16 *pLeftName, UINT32 nLeftLength, const TRightChar *pRightName, UINT32 nRightLength)
+{
+    UINT32 nLength = (nLeftLength < nRightLength) ? nLeftLength : nRightLength;
+    for(UINT32 nIndex = 0; nIndex < nLength; ++nIndex) {
+        UINT32 nLeftChar = pLeftName[nIndex], nRightChar = (UINT32)pRightName[nIndex];
+        if(nLeftChar >= 'a' && nLeftChar <= 'z') {
+            nLeftChar = nLeftChar - 'a' + 'A';
+        }
+        if(nRightChar >= 'a' && nRightChar <= 'z') {
+            nRightChar = nRightChar - 'a' + 'A';
+        }
+        if(nLeftChar != nRightChar) {
+            return (nLeftChar < nRightChar) ? -1 : 1;
+        }
+    }
+
+    return (nLeftLength < nRightLength) ? -1 : ((nLeftLength > nRightLength) ? 1 : 0);
+}
+
+// The ids go before the string names, and the names of the string keys must be resolved already.
+static INT32
+CompareResolvedNameKeys(UINT32 nLeftKey, const UINT16 *pLeftName, UINT32 nLeftLength, UINT32 nRightKey, const UINT16 *pRightName, UINT32 nRightLength)
+{
+    BOOL bIsLeftString = (0 != (nLeftKey & PE_RESOURCE_NAME_IS_STRING));
+    BOOL bIsRightString = (0 != (nRightKey & PE_RESOURCE_NAME_IS_STRING));
+    if(!bIsLeftString || !bIsRightString) {
+        if(bIsLeftString != bIsRightString) {
+            return bIsLeftString ? 1 : -1;
+        }
+        return (nLeftKey < nRightKey) ? -1 : ((nLeftKey > nRightKey) ? 1 : 0);
+    }
+
+    return CompareResourceNames(pLeftName, nLeftLength, pRightName, nRightLength);
+}
+
+template <class T>
+bool
+PEResourceTableT<T>::IsSortItemBefore(const RecordSortItem &oLeft, const RecordSortItem &oRight)
+{
+    INT32 nResult = CompareResolvedNameKeys(oLeft.m_oRecord.nType, oLeft.m_pTypeName, oLeft.m_nTypeNameLength, oRight.m_oRecord.nType, oRight.m_pTypeName, oRight.m_nTypeNameLength);
+    if(0 == nResult) {
+        nResult = CompareResolvedNameKeys(oLeft.m_oRecord.nName, oLeft.m_pName, oLeft.m_nNameLength, oRight.m_oRecord.nName, oRight.m_pName, oRight.m_nNameLength);
+    }
+
+    if(0 != nResult) {
+        return (nResult < 0);
+    }
+
+    return (oLeft.m_oRecord.nLanguage < oRight.m_oRecord.nLanguage);
+}
+
 template <class T>
 HRESULT
 PEResourceTableT<T>::GetRootDirectory(IPEResourceDirectory **ppDirectory)
@@ -11,6 +83,452 @@ PEResourceTableT<T>::GetRootDirectory(IPEResourceDirectory **ppDirectory)
     return m_pRootDirectory.CopyTo(ppDirectory);
 }
 
+template <class T>
+HRESULT
+PEResourceTableT<T>::GetResourceRecords(const PEResourceRecord **ppRecords, UINT32 *pRecordCount)
+{
+    LIBPE_ASSERT_RET(NULL != ppRecords && NULL != pRecordCount, E_POINTER);
+
+    if(!BuildRecordList()) {
+        return E_FAIL;
+    }
+
+    *ppRecords = m_vRecords.empty() ? NULL : &m_vRecords[0];
+    *pRecordCount = (UINT32)m_vRecords.size();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEResourceTableT<T>::FindResourceRecord(const wchar_t *pType, const wchar_t *pName, UINT32 nLanguage, const PEResourceRecord **ppRecord)
+{
+    LIBPE_ASSERT_RET(NULL != pType && NULL != pName && NULL != ppRecord, E_POINTER);
+
+    *ppRecord = NULL;
+
+    if(!BuildRecordList()) {
+        return E_FAIL;
+    }
+
+    // Find the first record which is not less than the key. Any language is less than none, so the lowest one is found.
+    UINT32 nLowIndex = 0, nHighIndex = (UINT32)m_vRecords.size();
+    while(nLowIndex < nHighIndex) {
+        UINT32 nMiddleIndex = nLowIndex + (nHighIndex - nLowIndex) / 2;
+        const PEResourceRecord &oRecord = m_vRecords[nMiddleIndex];
+
+        INT32 nResult = CompareNameKey(oRecord.nType, pType);
+        if(0 == nResult) {
+            nResult = CompareNameKey(oRecord.nName, pName);
+        }
+        if(0 == nResult && PE_RESOURCE_ANY_LANGUAGE != nLanguage && oRecord.nLanguage < nLanguage) {
+            nResult = -1;
+        }
+
+        if(nResult < 0) {
+            nLowIndex = nMiddleIndex + 1;
+        } else {
+            nHighIndex = nMiddleIndex;
+        }
+    }
+
+    if(nLowIndex >= m_vRecords.size()) {
+        return E_FAIL;
+    }
+
+    const PEResourceRecord &oRecord = m_vRecords[nLowIndex];
+    if(0 != CompareNameKey(oRecord.nType, pType) || 0 != CompareNameKey(oRecord.nName, pName)) {
+        return E_FAIL;
+    }
+
+    if(PE_RESOURCE_ANY_LANGUAGE != nLanguage && oRecord.nLanguage != nLanguage) {
+        return E_FAIL;
+    }
+
+    *ppRecord = &oRecord;
+
+    return S_OK;
+}
+
+template <class T>
+const wchar_t *
+PEResourceTableT<T>::GetResourceRecordName(UINT32 nNameKey, UINT32 *pNameLength)
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
+
+    if(0 == (nNameKey & PE_RESOURCE_NAME_IS_STRING)) {
+        return NULL;
+    }
+
+    // The names are handed out to the caller, so each one is kept by the table and loaded only once.
+    LibPERawResourceStringU(T) *pRawString = NULL;
+    typename RecordNameMap::iterator itName = m_mapRecordNames.find(nNameKey);
+    if(itName != m_mapRecordNames.end()) {
+        pRawString = itName->second;
+    } else {
+        PEAddress nRawOffset = GetRawOffset() + (nNameKey & ~(UINT32)PE_RESOURCE_NAME_IS_STRING);
+        UINT16 nRawNameLength = 0;
+        if(!m_pParser->ReadRawData(nRawOffset, &nRawNameLength, sizeof(UINT16))) {
+            return NULL;
+        }
+
+        UINT64 nRawStringSize = sizeof(UINT16) + nRawNameLength * sizeof(UINT16);
+        pRawString = (LibPERawResourceStringU(T) *)m_pParser->GetRawMemory(nRawOffset, nRawStringSize);
+        if(NULL == pRawString) {
+            return NULL;
+        }
+
+        InnerKeepRawMemory(pRawString, nRawOffset, nRawStringSize);
+        m_mapRecordNames[nNameKey] = pRawString;
+    }
+
+    if(NULL != pNameLength) {
+        *pNameLength = pRawString->Length;
+    }
+
+    return (const wchar_t *)pRawString->NameString;
+}
+
+template <class T>
+HRESULT
+PEResourceTableT<T>::GetResourceByRecord(const PEResourceRecord *pRecord, IPEResource **ppResource)
+{
+    LIBPE_ASSERT_RET(NULL != pRecord && NULL != ppResource, E_POINTER);
+    return GetResourceByDataEntryOffset(pRecord->nDataEntryOffset, ppResource);
+}
+
+template <class T>
+HRESULT
+PEResourceTableT<T>::GetManifest(IPEResource **ppResource)
+{
+    return GetFirstResourceOfType(PE_RESOURCE_TYPE_MANIFEST, ppResource);
+}
+
+template <class T>
+HRESULT
+PEResourceTableT<T>::GetIconGroup(IPEResource **ppResource)
+{
+    return GetFirstResourceOfType(PE_RESOURCE_TYPE_GROUP_ICON, ppResource);
+}
+
+template <class T>
+HRESULT
+PEResourceTableT<T>::GetFirstResourceOfType(UINT16 nTypeId, IPEResource **ppResource)
+{
+    LIBPE_ASSERT_RET(NULL != ppResource, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+
+    *ppResource = NULL;
+
+    // GetRawStruct would load the whole table, so only the directories on the way are read here.
+    RawDirectoryEntryList vRawTypeEntries;
+    UINT32 nNamedTypeEntryCount = 0;
+    if(!ReadRawDirectoryEntries(0, vRawTypeEntries, &nNamedTypeEntryCount) || vRawTypeEntries.empty()) {
+        return E_FAIL;
+    }
+
+    // The id entries follow the named ones and are sorted by id, so we search them the same way as the loader does.
+    UINT32 nTypeEntryCount = (UINT32)vRawTypeEntries.size();
+    UINT32 nLowIndex = nNamedTypeEntryCount, nHighIndex = nTypeEntryCount;
+    while(nLowIndex < nHighIndex) {
+        UINT32 nMiddleIndex = nLowIndex + (nHighIndex - nLowIndex) / 2;
+        if(vRawTypeEntries[nMiddleIndex].Id < nTypeId) {
+            nLowIndex = nMiddleIndex + 1;
+        } else {
+            nHighIndex = nMiddleIndex;
+        }
+    }
+
+    if(nLowIndex >= nTypeEntryCount) {
+        return E_FAIL;
+    }
+
+    LibPERawResourceDirectoryEntry(T) *pRawTypeEntry = &vRawTypeEntries[nLowIndex];
+    if(pRawTypeEntry->NameIsString || pRawTypeEntry->Id != nTypeId || !pRawTypeEntry->DataIsDirectory) {
+        return E_FAIL;
+    }
+
+    // The first name wins, which is also the one the shell shows as the icon of the file. The names without any
+    // language data are skipped.
+    RawDirectoryEntryList vRawNameEntries, vRawLanguageEntries;
+    ReadRawDirectoryEntries(pRawTypeEntry->OffsetToDirectory, vRawNameEntries, NULL);
+    for(UINT32 nNameEntryIndex = 0; nNameEntryIndex < (UINT32)vRawNameEntries.size(); ++nNameEntryIndex) {
+        if(!vRawNameEntries[nNameEntryIndex].DataIsDirectory) {
+            continue;
+        }
+
+        ReadRawDirectoryEntries(vRawNameEntries[nNameEntryIndex].OffsetToDirectory, vRawLanguageEntries, NULL);
+        for(UINT32 nLanguageEntryIndex = 0; nLanguageEntryIndex < (UINT32)vRawLanguageEntries.size(); ++nLanguageEntryIndex) {
+            if(!vRawLanguageEntries[nLanguageEntryIndex].DataIsDirectory) {
+                return GetResourceByDataEntryOffset(vRawLanguageEntries[nLanguageEntryIndex].OffsetToData, ppResource);
+            }
+        }
+    }
+
+    return E_FAIL;
+}
+
+template <class T>
+HRESULT
+PEResourceTableT<T>::GetResourceByDataEntryOffset(UINT32 nDataEntryOffset, IPEResource **ppResource)
+{
+    LIBPE_ASSERT_RET(NULL != ppResource, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+
+    *ppResource = NULL;
+
+    // The resources are cached by their data entries, so the lookups by record, manifest and icon group share them.
+    typename ResourceMap::iterator itResource = m_mapResources.find(nDataEntryOffset);
+    if(itResource != m_mapResources.end()) {
+        return itResource->second.CopyTo(ppResource);
+    }
+
+    PEAddress nDataEntryRVA = 0, nDataEntryFOA = 0;
+    if(FAILED(m_pParser->GetResourceAddress(nDataEntryOffset, nDataEntryRVA, nDataEntryFOA))) {
+        return E_FAIL;
+    }
+
+    LibPEPtr<IPEResourceDataEntry> pDataEntry;
+    if(FAILED(m_pParser->ParseResourceDataEntry(nDataEntryRVA, nDataEntryFOA, &pDataEntry)) || NULL == pDataEntry) {
+        return E_OUTOFMEMORY;
+    }
+
+    LibPEPtr<IPEResource> pResource;
+    if(FAILED(pDataEntry->GetResource(&pResource)) || NULL == pResource) {
+        return E_FAIL;
+    }
+
+    m_mapResources[nDataEntryOffset] = pResource;
+
+    return pResource.CopyTo(ppResource);
+}
+
+template <class T>
+BOOL
+PEResourceTableT<T>::BuildRecordList()
+{
+    if(m_bIsRecordListBuilt) {
+        return true;
+    }
+
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    PEResourceRecord oRecord;
+    memset(&oRecord, 0, sizeof(oRecord));
+    if(!AddDirectoryRecords(0, 0, oRecord)) {
+        m_vRecords.clear();
+        return false;
+    }
+
+    SortRecords();
+
+    m_bIsRecordListBuilt = true;
+
+    return true;
+}
+
+template <class T>
+void
+PEResourceTableT<T>::SortRecords()
+{
+    // The string names are copied once for each key into a pool here, rather than read twice in every comparison of
+    // the sort, so nothing is kept in the loader for them. The pool may grow while it is filled, so the names are
+    // pointed to only after that.
+    NameKeyMap mapNameOffsets;
+    std::vector<UINT16> vNamePool;
+    RecordSortItemList vSortItems(m_vRecords.size());
+    for(size_t nRecordIndex = 0; nRecordIndex < m_vRecords.size(); ++nRecordIndex) {
+        RecordSortItem &oItem = vSortItems[nRecordIndex];
+        oItem.m_oRecord = m_vRecords[nRecordIndex];
+        oItem.m_nTypeNameOffset = CopyNameKey(oItem.m_oRecord.nType, mapNameOffsets, vNamePool, oItem.m_nTypeNameLength);
+        oItem.m_nNameOffset = CopyNameKey(oItem.m_oRecord.nName, mapNameOffsets, vNamePool, oItem.m_nNameLength);
+    }
+
+    for(size_t nRecordIndex = 0; nRecordIndex < vSortItems.size(); ++nRecordIndex) {
+        RecordSortItem &oItem = vSortItems[nRecordIndex];
+        oItem.m_pTypeName = (0 != oItem.m_nTypeNameLength) ? &vNamePool[oItem.m_nTypeNameOffset] : NULL;
+        oItem.m_pName = (0 != oItem.m_nNameLength) ? &vNamePool[oItem.m_nNameOffset] : NULL;
+    }
+
+    // The resource compiler sorts each directory already, but it puts the string names before the ids, so we sort again.
+    std::stable_sort(vSortItems.begin(), vSortItems.end(), IsSortItemBefore);
+
+    for(size_t nRecordIndex = 0; nRecordIndex < m_vRecords.size(); ++nRecordIndex) {
+        m_vRecords[nRecordIndex] = vSortItems[nRecordIndex].m_oRecord;
+    }
+}
+
+template <class T>
+BOOL
+PEResourceTableT<T>::AddDirectoryRecords(UINT32 nDirectoryOffset, UINT32 nLevel, PEResourceRecord &oRecord)
+{
+    // The entries are copied, so the directories are not kept in the loader while the tree is walked.
+    RawDirectoryEntryList vRawEntries;
+    if(!ReadRawDirectoryEntries(nDirectoryOffset, vRawEntries, NULL)) {
+        return true;
+    }
+
+    // Each resource has its own language entry in the table, so a tree with more leaves than that must be looping back
+    // to its own directories, and we stop there.
+    size_t nMaxRecordCount = (size_t)(GetRawSize() / sizeof(LibPERawResourceDirectoryEntry(T)));
+
+    UINT32 nEntryCount = (UINT32)vRawEntries.size();
+    for(UINT32 nEntryIndex = 0; nEntryIndex < nEntryCount; ++nEntryIndex) {
+        LibPERawResourceDirectoryEntry(T) *pRawEntry = &vRawEntries[nEntryIndex];
+        UINT32 nKey = pRawEntry->NameIsString ? pRawEntry->Name : pRawEntry->Id;
+
+        // The tree always has the type, name and language levels, and the other shapes are skipped.
+        if(nLevel < 2) {
+            if(!pRawEntry->DataIsDirectory) {
+                continue;
+            }
+
+            if(0 == nLevel) {
+                oRecord.nType = nKey;
+            } else {
+                oRecord.nName = nKey;
+            }
+
+            if(!AddDirectoryRecords(pRawEntry->OffsetToDirectory, nLevel + 1, oRecord)) {
+                return false;
+            }
+            continue;
+        }
+
+        if(pRawEntry->DataIsDirectory) {
+            continue;
+        }
+
+        if(m_vRecords.size() >= nMaxRecordCount) {
+            return false;
+        }
+
+        LibPERawResourceDataEntry(T) oRawDataEntry;
+        if(!m_pParser->ReadRawData(GetRawOffset() + pRawEntry->OffsetToData, &oRawDataEntry, sizeof(LibPERawResourceDataEntry(T)))) {
+            continue;
+        }
+
+        oRecord.nLanguage = nKey;
+        oRecord.nDataEntryOffset = pRawEntry->OffsetToData;
+        oRecord.nDataRVA = oRawDataEntry.OffsetToData;
+        oRecord.nDataSize = oRawDataEntry.Size;
+        oRecord.nCodePage = oRawDataEntry.CodePage;
+        m_vRecords.push_back(oRecord);
+    }
+
+    return true;
+}
+
+template <class T>
+BOOL
+PEResourceTableT<T>::ReadRawDirectoryEntries(UINT32 nDirectoryOffset, RawDirectoryEntryList &vEntries, UINT32 *pNamedEntryCount)
+{
+    LIBPE_ASSERT_RET(NULL != m_pParser, false);
+
+    vEntries.clear();
+
+    PEAddress nRawOffset = GetRawOffset() + nDirectoryOffset;
+    LibPERawResourceDirectory(T) oRawDirectory;
+    if(!m_pParser->ReadRawData(nRawOffset, &oRawDirectory, sizeof(LibPERawResourceDirectory(T)))) {
+        return false;
+    }
+
+    UINT32 nRawEntryCount = oRawDirectory.NumberOfNamedEntries + oRawDirectory.NumberOfIdEntries;
+    if(0 == nRawEntryCount) {
+        return false;
+    }
+
+    vEntries.resize(nRawEntryCount);
+    if(!m_pParser->ReadRawData(nRawOffset + sizeof(LibPERawResourceDirectory(T)), &vEntries[0], nRawEntryCount * sizeof(LibPERawResourceDirectoryEntry(T)))) {
+        vEntries.clear();
+        return false;
+    }
+
+    if(NULL != pNamedEntryCount) {
+        *pNamedEntryCount = oRawDirectory.NumberOfNamedEntries;
+    }
+
+    return true;
+}
+
+template <class T>
+UINT32
+PEResourceTableT<T>::CopyNameKey(UINT32 nKey, NameKeyMap &mapNameOffsets, std::vector<UINT16> &vNamePool, UINT32 &nNameLength)
+{
+    nNameLength = 0;
+
+    if(0 == (nKey & PE_RESOURCE_NAME_IS_STRING)) {
+        return 0;
+    }
+
+    typename NameKeyMap::iterator itName = mapNameOffsets.find(nKey);
+    if(itName != mapNameOffsets.end()) {
+        nNameLength = itName->second.second;
+        return itName->second.first;
+    }
+
+    // A name which can't be read is taken as an empty one, so it still has its place in the order.
+    UINT32 nNameOffset = (UINT32)vNamePool.size();
+    PEAddress nRawOffset = GetRawOffset() + (nKey & ~(UINT32)PE_RESOURCE_NAME_IS_STRING);
+    UINT16 nRawNameLength = 0;
+    if(m_pParser->ReadRawData(nRawOffset, &nRawNameLength, sizeof(UINT16)) && 0 != nRawNameLength) {
+        vNamePool.resize(nNameOffset + nRawNameLength);
+        if(m_pParser->ReadRawData(nRawOffset + sizeof(UINT16), &vNamePool[nNameOffset], nRawNameLength * sizeof(UINT16))) {
+            nNameLength = nRawNameLength;
+        } else {
+            vNamePool.resize(nNameOffset);
+        }
+    }
+
+    mapNameOffsets[nKey] = std::make_pair(nNameOffset, nNameLength);
+
+    return nNameOffset;
+}
+
+template <class T>
+INT32
+PEResourceTableT<T>::CompareNameKey(UINT32 nKey, const wchar_t *pName)
+{
+    // Comparing with an id never needs the text of a name, so nothing is resolved for it.
+    if(IsResourceNameId(pName)) {
+        return CompareResolvedNameKeys(nKey, NULL, 0, (UINT32)(size_t)pName, NULL, 0);
+    }
+
+    if(0 == (nKey & PE_RESOURCE_NAME_IS_STRING)) {
+        return -1;
+    }
+
+    // Each probe of a lookup compares a name, so the name is copied a chunk at a time rather than kept in the loader.
+    // A name which can't be read is taken as an empty one, the same as when the records are sorted, and an empty name
+    // is before any other.
+    UINT32 nNameLength = (UINT32)wcslen(pName);
+    PEAddress nRawOffset = GetRawOffset() + (nKey & ~(UINT32)PE_RESOURCE_NAME_IS_STRING);
+    UINT16 nKeyNameLength = 0;
+    if(!m_pParser->ReadRawData(nRawOffset, &nKeyNameLength, sizeof(UINT16))) {
+        return (0 != nNameLength) ? -1 : 0;
+    }
+
+    UINT16 vChunk[NAME_COMPARE_CHUNK_LENGTH];
+    UINT32 nCompareLength = (nKeyNameLength < nNameLength) ? nKeyNameLength : nNameLength;
+    for(UINT32 nIndex = 0; nIndex < nCompareLength; nIndex += NAME_COMPARE_CHUNK_LENGTH) {
+        UINT32 nChunkLength = nCompareLength - nIndex;
+        if(nChunkLength > NAME_COMPARE_CHUNK_LENGTH) {
+            nChunkLength = NAME_COMPARE_CHUNK_LENGTH;
+        }
+
+        if(!m_pParser->ReadRawData(nRawOffset + sizeof(UINT16) + nIndex * sizeof(UINT16), vChunk, nChunkLength * sizeof(UINT16))) {
+            return -1;
+        }
+
+        INT32 nResult = CompareResourceNames(vChunk, nChunkLength, pName + nIndex, nChunkLength);
+        if(0 != nResult) {
+            return nResult;
+        }
+    }
+
+    return (nKeyNameLength < nNameLength) ? -1 : ((nKeyNameLength > nNameLength) ? 1 : 0);
+}
+
 template <class T>
 UINT32
 PEResourceDirectoryT<T>::GetEntryCount()
@@ -82,25 +600,33 @@ template <class T>
 const wchar_t *
 PEResourceDirectoryEntryT<T>::GetName()
 {
-    LIBPE_ASSERT_RET(NULL != m_pParser && NULL != m_pFile, NULL);
+    LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
+
+    if(NULL != m_pName) {
+        return m_pName;
+    }
 
     LibPERawResourceDirectoryEntry(T) *pRawEntry = GetRawStruct();
-    if(NULL == pRawEntry) {
+    if(NULL == pRawEntry || !pRawEntry->NameIsString) {
         return NULL;
     }
 
-    LibPEPtr<IPEResourceTable> pTable;
-    if(FAILED(m_pFile->GetResourceTable(&pTable)) || NULL == pTable) {
+    PEAddress nNameRVA = 0, nNameFOA = 0;
+    if(FAILED(m_pParser->GetResourceAddress(pRawEntry->NameOffset, nNameRVA, nNameFOA))) {
         return NULL;
     }
 
+    // The string is used as long as the entry, so it is released along with the entry.
     UINT64 nNameSize = 0;
-    LibPERawResourceStringU(T) *pResourceString = m_pParser->ParseResourceStringU(0, pTable->GetFOA() + pRawEntry->NameOffset, nNameSize);
+    LibPERawResourceStringU(T) *pResourceString = m_pParser->ParseResourceStringU(nNameRVA, nNameFOA, nNameSize);
     if(NULL == pResourceString) {
         return NULL;
     }
 
-    return pResourceString->NameString;
+    InnerKeepRawMemory(pResourceString, m_pParser->GetRawOffset(nNameRVA, nNameFOA), nNameSize);
+    m_pName = (const wchar_t *)pResourceString->NameString;
+
+    return m_pName;
 }
 
 template <class T>
@@ -122,28 +648,32 @@ HRESULT
 PEResourceDirectoryEntryT<T>::GetDirectory(IPEResourceDirectory **ppDirectory)
 {
     LIBPE_ASSERT_RET(NULL != ppDirectory, E_POINTER);
-    LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
 
     *ppDirectory = NULL;
 
-    LibPERawResourceDirectoryEntry(T) *pRawEntry = GetRawStruct();
-    if(NULL == pRawEntry) {
-        return E_OUTOFMEMORY;
-    }
+    if(NULL == m_pDirectory) {
+        LibPERawResourceDirectoryEntry(T) *pRawEntry = GetRawStruct();
+        if(NULL == pRawEntry) {
+            return E_OUTOFMEMORY;
+        }
 
-    LibPEPtr<IPEResourceTable> pTable;
-    if(FAILED(m_pFile->GetResourceTable(&pTable)) || NULL == pTable) {
-        return NULL;
-    }
+        // OffsetToDirectory has the high bit of OffsetToData masked off, and it only makes sense for directories.
+        if(!pRawEntry->DataIsDirectory) {
+            return E_FAIL;
+        }
 
-    LibPEPtr<IPEResourceDirectory> pDirectory;
-    if(FAILED(m_pParser->ParseResourceDirectory(0, pTable->GetFOA() + pRawEntry->OffsetToDirectory, &pDirectory)) || NULL == pDirectory) {
-        return E_OUTOFMEMORY;
-    }
+        PEAddress nDirectoryRVA = 0, nDirectoryFOA = 0;
+        if(FAILED(m_pParser->GetResourceAddress(pRawEntry->OffsetToDirectory, nDirectoryRVA, nDirectoryFOA))) {
+            return E_FAIL;
+        }
 
-    *ppDirectory = pDirectory.Detach();
+        if(FAILED(m_pParser->ParseResourceDirectory(nDirectoryRVA, nDirectoryFOA, &m_pDirectory)) || NULL == m_pDirectory) {
+            return E_OUTOFMEMORY;
+        }
+    }
 
-    return S_OK;
+    return m_pDirectory.CopyTo(ppDirectory);
 }
 
 template <class T>
@@ -165,28 +695,31 @@ HRESULT
 PEResourceDirectoryEntryT<T>::GetDataEntry(IPEResourceDataEntry **ppDataEntry)
 {
     LIBPE_ASSERT_RET(NULL != ppDataEntry, E_POINTER);
-    LIBPE_ASSERT_RET(NULL != m_pParser, NULL);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
 
     *ppDataEntry = NULL;
 
-    LibPERawResourceDirectoryEntry(T) *pRawEntry = GetRawStruct();
-    if(NULL == pRawEntry) {
-        return E_OUTOFMEMORY;
-    }
+    if(NULL == m_pDataEntry) {
+        LibPERawResourceDirectoryEntry(T) *pRawEntry = GetRawStruct();
+        if(NULL == pRawEntry) {
+            return E_OUTOFMEMORY;
+        }
 
-    LibPEPtr<IPEResourceTable> pTable;
-    if(FAILED(m_pFile->GetResourceTable(&pTable)) || NULL == pTable) {
-        return NULL;
-    }
+        if(pRawEntry->DataIsDirectory) {
+            return E_FAIL;
+        }
 
-    LibPEPtr<IPEResourceDataEntry> pDataEntry;
-    if(FAILED(m_pParser->ParseResourceDataEntry(0, pTable->GetFOA() + pRawEntry->OffsetToData, &pDataEntry)) || NULL == pDataEntry) {
-        return E_OUTOFMEMORY;
-    }
+        PEAddress nDataEntryRVA = 0, nDataEntryFOA = 0;
+        if(FAILED(m_pParser->GetResourceAddress(pRawEntry->OffsetToData, nDataEntryRVA, nDataEntryFOA))) {
+            return E_FAIL;
+        }
 
-    *ppDataEntry = pDataEntry.Detach();
+        if(FAILED(m_pParser->ParseResourceDataEntry(nDataEntryRVA, nDataEntryFOA, &m_pDataEntry)) || NULL == m_pDataEntry) {
+            return E_OUTOFMEMORY;
+        }
+    }
 
-    return S_OK;
+    return m_pDataEntry.CopyTo(ppDataEntry);
 }
 
 template <class T>
@@ -207,11 +740,6 @@ PEResourceDataEntryT<T>::GetResource(IPEResource **ppResource)
         return E_OUTOFMEMORY;
     }
 
-    LibPEPtr<IPEResourceTable> pTable;
-    if(FAILED(m_pFile->GetResourceTable(&pTable)) || NULL == pTable) {
-        return NULL;
-    }
-
     if(FAILED(m_pParser->ParseResource(this, &m_pResource)) || NULL == m_pResource) {
         return E_OUTOFMEMORY;
     }
@@ -219,6 +747,92 @@ PEResourceDataEntryT<T>::GetResource(IPEResource **ppResource)
     return m_pResource.CopyTo(ppResource);
 }
 
+template <class T>
+HRESULT
+PEResourceT<T>::GetVersionInfo(IPEVersionInfo **ppVersionInfo)
+{
+    LIBPE_ASSERT_RET(NULL != ppVersionInfo, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+
+    *ppVersionInfo = NULL;
+
+    if(NULL == m_pVersionInfo) {
+        HRESULT hr = m_pParser->ParseVersionInfo(this, &m_pVersionInfo);
+        if(FAILED(hr)) {
+            return hr;
+        }
+    }
+
+    return m_pVersionInfo.CopyTo(ppVersionInfo);
+}
+
+template <class T>
+HRESULT
+PEResourceT<T>::Read(UINT32 nOffset, void *pBuffer, UINT32 nSize, UINT32 *pReadSize)
+{
+    LIBPE_ASSERT_RET(NULL != pBuffer && NULL != pReadSize, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pParser, E_FAIL);
+
+    *pReadSize = 0;
+
+    UINT64 nResourceSize = GetRawSize();
+    LIBPE_ASSERT_RET(nOffset <= nResourceSize, E_INVALIDARG);
+
+    if(nSize > nResourceSize - nOffset) {
+        nSize = (UINT32)(nResourceSize - nOffset);
+    }
+
+    if(0 == nSize) {
+        return S_OK;
+    }
+
+    // The data is read from the loader every time instead of through GetRawMemory, which would keep the whole
+    // resource in memory as long as the file is open.
+    PEAddress nRawOffset = GetRawOffset();
+    if(0 == nRawOffset || !m_pParser->ReadRawData(nRawOffset + nOffset, pBuffer, nSize)) {
+        return E_FAIL;
+    }
+
+    *pReadSize = nSize;
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEResourceT<T>::ReadInChunks(IPEResourceDataSink *pSink, UINT32 nWindowSize)
+{
+    LIBPE_ASSERT_RET(NULL != pSink, E_POINTER);
+
+    UINT32 nResourceSize = (UINT32)GetRawSize();
+    if(0 == nWindowSize) {
+        nWindowSize = 0x10000;
+    }
+
+    if(nWindowSize > nResourceSize && 0 != nResourceSize) {
+        nWindowSize = nResourceSize;
+    }
+
+    std::vector<UINT8> vWindow(nWindowSize);
+    UINT32 nOffset = 0;
+    while(nOffset < nResourceSize) {
+        UINT32 nReadSize = 0;
+        HRESULT hr = Read(nOffset, &vWindow[0], nWindowSize, &nReadSize);
+        if(FAILED(hr)) {
+            return hr;
+        }
+
+        hr = pSink->OnData(nOffset, &vWindow[0], nReadSize);
+        if(FAILED(hr)) {
+            return hr;
+        }
+
+        nOffset += nReadSize;
+    }
+
+    return S_OK;
+}
+
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEResourceTableT);
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEResourceDirectoryT);
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEResourceDirectoryEntryT);
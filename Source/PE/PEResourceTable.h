@@ -9,8 +9,26 @@ class PEResourceTableT :
     public IPEResourceTable,
     public PEElementT<T>
 {
+    typedef std::vector<PEResourceRecord> RecordList;
+    typedef std::vector<LibPERawResourceDirectoryEntry(T)> RawDirectoryEntryList;
+
+    // A record with its string names copied, so sorting doesn't read the names again on every comparison.
+    struct RecordSortItem {
+        PEResourceRecord    m_oRecord;
+        UINT32              m_nTypeNameOffset;
+        UINT32              m_nTypeNameLength;
+        UINT32              m_nNameOffset;
+        UINT32              m_nNameLength;
+        const UINT16        *m_pTypeName;
+        const UINT16        *m_pName;
+    };
+    typedef std::vector<RecordSortItem> RecordSortItemList;
+    typedef std::map<UINT32, std::pair<UINT32, UINT32>> NameKeyMap;
+    typedef std::map<UINT32, LibPEPtr<IPEResource>> ResourceMap;
+    typedef std::map<UINT32, LibPERawResourceStringU(T) *> RecordNameMap;
+
 public:
-    PEResourceTableT() {}
+    PEResourceTableT() : m_bIsRecordListBuilt(false) {}
     virtual ~PEResourceTableT() {}
 
     DECLARE_PE_ELEMENT(LibPERawResourceDirectory(T))
@@ -22,9 +40,30 @@ public:
     }
 
     virtual HRESULT LIBPE_CALLTYPE GetRootDirectory(IPEResourceDirectory **ppDirectory);
+    virtual HRESULT LIBPE_CALLTYPE GetResourceRecords(const PEResourceRecord **ppRecords, UINT32 *pRecordCount);
+    virtual HRESULT LIBPE_CALLTYPE FindResourceRecord(const wchar_t *pType, const wchar_t *pName, UINT32 nLanguage, const PEResourceRecord **ppRecord);
+    virtual const wchar_t * LIBPE_CALLTYPE GetResourceRecordName(UINT32 nNameKey, UINT32 *pNameLength);
+    virtual HRESULT LIBPE_CALLTYPE GetResourceByRecord(const PEResourceRecord *pRecord, IPEResource **ppResource);
+    virtual HRESULT LIBPE_CALLTYPE GetManifest(IPEResource **ppResource);
+    virtual HRESULT LIBPE_CALLTYPE GetIconGroup(IPEResource **ppResource);
+
+protected:
+    HRESULT GetFirstResourceOfType(UINT16 nTypeId, IPEResource **ppResource);
+    HRESULT GetResourceByDataEntryOffset(UINT32 nDataEntryOffset, IPEResource **ppResource);
+    BOOL BuildRecordList();
+    BOOL AddDirectoryRecords(UINT32 nDirectoryOffset, UINT32 nLevel, PEResourceRecord &oRecord);
+    void SortRecords();
+    BOOL ReadRawDirectoryEntries(UINT32 nDirectoryOffset, RawDirectoryEntryList &vEntries, UINT32 *pNamedEntryCount);
+    UINT32 CopyNameKey(UINT32 nKey, NameKeyMap &mapNameOffsets, std::vector<UINT16> &vNamePool, UINT32 &nNameLength);
+    INT32 CompareNameKey(UINT32 nKey, const wchar_t *pName);
+    static bool IsSortItemBefore(const RecordSortItem &oLeft, const RecordSortItem &oRight);
 
 private:
     LibPEPtr<IPEResourceDirectory>  m_pRootDirectory;
+    RecordList                      m_vRecords;
+    BOOL                            m_bIsRecordListBuilt;
+    ResourceMap                     m_mapResources;
+    RecordNameMap                   m_mapRecordNames;
 };
 
 template <class T>
@@ -65,7 +104,7 @@ class PEResourceDirectoryEntryT :
     public PEElementT<T>
 {
 public:
-    PEResourceDirectoryEntryT() {}
+    PEResourceDirectoryEntryT() : m_pName(NULL) {}
     virtual ~PEResourceDirectoryEntryT() {}
 
     DECLARE_PE_ELEMENT(LibPERawResourceDirectoryEntry(T))
@@ -89,6 +128,11 @@ public:
 
     virtual BOOL LIBPE_CALLTYPE IsEntryDataEntry();
     virtual HRESULT LIBPE_CALLTYPE GetDataEntry(IPEResourceDataEntry **ppDataEntry);
+
+private:
+    const wchar_t                   *m_pName;
+    LibPEPtr<IPEResourceDirectory>  m_pDirectory;
+    LibPEPtr<IPEResourceDataEntry>  m_pDataEntry;
 };
 
 template <class T>
@@ -123,6 +167,13 @@ public:
     virtual ~PEResourceT() {}
 
     DECLARE_PE_ELEMENT(void)
+
+    virtual HRESULT LIBPE_CALLTYPE GetVersionInfo(IPEVersionInfo **ppVersionInfo);
+    virtual HRESULT LIBPE_CALLTYPE Read(UINT32 nOffset, void *pBuffer, UINT32 nSize, UINT32 *pReadSize);
+    virtual HRESULT LIBPE_CALLTYPE ReadInChunks(IPEResourceDataSink *pSink, UINT32 nWindowSize);
+
+private:
+    LibPEPtr<IPEVersionInfo> m_pVersionInfo;
 };
 
 LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include "stdafx.h"
+#include "PE/PEVersionInfo.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+// The header of a block in VS_VERSIONINFO. The offsets are from the beginning of the resource.
+struct PEVersionBlock {
+    UINT32          nEndOffset;
+    UINT16          nType;
+    PEStringView    oKey;
+    UINT32          nValueOffset;
+    UINT32          nValueSize;
+    UINT32          nChildOffset;
+};
+
+// The strings are UTF-16, so they are walked in UINT16 units, whatever the size of wchar_t is.
+static const UINT16 *
+GetStringViewUnits(const PEStringView &oString)
+{
+    return (const UINT16 *)oString.pString;
+}
+
+// All the blocks and their values are aligned to 4 bytes from the beginning of the resource.
+static UINT32
+AlignVersionOffset(UINT32 nOffset, UINT32 nEndOffset)
+{
+    nOffset = (nOffset + 3) & ~3;
+    return (nOffset < nEndOffset) ? nOffset : nEndOffset;
+}
+
+static BOOL
+ReadVersionBlock(UINT8 *pRawInfo, UINT32 nOffset, UINT32 nEndOffset, PEVersionBlock &oBlock)
+{
+    // wLength, wValueLength and wType, which are followed by the key.
+    const UINT32 nHeaderSize = 3 * sizeof(UINT16);
+    if(nOffset >= nEndOffset || nEndOffset - nOffset < nHeaderSize) {
+        return false;
+    }
+
+    UINT16 nLength = 0, nValueLength = 0;
+    memcpy(&nLength, pRawInfo + nOffset, sizeof(UINT16));
+    memcpy(&nValueLength, pRawInfo + nOffset + sizeof(UINT16), sizeof(UINT16));
+    memcpy(&oBlock.nType, pRawInfo + nOffset + 2 * sizeof(UINT16), sizeof(UINT16));
+    if(nLength < nHeaderSize || nLength > nEndOffset - nOffset) {
+        return false;
+    }
+
+    oBlock.nEndOffset = nOffset + nLength;
+
+    UINT32 nKeyOffset = nOffset + nHeaderSize;
+    UINT32 nKeyLength = 0;
+    while(true) {
+        UINT32 nCharOffset = nKeyOffset + nKeyLength * sizeof(UINT16);
+        if(nCharOffset + sizeof(UINT16) > oBlock.nEndOffset) {
+            return false;
+        }
+
+        UINT16 nChar = 0;
+        memcpy(&nChar, pRawInfo + nCharOffset, sizeof(UINT16));
+        if(0 == nChar) {
+            break;
+        }
+        ++nKeyLength;
+    }
+
+    oBlock.oKey.pString = (const wchar_t *)(pRawInfo + nKeyOffset);
+    oBlock.oKey.nLength = nKeyLength;
+
+    // The length of a text value is in characters. Some tools put the size in bytes there, so it is clipped to the block.
+    oBlock.nValueOffset = AlignVersionOffset(nKeyOffset + (nKeyLength + 1) * sizeof(UINT16), oBlock.nEndOffset);
+    oBlock.nValueSize = (1 == oBlock.nType) ? nValueLength * sizeof(UINT16) : nValueLength;
+    if(oBlock.nValueSize > oBlock.nEndOffset - oBlock.nValueOffset) {
+        oBlock.nValueSize = oBlock.nEndOffset - oBlock.nValueOffset;
+    }
+
+    oBlock.nChildOffset = AlignVersionOffset(oBlock.nValueOffset + oBlock.nValueSize, oBlock.nEndOffset);
+
+    return true;
+}
+
+static INT32
+CompareVersionKey(const PEStringView &oKey, const wchar_t *pKey)
+{
+    const UINT16 *pKeyUnits = GetStringViewUnits(oKey);
+    UINT32 nIndex = 0;
+    for(; nIndex < oKey.nLength && 0 != pKey[nIndex]; ++nIndex) {
+        UINT32 nLeftChar = pKeyUnits[nIndex], nRightChar = (UINT32)pKey[nIndex];
+        if(nLeftChar >= 'a' && nLeftChar <= 'z') {
+            nLeftChar = nLeftChar - 'a' + 'A';
+        }
+        if(nRightChar >= 'a' && nRightChar <= 'z') {
+            nRightChar = nRightChar - 'a' + 'A';
+        }
+        if(nLeftChar != nRightChar) {
+            return (nLeftChar < nRightChar) ? -1 : 1;
+        }
+    }
+
+    if(nIndex < oKey.nLength) {
+        return 1;
+    }
+
+    return (0 != pKey[nIndex]) ? -1 : 0;
+}
+
+template <class T>
+BOOL
+PEVersionInfoT<T>::Decode()
+{
+    UINT8 *pRawInfo = GetRawStruct();
+    UINT32 nRawSize = (UINT32)GetRawSize();
+    if(NULL == pRawInfo) {
+        return false;
+    }
+
+    PEVersionBlock oRootBlock;
+    if(!ReadVersionBlock(pRawInfo, 0, nRawSize, oRootBlock) || 0 != CompareVersionKey(oRootBlock.oKey, L"VS_VERSION_INFO")) {
+        return false;
+    }
+
+    if(oRootBlock.nValueSize >= sizeof(PERawFixedFileInfo) && 0 == (oRootBlock.nValueOffset & 3)) {
+        PERawFixedFileInfo *pFixedFileInfo = (PERawFixedFileInfo *)(pRawInfo + oRootBlock.nValueOffset);
+        if(VS_FFI_SIGNATURE == pFixedFileInfo->dwSignature) {
+            m_pFixedFileInfo = pFixedFileInfo;
+        }
+    }
+
+    PEVersionBlock oBlock;
+    for(UINT32 nOffset = oRootBlock.nChildOffset; ReadVersionBlock(pRawInfo, nOffset, oRootBlock.nEndOffset, oBlock); nOffset = AlignVersionOffset(oBlock.nEndOffset, oRootBlock.nEndOffset)) {
+        if(0 == CompareVersionKey(oBlock.oKey, L"StringFileInfo")) {
+            DecodeStringFileInfo(pRawInfo, oBlock.nChildOffset, oBlock.nEndOffset);
+        } else if(0 == CompareVersionKey(oBlock.oKey, L"VarFileInfo")) {
+            DecodeVarFileInfo(pRawInfo, oBlock.nChildOffset, oBlock.nEndOffset);
+        }
+    }
+
+    return true;
+}
+
+template <class T>
+void
+PEVersionInfoT<T>::DecodeStringFileInfo(UINT8 *pRawInfo, UINT32 nBeginOffset, UINT32 nEndOffset)
+{
+    PEVersionBlock oTableBlock, oStringBlock;
+    for(UINT32 nTableOffset = nBeginOffset; ReadVersionBlock(pRawInfo, nTableOffset, nEndOffset, oTableBlock); nTableOffset = AlignVersionOffset(oTableBlock.nEndOffset, nEndOffset)) {
+        StringTableInfo oTableInfo;
+        oTableInfo.m_oKey = oTableBlock.oKey;
+        oTableInfo.m_nFirstStringIndex = (UINT32)m_vStrings.size();
+        oTableInfo.m_nStringCount = 0;
+
+        for(UINT32 nStringOffset = oTableBlock.nChildOffset; ReadVersionBlock(pRawInfo, nStringOffset, oTableBlock.nEndOffset, oStringBlock); nStringOffset = AlignVersionOffset(oStringBlock.nEndOffset, oTableBlock.nEndOffset)) {
+            StringInfo oStringInfo;
+            oStringInfo.m_oKey = oStringBlock.oKey;
+            oStringInfo.m_oValue.pString = (const wchar_t *)(pRawInfo + oStringBlock.nValueOffset);
+            oStringInfo.m_oValue.nLength = 0;
+
+            // The value usually counts its terminator, which is not a part of the view.
+            const UINT16 *pValueUnits = GetStringViewUnits(oStringInfo.m_oValue);
+            UINT32 nMaxLength = oStringBlock.nValueSize / sizeof(UINT16);
+            while(oStringInfo.m_oValue.nLength < nMaxLength && 0 != pValueUnits[oStringInfo.m_oValue.nLength]) {
+                ++oStringInfo.m_oValue.nLength;
+            }
+
+            m_vStrings.push_back(oStringInfo);
+            ++oTableInfo.m_nStringCount;
+        }
+
+        m_vStringTables.push_back(oTableInfo);
+    }
+}
+
+template <class T>
+void
+PEVersionInfoT<T>::DecodeVarFileInfo(UINT8 *pRawInfo, UINT32 nBeginOffset, UINT32 nEndOffset)
+{
+    PEVersionBlock oVarBlock;
+    for(UINT32 nVarOffset = nBeginOffset; ReadVersionBlock(pRawInfo, nVarOffset, nEndOffset, oVarBlock); nVarOffset = AlignVersionOffset(oVarBlock.nEndOffset, nEndOffset)) {
+        if(NULL == m_pTranslations && 0 == CompareVersionKey(oVarBlock.oKey, L"Translation")) {
+            m_pTranslations = pRawInfo + oVarBlock.nValueOffset;
+            m_nTranslationCount = oVarBlock.nValueSize / (2 * sizeof(UINT16));
+        }
+    }
+}
+
+template <class T>
+HRESULT
+PEVersionInfoT<T>::GetStringTableKey(UINT32 nTableIndex, PEStringView *pKey)
+{
+    LIBPE_ASSERT_RET(NULL != pKey, E_POINTER);
+    LIBPE_ASSERT_RET(nTableIndex < GetStringTableCount(), E_INVALIDARG);
+
+    *pKey = m_vStringTables[nTableIndex].m_oKey;
+
+    return S_OK;
+}
+
+template <class T>
+UINT32
+PEVersionInfoT<T>::GetStringCount(UINT32 nTableIndex)
+{
+    LIBPE_ASSERT_RET(nTableIndex < GetStringTableCount(), 0);
+    return m_vStringTables[nTableIndex].m_nStringCount;
+}
+
+template <class T>
+HRESULT
+PEVersionInfoT<T>::GetStringByIndex(UINT32 nTableIndex, UINT32 nStringIndex, PEStringView *pKey, PEStringView *pValue)
+{
+    LIBPE_ASSERT_RET(NULL != pKey || NULL != pValue, E_POINTER);
+    LIBPE_ASSERT_RET(nTableIndex < GetStringTableCount(), E_INVALIDARG);
+
+    const StringTableInfo &oTableInfo = m_vStringTables[nTableIndex];
+    LIBPE_ASSERT_RET(nStringIndex < oTableInfo.m_nStringCount, E_INVALIDARG);
+
+    const StringInfo &oStringInfo = m_vStrings[oTableInfo.m_nFirstStringIndex + nStringIndex];
+    if(NULL != pKey) {
+        *pKey = oStringInfo.m_oKey;
+    }
+    if(NULL != pValue) {
+        *pValue = oStringInfo.m_oValue;
+    }
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEVersionInfoT<T>::GetString(const wchar_t *pKey, PEStringView *pValue)
+{
+    LIBPE_ASSERT_RET(NULL != pKey && NULL != pValue, E_POINTER);
+
+    // The strings are kept table by table, so the first match is in the first table which has the key.
+    typename StringList::iterator itString;
+    for(itString = m_vStrings.begin(); itString != m_vStrings.end(); ++itString) {
+        if(0 == CompareVersionKey(itString->m_oKey, pKey)) {
+            *pValue = itString->m_oValue;
+            return S_OK;
+        }
+    }
+
+    return E_FAIL;
+}
+
+template <class T>
+HRESULT
+PEVersionInfoT<T>::GetTranslation(UINT32 nIndex, UINT16 *pLanguage, UINT16 *pCodePage)
+{
+    LIBPE_ASSERT_RET(NULL != pLanguage && NULL != pCodePage, E_POINTER);
+    LIBPE_ASSERT_RET(nIndex < m_nTranslationCount, E_INVALIDARG);
+
+    memcpy(pLanguage, m_pTranslations + nIndex * 2 * sizeof(UINT16), sizeof(UINT16));
+    memcpy(pCodePage, m_pTranslations + nIndex * 2 * sizeof(UINT16) + sizeof(UINT16), sizeof(UINT16));
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEVersionInfoT<T>::ConvertToUTF8(const PEStringView *pString, char *pBuffer, UINT32 nBufferSize, UINT32 *pSize)
+{
+    LIBPE_ASSERT_RET(NULL != pString && NULL != pSize, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != pBuffer || 0 == nBufferSize, E_POINTER);
+
+    // Once a character does not fit, nothing else is written, and a short buffer gets an empty string, not a part of it.
+    const UINT16 *pUnits = GetStringViewUnits(*pString);
+    UINT32 nSize = 0;
+    BOOL bIsFitting = true;
+    for(UINT32 nIndex = 0; nIndex < pString->nLength; ++nIndex) {
+        UINT32 nCodePoint = pUnits[nIndex];
+        if(nCodePoint >= 0xD800 && nCodePoint <= 0xDBFF && nIndex + 1 < pString->nLength) {
+            UINT32 nLowSurrogate = pUnits[nIndex + 1];
+            if(nLowSurrogate >= 0xDC00 && nLowSurrogate <= 0xDFFF) {
+                nCodePoint = 0x10000 + ((nCodePoint - 0xD800) << 10) + (nLowSurrogate - 0xDC00);
+                ++nIndex;
+            }
+        }
+
+        // The surrogates without their pair are replaced, because they cannot be encoded in UTF-8.
+        if(nCodePoint >= 0xD800 && nCodePoint <= 0xDFFF) {
+            nCodePoint = 0xFFFD;
+        }
+
+        char pBytes[4];
+        UINT32 nByteCount = 0;
+        if(nCodePoint < 0x80) {
+            pBytes[nByteCount++] = (char)nCodePoint;
+        } else if(nCodePoint < 0x800) {
+            pBytes[nByteCount++] = (char)(0xC0 | (nCodePoint >> 6));
+            pBytes[nByteCount++] = (char)(0x80 | (nCodePoint & 0x3F));
+        } else if(nCodePoint < 0x10000) {
+            pBytes[nByteCount++] = (char)(0xE0 | (nCodePoint >> 12));
+            pBytes[nByteCount++] = (char)(0x80 | ((nCodePoint >> 6) & 0x3F));
+            pBytes[nByteCount++] = (char)(0x80 | (nCodePoint & 0x3F));
+        } else {
+            pBytes[nByteCount++] = (char)(0xF0 | (nCodePoint >> 18));
+            pBytes[nByteCount++] = (char)(0x80 | ((nCodePoint >> 12) & 0x3F));
+            pBytes[nByteCount++] = (char)(0x80 | ((nCodePoint >> 6) & 0x3F));
+            pBytes[nByteCount++] = (char)(0x80 | (nCodePoint & 0x3F));
+        }
+
+        if(bIsFitting && nSize + nByteCount < nBufferSize) {
+            memcpy(pBuffer + nSize, pBytes, nByteCount);
+        } else {
+            bIsFitting = false;
+        }
+        nSize += nByteCount;
+    }
+
+    *pSize = nSize + 1;
+
+    if(nBufferSize > 0) {
+        pBuffer[bIsFitting ? nSize : 0] = 0;
+    }
+
+    return (*pSize <= nBufferSize) ? S_OK : E_INVALIDARG;
+}
+
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEVersionInfoT);
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
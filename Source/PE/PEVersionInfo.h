@@ -0,0 +1,60 @@
+#pragma once
+
+#include "PE/PEElement.h"
+
+LIBPE_NAMESPACE_BEGIN
+
+// The VS_VERSIONINFO is decoded once when the element is created. Only the positions of its strings are kept, and the
+// strings themselves stay in the resource.
+template <class T>
+class PEVersionInfoT :
+    public IPEVersionInfo,
+    public PEElementT<T>
+{
+    struct StringTableInfo {
+        PEStringView    m_oKey;
+        UINT32          m_nFirstStringIndex;
+        UINT32          m_nStringCount;
+    };
+    typedef std::vector<StringTableInfo> StringTableList;
+
+    struct StringInfo {
+        PEStringView    m_oKey;
+        PEStringView    m_oValue;
+    };
+    typedef std::vector<StringInfo> StringList;
+
+public:
+    PEVersionInfoT() : m_pFixedFileInfo(NULL), m_pTranslations(NULL), m_nTranslationCount(0) {}
+    virtual ~PEVersionInfoT() {}
+
+    DECLARE_PE_ELEMENT(UINT8)
+
+    BOOL Decode();
+
+    virtual PERawFixedFileInfo * LIBPE_CALLTYPE GetFixedFileInfo() { return m_pFixedFileInfo; }
+    virtual UINT32 LIBPE_CALLTYPE GetStringTableCount() { return (UINT32)m_vStringTables.size(); }
+    virtual HRESULT LIBPE_CALLTYPE GetStringTableKey(UINT32 nTableIndex, PEStringView *pKey);
+    virtual UINT32 LIBPE_CALLTYPE GetStringCount(UINT32 nTableIndex);
+    virtual HRESULT LIBPE_CALLTYPE GetStringByIndex(UINT32 nTableIndex, UINT32 nStringIndex, PEStringView *pKey, PEStringView *pValue);
+    virtual HRESULT LIBPE_CALLTYPE GetString(const wchar_t *pKey, PEStringView *pValue);
+    virtual UINT32 LIBPE_CALLTYPE GetTranslationCount() { return m_nTranslationCount; }
+    virtual HRESULT LIBPE_CALLTYPE GetTranslation(UINT32 nIndex, UINT16 *pLanguage, UINT16 *pCodePage);
+    virtual HRESULT LIBPE_CALLTYPE ConvertToUTF8(const PEStringView *pString, char *pBuffer, UINT32 nBufferSize, UINT32 *pSize);
+
+protected:
+    void DecodeStringFileInfo(UINT8 *pRawInfo, UINT32 nBeginOffset, UINT32 nEndOffset);
+    void DecodeVarFileInfo(UINT8 *pRawInfo, UINT32 nBeginOffset, UINT32 nEndOffset);
+
+private:
+    PERawFixedFileInfo      *m_pFixedFileInfo;
+    StringTableList         m_vStringTables;
+    StringList              m_vStrings;
+    UINT8                   *m_pTranslations;
+    UINT32                  m_nTranslationCount;
+};
+
+typedef PEVersionInfoT<PE32> PEVersionInfo32;
+typedef PEVersionInfoT<PE64> PEVersionInfo64;
+
+LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -1,15 +1,236 @@
 #include "stdafx.h"
 #include "Parser/DataLoader.h"
 
+#ifdef LIBPE_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 LIBPE_NAMESPACE_BEGIN
 
+enum {
+    MAX_COALESCED_BLOCK_COUNT   = 64,
+    MAX_STREAM_READ_SIZE        = 0x40000000,
+    READ_AHEAD_THREAD_COUNT     = 4,
+};
+
+#ifdef LIBPE_USE_SSE2
+static UINT32
+GetLowestSetBitIndex(UINT32 nMask)
+{
+#ifdef _MSC_VER
+    unsigned long nIndex = 0;
+    _BitScanForward(&nIndex, nMask);
+    return (UINT32)nIndex;
+#else
+    return (UINT32)__builtin_ctz(nMask);
+#endif
+}
+#endif
+
+// Find the first zero byte in [pBegin, pEnd).
+static const INT8 *
+FindAnsiTerminator(const INT8 *pBegin, const INT8 *pEnd)
+{
+    const INT8 *pCur = pBegin;
+
+#ifdef LIBPE_USE_SSE2
+    const __m128i oZero = _mm_setzero_si128();
+    while(pEnd - pCur >= (INT64)sizeof(__m128i)) {
+        UINT32 nMask = (UINT32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)pCur), oZero));
+        if(0 != nMask) {
+            return pCur + GetLowestSetBitIndex(nMask);
+        }
+        pCur += sizeof(__m128i);
+    }
+#endif
+
+    while(pCur < pEnd) {
+        if(0 == *pCur) {
+            return pCur;
+        }
+        ++pCur;
+    }
+
+    return NULL;
+}
+
+// Find the first zero UTF-16 unit in [pBegin, pEnd). The units are counted from pBegin, so a zero byte pair
+// across two units is not a terminator. The trailing odd byte, if any, is ignored.
+static const INT8 *
+FindUnicodeTerminator(const INT8 *pBegin, const INT8 *pEnd)
+{
+    const INT8 *pCur = pBegin;
+
+#ifdef LIBPE_USE_SSE2
+    // Each lane is loaded from pCur, so the 16-bit lanes are always the units of the string, even if it is not aligned.
+    const __m128i oZero = _mm_setzero_si128();
+    while(pEnd - pCur >= (INT64)sizeof(__m128i)) {
+        UINT32 nMask = (UINT32)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)pCur), oZero));
+        if(0 != nMask) {
+            return pCur + GetLowestSetBitIndex(nMask);
+        }
+        pCur += sizeof(__m128i);
+    }
+#endif
+
+    while(pEnd - pCur >= (INT64)sizeof(UINT16)) {
+        if(0 == pCur[0] && 0 == pCur[1]) {
+            return pCur;
+        }
+        pCur += sizeof(UINT16);
+    }
+
+    return NULL;
+}
+
+// The read-ahead of all the disk file loaders is done by a few threads shared by them, so opening a file costs no thread.
+// A loader is either in the queue or served by one thread at most, so the runs of one loader are read one by one.
+class DataLoaderReadAheadPool
+{
+public:
+    static DataLoaderReadAheadPool * GetInstance();
+
+    void Schedule(DataLoaderDiskFile *pLoader);
+    void Cancel(DataLoaderDiskFile *pLoader);
+
+protected:
+    DataLoaderReadAheadPool() {}
+    ~DataLoaderReadAheadPool() {}
+
+    UINT32 Start();
+    BOOL IsLoaderRunning(DataLoaderDiskFile *pLoader);
+    static void WorkerThreadProc(void *pParam);
+    void RunWorker();
+
+private:
+    Mutex                               m_oLock;
+    Condition                           m_oCondition;
+    std::list<DataLoaderDiskFile *>     m_lstQueuedLoaders;
+    std::vector<DataLoaderDiskFile *>   m_vRunningLoaders;
+    Thread                              m_pThreads[READ_AHEAD_THREAD_COUNT];
+};
+
+static Mutex                    s_oReadAheadPoolLock;
+static DataLoaderReadAheadPool  *s_pReadAheadPool = NULL;
+
+DataLoaderReadAheadPool *
+DataLoaderReadAheadPool::GetInstance()
+{
+    ScopedLock oLock(s_oReadAheadPoolLock);
+
+    // The pool is never destroyed. Joining its threads while the process is exiting could dead lock in the DLL loader.
+    if(NULL == s_pReadAheadPool) {
+        DataLoaderReadAheadPool *pPool = new DataLoaderReadAheadPool;
+        if(NULL == pPool) {
+            return NULL;
+        }
+
+        if(0 == pPool->Start()) {
+            delete pPool;
+            return NULL;
+        }
+
+        s_pReadAheadPool = pPool;
+    }
+
+    return s_pReadAheadPool;
+}
+
+void
+DataLoaderReadAheadPool::Schedule(DataLoaderDiskFile *pLoader)
+{
+    ScopedLock oLock(m_oLock);
+
+    // The loader being served is queued again by its thread, if it has more runs then.
+    if(IsLoaderRunning(pLoader) || std::find(m_lstQueuedLoaders.begin(), m_lstQueuedLoaders.end(), pLoader) != m_lstQueuedLoaders.end()) {
+        return;
+    }
+
+    m_lstQueuedLoaders.push_back(pLoader);
+    m_oCondition.NotifyAll();
+}
+
+void
+DataLoaderReadAheadPool::Cancel(DataLoaderDiskFile *pLoader)
+{
+    ScopedLock oLock(m_oLock);
+
+    m_lstQueuedLoaders.remove(pLoader);
+    while(IsLoaderRunning(pLoader)) {
+        m_oCondition.Wait(m_oLock);
+    }
+}
+
+UINT32
+DataLoaderReadAheadPool::Start()
+{
+    UINT32 nStartedThreadCount = 0;
+    for(UINT32 nThreadIndex = 0; nThreadIndex < READ_AHEAD_THREAD_COUNT; ++nThreadIndex) {
+        if(m_pThreads[nThreadIndex].Start(WorkerThreadProc, this)) {
+            ++nStartedThreadCount;
+        }
+    }
+
+    return nStartedThreadCount;
+}
+
+BOOL
+DataLoaderReadAheadPool::IsLoaderRunning(DataLoaderDiskFile *pLoader)
+{
+    return (std::find(m_vRunningLoaders.begin(), m_vRunningLoaders.end(), pLoader) != m_vRunningLoaders.end());
+}
+
+void
+DataLoaderReadAheadPool::WorkerThreadProc(void *pParam)
+{
+    DataLoaderReadAheadPool *pPool = (DataLoaderReadAheadPool *)pParam;
+    pPool->RunWorker();
+}
+
+void
+DataLoaderReadAheadPool::RunWorker()
+{
+    m_oLock.Lock();
+    for(;;) {
+        while(m_lstQueuedLoaders.empty()) {
+            m_oCondition.Wait(m_oLock);
+        }
+
+        DataLoaderDiskFile *pLoader = m_lstQueuedLoaders.front();
+        m_lstQueuedLoaders.pop_front();
+        m_vRunningLoaders.push_back(pLoader);
+        m_oLock.Unlock();
+
+        pLoader->RunReadAhead();
+
+        m_oLock.Lock();
+        m_vRunningLoaders.erase(std::find(m_vRunningLoaders.begin(), m_vRunningLoaders.end(), pLoader));
+
+        // Each loader gets one run at a time, so a file with a lot of runs can't hold up the others.
+        if(pLoader->HasReadAheadRuns()) {
+            m_lstQueuedLoaders.push_back(pLoader);
+        }
+        m_oCondition.NotifyAll();
+    }
+}
+
 DataLoaderDiskFile::DataLoaderDiskFile()
-    : m_hFile(NULL)
-    , m_pFileBuffer(NULL)
+#ifdef LIBPE_WINOS
+    : m_hFile(INVALID_HANDLE_VALUE)
+#else
+    : m_hFile(-1)
+#endif
     , m_nFileSize(0)
-    , m_pBlockStatus(NULL)
-    , m_nBlockStatusCount(0)
     , m_nBlockSize(0)
+    , m_nMaxCacheSize(0)
+    , m_nCachedSize(0)
+    , m_nPinnedSize(0)
+    , m_bReadAheadEnabled(false)
+    , m_bReadAheadInFlight(false)
+    , m_nReadAheadPendingSize(0)
 {
 
 }
@@ -22,189 +243,1020 @@ DataLoaderDiskFile::~DataLoaderDiskFile()
 BOOL
 DataLoaderDiskFile::LoadFile(const file_t &strPath)
 {
+    Reset();
+
+#ifdef LIBPE_WINOS
     m_hFile = ::CreateFile(strPath.c_str(), FILE_GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
     if(INVALID_HANDLE_VALUE == m_hFile) {
         return false;
     }
 
-    LONG nFileSizeHigh = 0;
-    DWORD nFileSizeLow = ::SetFilePointer(m_hFile, 0, &nFileSizeHigh, FILE_END);
-    m_nFileSize = ((UINT64)nFileSizeHigh) << 32 | nFileSizeLow;
-    m_nBlockSize = GetPreferredPELoaderIOBlockSize(m_nFileSize);
-
-    m_pFileBuffer = new INT8[(INT32)m_nFileSize];
-    LIBPE_ASSERT_RET(0 != m_nBlockSize, false);
-
-    nFileSizeHigh = 0;
-    ::SetFilePointer(m_hFile, 0, &nFileSizeHigh, FILE_BEGIN);
+    LARGE_INTEGER nFileSize;
+    if(!::GetFileSizeEx(m_hFile, &nFileSize) || 0 == nFileSize.QuadPart) {
+        Reset();
+        return false;
+    }
+    m_nFileSize = (UINT64)nFileSize.QuadPart;
+#else
+    m_hFile = ::open(strPath.c_str(), O_RDONLY);
+    if(-1 == m_hFile) {
+        return false;
+    }
 
-    m_nBlockStatusCount = (INT32)(m_nFileSize / m_nBlockSize + ((m_nFileSize & (m_nBlockSize - 1)) > 0 ? 1 : 0));
-    m_pBlockStatus = new BOOL[m_nBlockStatusCount];
-    memset(m_pBlockStatus, 0, m_nBlockStatusCount * sizeof(BOOL));
+    struct stat oFileStat;
+    if(0 != ::fstat(m_hFile, &oFileStat) || 0 >= oFileStat.st_size) {
+        Reset();
+        return false;
+    }
+    m_nFileSize = (UINT64)oFileStat.st_size;
+#endif
 
-    if(NULL == m_pFileBuffer || NULL == m_pBlockStatus) {
+    m_nBlockSize = GetPreferredPELoaderIOBlockSize(m_nFileSize);
+    m_nMaxCacheSize = GetPreferredPELoaderCacheSize();
+    if(0 == m_nBlockSize) {
         Reset();
         return false;
     }
 
+    if(IsPELoaderAsyncReadAheadEnabled()) {
+        StartReadAhead();
+    }
+
     return true;
 }
 
 void *
 DataLoaderDiskFile::GetBuffer(UINT64 nOffset, UINT64 nSize)
 {
-    if(NULL == m_pFileBuffer || NULL == m_pBlockStatus) {
+    if(nOffset >= m_nFileSize || nSize > m_nFileSize - nOffset) {
         return NULL;
     }
 
-    INT32 nStartBlockId = GetBlockId(nOffset), nEndBlockId = GetBlockId(nOffset + nSize);
-    if(0 > nStartBlockId || 0 > nEndBlockId) {
-        return NULL;
-    }
-
-    for(int nBlockId = nStartBlockId; nBlockId <= nEndBlockId; ++nBlockId) {
-        if(!ReadBlock(nBlockId)) {
+    UINT64 nStartBlockId = GetBlockId(nOffset);
+    UINT64 nEndBlockId = (0 == nSize) ? nStartBlockId : GetBlockId(nOffset + nSize - 1);
+    if(nStartBlockId != nEndBlockId) {
+        // A span buffer stays in memory as long as it is used, so one larger than the whole cache is never made.
+        if(nSize > m_nMaxCacheSize) {
             return NULL;
         }
+        return GetSpanBuffer(nOffset, nSize);
+    }
+
+    // The caller keeps this pointer until it releases the buffer, so the block can't be evicted before that.
+    CacheBlock *pBlock = ReadBlock(nStartBlockId);
+    if(NULL == pBlock) {
+        return NULL;
     }
 
-    return &(m_pFileBuffer[nOffset]);
+    PinBlock(pBlock);
+
+    return &(pBlock->pData[nOffset - nStartBlockId * m_nBlockSize]);
 }
 
 const char *
 DataLoaderDiskFile::GetAnsiString(UINT64 nOffset, UINT64 &nSize)
 {
-    if(nOffset >= m_nFileSize) {
+    UINT64 nStringSize = 0;
+    if(!FindTerminator(nOffset, sizeof(char), nStringSize)) {
         return NULL;
     }
 
-    INT32 nStartBlockId = GetBlockId(nOffset), nReadyBlockId = -1;
-    if(0 > nStartBlockId) {
+    const char *pString = (const char *)GetBuffer(nOffset, nStringSize);
+    if(NULL != pString) {
+        nSize = nStringSize;
+    }
+
+    return pString;
+}
+
+const wchar_t *
+DataLoaderDiskFile::GetUnicodeString(UINT64 nOffset, UINT64 &nSize)
+{
+    // Strings in PE file are always UTF-16, so we should check the whole 16-bit unit instead of a single byte.
+    UINT64 nStringSize = 0;
+    if(!FindTerminator(nOffset, sizeof(UINT16), nStringSize)) {
         return NULL;
     }
 
-    UINT64 nCurOffset = nOffset, nBlockEnd = 0;
-    for(;;) {
-        if(nReadyBlockId != nStartBlockId) {
-            if(!ReadBlock(nStartBlockId)) {
-                break;
+    const wchar_t *pString = (const wchar_t *)GetBuffer(nOffset, nStringSize);
+    if(NULL != pString) {
+        nSize = nStringSize;
+    }
+
+    return pString;
+}
+
+void
+DataLoaderDiskFile::ReleaseBuffer(void *pBuffer, UINT64 nOffset, UINT64 nSize)
+{
+    if(NULL == pBuffer || nOffset >= m_nFileSize || nSize > m_nFileSize - nOffset) {
+        return;
+    }
+
+    UINT64 nStartBlockId = GetBlockId(nOffset);
+    UINT64 nEndBlockId = (0 == nSize) ? nStartBlockId : GetBlockId(nOffset + nSize - 1);
+    if(nStartBlockId == nEndBlockId) {
+        CacheBlockMap::iterator itBlock = m_mapBlocks.find(nStartBlockId);
+        if(itBlock != m_mapBlocks.end() && 0 != itBlock->second.nPinCount) {
+            UnpinBlock(nStartBlockId, &(itBlock->second));
+        }
+        return;
+    }
+
+    SpanBufferMap::iterator itSpanBuffer = m_mapSpanBuffers.find(nOffset);
+    if(itSpanBuffer != m_mapSpanBuffers.end() && ReleaseSpanBuffer(itSpanBuffer->second, pBuffer)) {
+        if(0 == itSpanBuffer->second.nRefCount) {
+            m_mapSpanBuffers.erase(itSpanBuffer);
+        }
+        return;
+    }
+
+    // The buffer was replaced by a larger one with the same offset.
+    std::vector<SpanBuffer>::iterator itRetiredSpanBuffer = m_vRetiredSpanBuffers.begin();
+    while(itRetiredSpanBuffer != m_vRetiredSpanBuffers.end()) {
+        if(ReleaseSpanBuffer(*itRetiredSpanBuffer, pBuffer)) {
+            if(0 == itRetiredSpanBuffer->nRefCount) {
+                m_vRetiredSpanBuffers.erase(itRetiredSpanBuffer);
             }
-            nReadyBlockId = nStartBlockId;
-            nBlockEnd = (nStartBlockId + 1) * m_nBlockSize;
+            return;
         }
+        ++itRetiredSpanBuffer;
+    }
+}
+
+BOOL
+DataLoaderDiskFile::ReadData(UINT64 nOffset, void *pBuffer, UINT64 nSize)
+{
+    if(nOffset >= m_nFileSize || nSize > m_nFileSize - nOffset) {
+        return false;
+    }
 
-        while(nCurOffset < nBlockEnd) {
-            if(0 == m_pFileBuffer[nCurOffset]) {
-                nSize = nCurOffset - nOffset + 1;
-                return (const char *)&(m_pFileBuffer[nOffset]);
+    // The blocks in the cache are copied as they are. The others are read into the buffer of the caller directly,
+    // so streaming a large range neither pins the blocks nor evicts the ones which are still in use.
+    INT8 *pReadBuffer = (INT8 *)pBuffer;
+    while(nSize > 0) {
+        UINT64 nBlockId = GetBlockId(nOffset);
+        UINT64 nOffsetInBlock = nOffset - nBlockId * m_nBlockSize;
+        CacheBlockMap::iterator itBlock = m_mapBlocks.find(nBlockId);
+        if(itBlock != m_mapBlocks.end()) {
+            UINT64 nCopySize = itBlock->second.nSize - nOffsetInBlock;
+            if(nCopySize > nSize) {
+                nCopySize = nSize;
             }
-            ++nCurOffset;
+
+            memcpy(pReadBuffer, &(itBlock->second.pData[nOffsetInBlock]), (size_t)nCopySize);
+            pReadBuffer += nCopySize;
+            nOffset += nCopySize;
+            nSize -= nCopySize;
+            continue;
+        }
+
+        // Read all the adjacent blocks which are not cached with a single I/O.
+        UINT64 nRunSize = GetBlockSize(nBlockId) - nOffsetInBlock;
+        while(nRunSize < nSize && nRunSize < MAX_STREAM_READ_SIZE && m_mapBlocks.find(GetBlockId(nOffset + nRunSize)) == m_mapBlocks.end()) {
+            nRunSize += GetBlockSize(GetBlockId(nOffset + nRunSize));
+        }
+
+        if(nRunSize > nSize) {
+            nRunSize = nSize;
+        }
+
+        if(nRunSize > MAX_STREAM_READ_SIZE) {
+            nRunSize = MAX_STREAM_READ_SIZE;
         }
 
-        ++nStartBlockId;
+        if(!ReadFileData(nOffset, pReadBuffer, (UINT32)nRunSize)) {
+            return false;
+        }
+
+        pReadBuffer += nRunSize;
+        nOffset += nRunSize;
+        nSize -= nRunSize;
     }
 
-    return NULL;
+    return true;
 }
 
-const wchar_t *
-DataLoaderDiskFile::GetUnicodeString(UINT64 nOffset, UINT64 &nSize)
+void
+DataLoaderDiskFile::Prefetch(UINT64 nOffset, UINT64 nSize)
 {
-    if(nOffset >= m_nFileSize) {
-        return NULL;
+    if(nOffset >= m_nFileSize || 0 == nSize) {
+        return;
+    }
+
+    // Prefetching more than the cache can hold only evicts the blocks we have just read.
+    if(nSize > m_nFileSize - nOffset) {
+        nSize = m_nFileSize - nOffset;
+    }
+
+    if(nSize > m_nMaxCacheSize) {
+        nSize = m_nMaxCacheSize;
+    }
+
+    if(m_bReadAheadEnabled) {
+        QueueReadAhead(GetBlockId(nOffset), GetBlockId(nOffset + nSize - 1));
+        return;
+    }
+
+    LoadBlocks(GetBlockId(nOffset), GetBlockId(nOffset + nSize - 1));
+}
+
+void
+DataLoaderDiskFile::Reset()
+{
+    // The read-ahead thread uses the file handle, so it must be stopped before everything else.
+    StopReadAhead();
+
+#ifdef LIBPE_WINOS
+    if(INVALID_HANDLE_VALUE != m_hFile) {
+        ::CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+#else
+    if(-1 != m_hFile) {
+        ::close(m_hFile);
+        m_hFile = -1;
+    }
+#endif
+
+    CacheBlockMap::iterator itBlock = m_mapBlocks.begin();
+    while(itBlock != m_mapBlocks.end()) {
+        delete [] itBlock->second.pData;
+        ++itBlock;
+    }
+    m_mapBlocks.clear();
+    m_lstLRUBlocks.clear();
+
+    SpanBufferMap::iterator itSpanBuffer = m_mapSpanBuffers.begin();
+    while(itSpanBuffer != m_mapSpanBuffers.end()) {
+        delete [] itSpanBuffer->second.pData;
+        ++itSpanBuffer;
+    }
+    m_mapSpanBuffers.clear();
+
+    std::vector<SpanBuffer>::iterator itRetiredSpanBuffer = m_vRetiredSpanBuffers.begin();
+    while(itRetiredSpanBuffer != m_vRetiredSpanBuffers.end()) {
+        delete [] itRetiredSpanBuffer->pData;
+        ++itRetiredSpanBuffer;
+    }
+    m_vRetiredSpanBuffers.clear();
+
+    m_nFileSize = 0;
+    m_nBlockSize = 0;
+    m_nCachedSize = 0;
+    m_nPinnedSize = 0;
+}
+
+DataLoaderDiskFile::CacheBlock *
+DataLoaderDiskFile::ReadBlock(UINT64 nBlockId)
+{
+    CacheBlockMap::iterator itBlock = m_mapBlocks.find(nBlockId);
+    if(itBlock != m_mapBlocks.end()) {
+        CacheBlock *pBlock = &(itBlock->second);
+        if(0 == pBlock->nPinCount) {
+            m_lstLRUBlocks.splice(m_lstLRUBlocks.begin(), m_lstLRUBlocks, pBlock->itLRU);
+        }
+        return pBlock;
     }
 
-    INT32 nStartBlockId = GetBlockId(nOffset), nReadyBlockId = -1;
-    if(0 > nStartBlockId) {
+    if(m_bReadAheadEnabled) {
+        WaitForReadAhead(nBlockId, nBlockId);
+        itBlock = m_mapBlocks.find(nBlockId);
+        if(itBlock != m_mapBlocks.end()) {
+            m_lstLRUBlocks.splice(m_lstLRUBlocks.begin(), m_lstLRUBlocks, itBlock->second.itLRU);
+            return &(itBlock->second);
+        }
+    }
+
+    if(!LoadBlockRun(nBlockId, nBlockId)) {
         return NULL;
     }
 
-    UINT64 nCurOffset = nOffset, nBlockEnd = 0;
-    for(;;) {
-        if(nReadyBlockId != nStartBlockId) {
-            if(!ReadBlock(nStartBlockId)) {
-                break;
+    return &(m_mapBlocks[nBlockId]);
+}
+
+UINT32
+DataLoaderDiskFile::GetBlockSize(UINT64 nBlockId)
+{
+    UINT64 nBlockBegin = nBlockId * m_nBlockSize;
+    if(nBlockBegin >= m_nFileSize) {
+        return 0;
+    }
+
+    return (UINT32)((m_nFileSize - nBlockBegin < m_nBlockSize) ? (m_nFileSize - nBlockBegin) : m_nBlockSize);
+}
+
+void
+DataLoaderDiskFile::LoadBlocks(UINT64 nStartBlockId, UINT64 nEndBlockId)
+{
+    if(m_bReadAheadEnabled) {
+        WaitForReadAhead(nStartBlockId, nEndBlockId);
+    }
+
+    // Find the runs of the adjacent blocks which are not loaded yet, and read each run with a single I/O.
+    UINT64 nBlockId = nStartBlockId;
+    while(nBlockId <= nEndBlockId) {
+        if(m_mapBlocks.find(nBlockId) != m_mapBlocks.end()) {
+            ++nBlockId;
+            continue;
+        }
+
+        UINT64 nRunEndBlockId = nBlockId;
+        while(nRunEndBlockId < nEndBlockId
+            && nRunEndBlockId - nBlockId + 1 < MAX_COALESCED_BLOCK_COUNT
+            && m_mapBlocks.find(nRunEndBlockId + 1) == m_mapBlocks.end()) {
+            ++nRunEndBlockId;
+        }
+
+        if(!LoadBlockRun(nBlockId, nRunEndBlockId)) {
+            return;
+        }
+
+        nBlockId = nRunEndBlockId + 1;
+    }
+}
+
+BOOL
+DataLoaderDiskFile::LoadBlockRun(UINT64 nStartBlockId, UINT64 nEndBlockId)
+{
+    UINT64 nRunSize = 0;
+    for(UINT64 nBlockId = nStartBlockId; nBlockId <= nEndBlockId; ++nBlockId) {
+        nRunSize += GetBlockSize(nBlockId);
+    }
+
+    EvictBlocks(nRunSize);
+
+    std::vector<INT8 *> vBlockData;
+    std::vector<UINT32> vBlockSize;
+    if(!ReadBlockRun(nStartBlockId, nEndBlockId, vBlockData, vBlockSize)) {
+        return false;
+    }
+
+    for(UINT32 nBlockIndex = 0; nBlockIndex < (UINT32)vBlockData.size(); ++nBlockIndex) {
+        AddBlock(nStartBlockId + nBlockIndex, vBlockData[nBlockIndex], vBlockSize[nBlockIndex]);
+    }
+
+    return true;
+}
+
+BOOL
+DataLoaderDiskFile::ReadBlockRun(UINT64 nStartBlockId, UINT64 nEndBlockId, std::vector<INT8 *> &vBlockData, std::vector<UINT32> &vBlockSize)
+{
+    // This function is also called by the read-ahead thread, so it must not touch the cache.
+    UINT32 nBlockCount = (UINT32)(nEndBlockId - nStartBlockId + 1);
+    UINT64 nRunBegin = nStartBlockId * m_nBlockSize;
+    UINT64 nRunSize = 0;
+
+    vBlockData.assign(nBlockCount, (INT8 *)NULL);
+    vBlockSize.assign(nBlockCount, 0);
+    for(UINT32 nBlockIndex = 0; nBlockIndex < nBlockCount; ++nBlockIndex) {
+        vBlockSize[nBlockIndex] = GetBlockSize(nStartBlockId + nBlockIndex);
+        nRunSize += vBlockSize[nBlockIndex];
+    }
+
+    if(0 == nRunSize || 0 == vBlockSize[nBlockCount - 1]) {
+        return false;
+    }
+
+    BOOL bSucceeded = true;
+    for(UINT32 nBlockIndex = 0; nBlockIndex < nBlockCount && bSucceeded; ++nBlockIndex) {
+        vBlockData[nBlockIndex] = new INT8[vBlockSize[nBlockIndex]];
+        bSucceeded = (NULL != vBlockData[nBlockIndex]);
+    }
+
+    if(bSucceeded) {
+#ifdef LIBPE_WINOS
+        // ReadFileScatter needs an unbuffered overlapped handle, so we read the run at once and split it.
+        INT8 *pRunBuffer = (1 == nBlockCount) ? vBlockData[0] : new INT8[(size_t)nRunSize];
+        bSucceeded = (NULL != pRunBuffer && ReadFileData(nRunBegin, pRunBuffer, (UINT32)nRunSize));
+        if(NULL != pRunBuffer && 1 != nBlockCount) {
+            UINT64 nCopiedSize = 0;
+            for(UINT32 nBlockIndex = 0; nBlockIndex < nBlockCount && bSucceeded; ++nBlockIndex) {
+                memcpy(vBlockData[nBlockIndex], &(pRunBuffer[nCopiedSize]), vBlockSize[nBlockIndex]);
+                nCopiedSize += vBlockSize[nBlockIndex];
             }
-            nReadyBlockId = nStartBlockId;
-            nBlockEnd = (nStartBlockId + 1) * m_nBlockSize;
+            delete [] pRunBuffer;
         }
+#else
+        std::vector<struct iovec> vIOVectors(nBlockCount);
+        for(UINT32 nBlockIndex = 0; nBlockIndex < nBlockCount; ++nBlockIndex) {
+            vIOVectors[nBlockIndex].iov_base = vBlockData[nBlockIndex];
+            vIOVectors[nBlockIndex].iov_len = vBlockSize[nBlockIndex];
+        }
+
+        ssize_t nReadSize = ::preadv(m_hFile, &(vIOVectors[0]), (int)nBlockCount, (off_t)nRunBegin);
+        UINT64 nRemainReadSize = (0 < nReadSize) ? (UINT64)nReadSize : 0;
 
-        while(nCurOffset < nBlockEnd) {
-            if(0 == m_pFileBuffer[nCurOffset]) {
-                nSize = nCurOffset - nOffset + 1;
-                return (const wchar_t *)&(m_pFileBuffer[nOffset]);
+        // preadv could return less than we asked for, so read the rest of each block one by one.
+        UINT64 nBlockBegin = nRunBegin;
+        for(UINT32 nBlockIndex = 0; nBlockIndex < nBlockCount && bSucceeded; ++nBlockIndex) {
+            UINT32 nBlockReadSize = (UINT32)((nRemainReadSize < vBlockSize[nBlockIndex]) ? nRemainReadSize : vBlockSize[nBlockIndex]);
+            if(nBlockReadSize < vBlockSize[nBlockIndex]) {
+                bSucceeded = ReadFileData(nBlockBegin + nBlockReadSize, &(vBlockData[nBlockIndex][nBlockReadSize]), vBlockSize[nBlockIndex] - nBlockReadSize);
             }
-            nCurOffset += sizeof(wchar_t);
+            nRemainReadSize -= nBlockReadSize;
+            nBlockBegin += vBlockSize[nBlockIndex];
         }
+#endif
+    }
 
-        ++nStartBlockId;
+    if(!bSucceeded) {
+        for(UINT32 nBlockIndex = 0; nBlockIndex < nBlockCount; ++nBlockIndex) {
+            delete [] vBlockData[nBlockIndex];
+        }
+        vBlockData.clear();
+        vBlockSize.clear();
+        return false;
     }
 
-    return NULL;
+    return true;
 }
 
 void
-DataLoaderDiskFile::Reset()
+DataLoaderDiskFile::AddBlock(UINT64 nBlockId, INT8 *pData, UINT32 nSize)
 {
-    if(INVALID_HANDLE_VALUE != m_hFile) {
-        ::CloseHandle(m_hFile);
-        m_hFile = NULL;
+    // The block might be read by both the read-ahead thread and us, so the later one is dropped.
+    if(m_mapBlocks.find(nBlockId) != m_mapBlocks.end()) {
+        delete [] pData;
+        return;
+    }
+
+    m_lstLRUBlocks.push_front(nBlockId);
+    m_nCachedSize += nSize;
+
+    CacheBlock *pBlock = &(m_mapBlocks[nBlockId]);
+    pBlock->pData = pData;
+    pBlock->nSize = nSize;
+    pBlock->nPinCount = 0;
+    pBlock->itLRU = m_lstLRUBlocks.begin();
+}
+
+void
+DataLoaderDiskFile::StartReadAhead()
+{
+    m_bReadAheadEnabled = (NULL != DataLoaderReadAheadPool::GetInstance());
+}
+
+void
+DataLoaderDiskFile::StopReadAhead()
+{
+    if(!m_bReadAheadEnabled) {
+        return;
     }
 
-    if(NULL != m_pFileBuffer) {
-        delete [] m_pFileBuffer;
-        m_pFileBuffer = NULL;
+    m_oReadAheadLock.Lock();
+    m_lstReadAheadRuns.clear();
+    m_oReadAheadLock.Unlock();
+
+    // The pool might be reading a run for us, and it must be done before the handle is closed.
+    DataLoaderReadAheadPool::GetInstance()->Cancel(this);
+
+    std::vector<ReadAheadBlock>::iterator itReadAheadBlock = m_vReadAheadBlocks.begin();
+    while(itReadAheadBlock != m_vReadAheadBlocks.end()) {
+        delete [] itReadAheadBlock->pData;
+        ++itReadAheadBlock;
     }
+    m_vReadAheadBlocks.clear();
+    m_nReadAheadPendingSize = 0;
+    m_bReadAheadEnabled = false;
+}
+
+void
+DataLoaderDiskFile::QueueReadAhead(UINT64 nStartBlockId, UINT64 nEndBlockId)
+{
+    BOOL bQueued = false;
 
-    if(NULL != m_pBlockStatus) {
-        delete [] m_pBlockStatus;
-        m_pBlockStatus = NULL;
+    m_oReadAheadLock.Lock();
+    TakeReadAheadBlocks();
+
+    UINT64 nBlockId = nStartBlockId;
+    while(nBlockId <= nEndBlockId) {
+        if(IsBlockLoadedOrQueued(nBlockId)) {
+            ++nBlockId;
+            continue;
+        }
+
+        UINT64 nRunEndBlockId = nBlockId;
+        while(nRunEndBlockId < nEndBlockId
+            && nRunEndBlockId - nBlockId + 1 < MAX_COALESCED_BLOCK_COUNT
+            && !IsBlockLoadedOrQueued(nRunEndBlockId + 1)) {
+            ++nRunEndBlockId;
+        }
+
+        UINT64 nRunSize = 0;
+        for(UINT64 nRunBlockId = nBlockId; nRunBlockId <= nRunEndBlockId; ++nRunBlockId) {
+            nRunSize += GetBlockSize(nRunBlockId);
+        }
+
+        // The blocks read ahead are not counted in the cache until we take them, so they are limited separately.
+        if(m_nReadAheadPendingSize + nRunSize > m_nMaxCacheSize) {
+            break;
+        }
+
+        ReadAheadRun oRun;
+        oRun.nStartBlockId = nBlockId;
+        oRun.nEndBlockId = nRunEndBlockId;
+        m_lstReadAheadRuns.push_back(oRun);
+        m_nReadAheadPendingSize += nRunSize;
+        bQueued = true;
+
+        nBlockId = nRunEndBlockId + 1;
     }
 
-    m_nFileSize = 0;
-    m_nBlockStatusCount = 0;
+    m_oReadAheadLock.Unlock();
+
+    if(bQueued) {
+        DataLoaderReadAheadPool::GetInstance()->Schedule(this);
+    }
 }
 
-INT32
-DataLoaderDiskFile::GetBlockId(UINT64 nOffset)
+BOOL
+DataLoaderDiskFile::IsBlockLoadedOrQueued(UINT64 nBlockId)
 {
-    if(nOffset >= m_nFileSize) {
-        return -1;
+    // The lock of read-ahead must be held by the caller.
+    if(m_mapBlocks.find(nBlockId) != m_mapBlocks.end()) {
+        return true;
     }
 
-    return (INT32)(nOffset / m_nBlockSize);
+    if(m_bReadAheadInFlight && m_oInFlightRun.nStartBlockId <= nBlockId && nBlockId <= m_oInFlightRun.nEndBlockId) {
+        return true;
+    }
+
+    std::list<ReadAheadRun>::iterator itRun = m_lstReadAheadRuns.begin();
+    while(itRun != m_lstReadAheadRuns.end()) {
+        if(itRun->nStartBlockId <= nBlockId && nBlockId <= itRun->nEndBlockId) {
+            return true;
+        }
+        ++itRun;
+    }
+
+    return false;
+}
+
+void
+DataLoaderDiskFile::TakeReadAheadBlocks()
+{
+    // The lock of read-ahead must be held by the caller.
+    std::vector<ReadAheadBlock>::iterator itReadAheadBlock = m_vReadAheadBlocks.begin();
+    while(itReadAheadBlock != m_vReadAheadBlocks.end()) {
+        EvictBlocks(itReadAheadBlock->nSize);
+        AddBlock(itReadAheadBlock->nBlockId, itReadAheadBlock->pData, itReadAheadBlock->nSize);
+        m_nReadAheadPendingSize -= itReadAheadBlock->nSize;
+        ++itReadAheadBlock;
+    }
+    m_vReadAheadBlocks.clear();
+}
+
+void
+DataLoaderDiskFile::WaitForReadAhead(UINT64 nStartBlockId, UINT64 nEndBlockId)
+{
+    ScopedLock oLock(m_oReadAheadLock);
+
+    // The runs which are still queued would be read later than by ourselves, so we take them back.
+    std::list<ReadAheadRun>::iterator itRun = m_lstReadAheadRuns.begin();
+    while(itRun != m_lstReadAheadRuns.end()) {
+        if(itRun->nEndBlockId < nStartBlockId || nEndBlockId < itRun->nStartBlockId) {
+            ++itRun;
+            continue;
+        }
+
+        for(UINT64 nBlockId = itRun->nStartBlockId; nBlockId <= itRun->nEndBlockId; ++nBlockId) {
+            m_nReadAheadPendingSize -= GetBlockSize(nBlockId);
+        }
+        itRun = m_lstReadAheadRuns.erase(itRun);
+    }
+
+    for(;;) {
+        TakeReadAheadBlocks();
+
+        // If the blocks we need are being read, waiting is always faster than reading them again.
+        if(!m_bReadAheadInFlight || m_oInFlightRun.nEndBlockId < nStartBlockId || nEndBlockId < m_oInFlightRun.nStartBlockId) {
+            break;
+        }
+
+        m_oReadAheadCondition.Wait(m_oReadAheadLock);
+    }
 }
 
 BOOL
-DataLoaderDiskFile::ReadBlock(INT32 nBlockId)
+DataLoaderDiskFile::HasReadAheadRuns()
 {
-    if(0 > nBlockId || nBlockId >= m_nBlockStatusCount) {
+    ScopedLock oLock(m_oReadAheadLock);
+    return !m_lstReadAheadRuns.empty();
+}
+
+void
+DataLoaderDiskFile::RunReadAhead()
+{
+    // This is called by a thread of the pool, which reads one run for us each time.
+    m_oReadAheadLock.Lock();
+    if(m_lstReadAheadRuns.empty()) {
+        m_oReadAheadLock.Unlock();
+        return;
+    }
+
+    m_oInFlightRun = m_lstReadAheadRuns.front();
+    m_lstReadAheadRuns.pop_front();
+    m_bReadAheadInFlight = true;
+    m_oReadAheadLock.Unlock();
+
+    std::vector<INT8 *> vBlockData;
+    std::vector<UINT32> vBlockSize;
+    BOOL bSucceeded = ReadBlockRun(m_oInFlightRun.nStartBlockId, m_oInFlightRun.nEndBlockId, vBlockData, vBlockSize);
+
+    m_oReadAheadLock.Lock();
+    UINT64 nRunSize = 0;
+    for(UINT64 nBlockId = m_oInFlightRun.nStartBlockId; nBlockId <= m_oInFlightRun.nEndBlockId; ++nBlockId) {
+        nRunSize += GetBlockSize(nBlockId);
+    }
+
+    if(bSucceeded) {
+        for(UINT32 nBlockIndex = 0; nBlockIndex < (UINT32)vBlockData.size(); ++nBlockIndex) {
+            ReadAheadBlock oBlock;
+            oBlock.nBlockId = m_oInFlightRun.nStartBlockId + nBlockIndex;
+            oBlock.pData = vBlockData[nBlockIndex];
+            oBlock.nSize = vBlockSize[nBlockIndex];
+            m_vReadAheadBlocks.push_back(oBlock);
+        }
+    } else {
+        m_nReadAheadPendingSize -= nRunSize;
+    }
+
+    m_bReadAheadInFlight = false;
+    m_oReadAheadCondition.NotifyAll();
+    m_oReadAheadLock.Unlock();
+}
+
+void
+DataLoaderDiskFile::PinBlock(CacheBlock *pBlock)
+{
+    if(0 == pBlock->nPinCount++) {
+        m_lstLRUBlocks.erase(pBlock->itLRU);
+        m_nCachedSize -= pBlock->nSize;
+        m_nPinnedSize += pBlock->nSize;
+    }
+}
+
+void
+DataLoaderDiskFile::UnpinBlock(UINT64 nBlockId, CacheBlock *pBlock)
+{
+    if(0 != --pBlock->nPinCount) {
+        return;
+    }
+
+    // The block has just been used, so it goes back to the front of the LRU list.
+    m_lstLRUBlocks.push_front(nBlockId);
+    pBlock->itLRU = m_lstLRUBlocks.begin();
+    m_nPinnedSize -= pBlock->nSize;
+    m_nCachedSize += pBlock->nSize;
+}
+
+BOOL
+DataLoaderDiskFile::ReleaseSpanBuffer(SpanBuffer &oSpanBuffer, void *pBuffer)
+{
+    if(oSpanBuffer.pData != pBuffer || 0 == oSpanBuffer.nRefCount) {
         return false;
     }
 
-    if(m_pBlockStatus[nBlockId] != 0) {
-        return true;
+    if(0 == --oSpanBuffer.nRefCount) {
+        m_nPinnedSize -= oSpanBuffer.nSize;
+        delete [] oSpanBuffer.pData;
+        oSpanBuffer.pData = NULL;
+    }
+
+    return true;
+}
+
+void
+DataLoaderDiskFile::EvictBlocks(UINT64 nNeedSize)
+{
+    // The pinned blocks and span buffers can't be evicted, but they take the room of the cache too.
+    while(!m_lstLRUBlocks.empty() && m_nCachedSize + m_nPinnedSize + nNeedSize > m_nMaxCacheSize) {
+        CacheBlockMap::iterator itBlock = m_mapBlocks.find(m_lstLRUBlocks.back());
+        m_lstLRUBlocks.pop_back();
+        if(itBlock == m_mapBlocks.end()) {
+            continue;
+        }
+
+        m_nCachedSize -= itBlock->second.nSize;
+        delete [] itBlock->second.pData;
+        m_mapBlocks.erase(itBlock);
+    }
+}
+
+BOOL
+DataLoaderDiskFile::ReadFileData(UINT64 nOffset, void *pBuffer, UINT32 nSize)
+{
+    INT8 *pReadBuffer = (INT8 *)pBuffer;
+    while(nSize > 0) {
+#ifdef LIBPE_WINOS
+        // The offset in OVERLAPPED is used by synchronous handles too, so we needn't move the file pointer.
+        OVERLAPPED oOverlapped;
+        memset(&oOverlapped, 0, sizeof(oOverlapped));
+        oOverlapped.Offset = (DWORD)(nOffset & 0xFFFFFFFF);
+        oOverlapped.OffsetHigh = (DWORD)((nOffset >> 32) & 0xFFFFFFFF);
+
+        DWORD nReadSize = 0;
+        if(!::ReadFile(m_hFile, pReadBuffer, nSize, &nReadSize, &oOverlapped) || 0 == nReadSize) {
+            return false;
+        }
+#else
+        ssize_t nReadSize = ::pread(m_hFile, pReadBuffer, nSize, (off_t)nOffset);
+        if(0 >= nReadSize) {
+            return false;
+        }
+#endif
+        pReadBuffer += nReadSize;
+        nOffset += nReadSize;
+        nSize -= (UINT32)nReadSize;
+    }
+
+    return true;
+}
+
+BOOL
+DataLoaderDiskFile::FindTerminator(UINT64 nOffset, UINT32 nCharSize, UINT64 &nSize)
+{
+    UINT64 nCurOffset = nOffset;
+    while(nCurOffset < m_nFileSize && nCharSize <= m_nFileSize - nCurOffset) {
+        UINT64 nBlockId = GetBlockId(nCurOffset);
+        CacheBlock *pBlock = ReadBlock(nBlockId);
+        if(NULL == pBlock) {
+            return false;
+        }
+
+        UINT64 nBlockBegin = nBlockId * m_nBlockSize, nBlockEnd = nBlockBegin + pBlock->nSize;
+        const INT8 *pScanBegin = &(pBlock->pData[nCurOffset - nBlockBegin]);
+        const INT8 *pScanEnd = pBlock->pData + pBlock->nSize;
+        const INT8 *pTerminator = (1 == nCharSize) ? FindAnsiTerminator(pScanBegin, pScanEnd) : FindUnicodeTerminator(pScanBegin, pScanEnd);
+        if(NULL != pTerminator) {
+            nSize = nCurOffset + (pTerminator - pScanBegin) + nCharSize - nOffset;
+            return true;
+        }
+
+        // Skip all the whole units in this block.
+        nCurOffset += (nBlockEnd - nCurOffset) / nCharSize * nCharSize;
+
+        // The string is not aligned with the block, so the last unit is split into two blocks.
+        if(nCurOffset < nBlockEnd) {
+            BOOL bLowByteZero = (0 == pBlock->pData[nCurOffset - nBlockBegin]);
+            CacheBlock *pNextBlock = ReadBlock(nBlockId + 1);
+            if(NULL == pNextBlock) {
+                return false;
+            }
+
+            if(bLowByteZero && 0 == pNextBlock->pData[0]) {
+                nSize = nCurOffset + nCharSize - nOffset;
+                return true;
+            }
+            nCurOffset += nCharSize;
+        }
+    }
+
+    return false;
+}
+
+void *
+DataLoaderDiskFile::GetSpanBuffer(UINT64 nOffset, UINT64 nSize)
+{
+    // The data across blocks is copied into a standalone buffer, so the blocks themselves can still be evicted.
+    SpanBufferMap::iterator itSpanBuffer = m_mapSpanBuffers.find(nOffset);
+    if(itSpanBuffer != m_mapSpanBuffers.end() && itSpanBuffer->second.nSize >= nSize) {
+        ++itSpanBuffer->second.nRefCount;
+        return itSpanBuffer->second.pData;
+    }
+
+    EvictBlocks(nSize);
+
+    INT8 *pSpanBuffer = new INT8[(size_t)nSize];
+    if(NULL == pSpanBuffer) {
+        return NULL;
+    }
+
+    // The blocks are not loaded into the cache for this, because the span buffer has the data already.
+    if(!ReadData(nOffset, pSpanBuffer, nSize)) {
+        delete [] pSpanBuffer;
+        return NULL;
     }
 
-    UINT64 nReadBegin = nBlockId * m_nBlockSize;
-    LONG nReadBeginHigh = ((nReadBegin >> 32) & 0xFFFFFFFF);
-    LONG nReadBeginLow = (nReadBegin & 0xFFFFFFFF);
-    DWORD nNeedSize = (DWORD)m_nBlockSize;
-    if(nBlockId * m_nBlockSize + nNeedSize > m_nFileSize) {
-        nNeedSize = (DWORD)(m_nFileSize - nBlockId * m_nBlockSize);
+    // The smaller buffer with the same offset is still in use, so it is kept until it is released.
+    if(itSpanBuffer != m_mapSpanBuffers.end()) {
+        m_vRetiredSpanBuffers.push_back(itSpanBuffer->second);
     }
 
-    ::SetFilePointer(m_hFile, nReadBeginLow, &nReadBeginHigh, FILE_BEGIN);
+    SpanBuffer &oSpanBuffer = m_mapSpanBuffers[nOffset];
+    oSpanBuffer.pData = pSpanBuffer;
+    oSpanBuffer.nSize = nSize;
+    oSpanBuffer.nRefCount = 1;
+    m_nPinnedSize += nSize;
+
+    return pSpanBuffer;
+}
+
+DataLoaderMemory::DataLoaderMemory()
+    : m_pBuffer(NULL)
+    , m_nBufferSize(0)
+{
+
+}
+
+DataLoaderMemory::~DataLoaderMemory()
+{
+
+}
+
+BOOL
+DataLoaderMemory::LoadBuffer(void *pBuffer, UINT64 nSize)
+{
+    LIBPE_ASSERT_RET(NULL != pBuffer && 0 != nSize, false);
+
+    m_pBuffer = (INT8 *)pBuffer;
+    m_nBufferSize = nSize;
+
+    return true;
+}
+
+void *
+DataLoaderMemory::GetBuffer(UINT64 nOffset, UINT64 nSize)
+{
+    if(NULL == m_pBuffer || nOffset >= m_nBufferSize || nSize > m_nBufferSize - nOffset) {
+        return NULL;
+    }
 
-    DWORD nReadSize = 0;
-    LPVOID pBuffer = &(m_pFileBuffer[nBlockId * m_nBlockSize]);
-    if(!::ReadFile(m_hFile, pBuffer, nNeedSize, &nReadSize, NULL)) {
+    return &(m_pBuffer[nOffset]);
+}
+
+const char *
+DataLoaderMemory::GetAnsiString(UINT64 nOffset, UINT64 &nSize)
+{
+    if(NULL == m_pBuffer || nOffset >= m_nBufferSize) {
+        return NULL;
+    }
+
+    const char *pString = (const char *)&(m_pBuffer[nOffset]);
+    const char *pStringEnd = (const char *)memchr(pString, 0, (size_t)(m_nBufferSize - nOffset));
+    if(NULL == pStringEnd) {
+        return NULL;
+    }
+
+    nSize = (UINT64)(pStringEnd - pString) + 1;
+
+    return pString;
+}
+
+const wchar_t *
+DataLoaderMemory::GetUnicodeString(UINT64 nOffset, UINT64 &nSize)
+{
+    if(NULL == m_pBuffer || nOffset >= m_nBufferSize) {
+        return NULL;
+    }
+
+    // Strings in PE file are always UTF-16, so we should check the whole 16-bit unit instead of a single byte.
+    const INT8 *pString = &(m_pBuffer[nOffset]);
+    const INT8 *pTerminator = FindUnicodeTerminator(pString, m_pBuffer + m_nBufferSize);
+    if(NULL == pTerminator) {
+        return NULL;
+    }
+
+    nSize = (UINT64)(pTerminator - pString) + sizeof(UINT16);
+
+    return (const wchar_t *)pString;
+}
+
+BOOL
+DataLoaderMemory::IsOverlapped(const void *pBuffer, UINT64 nSize)
+{
+    if(NULL == m_pBuffer || NULL == pBuffer || 0 == nSize) {
         return false;
     }
 
-    m_pBlockStatus[nBlockId] = 1;
+    const INT8 *pBegin = (const INT8 *)pBuffer;
+    return (pBegin < m_pBuffer + m_nBufferSize && m_pBuffer < pBegin + nSize);
+}
+
+DataLoaderMappedFile::DataLoaderMappedFile()
+#ifdef LIBPE_WINOS
+    : m_hFile(INVALID_HANDLE_VALUE)
+    , m_hFileMapping(NULL)
+#else
+    : m_hFile(-1)
+#endif
+{
+
+}
+
+DataLoaderMappedFile::~DataLoaderMappedFile()
+{
+    Reset();
+}
+
+void
+DataLoaderMappedFile::Prefetch(UINT64 nOffset, UINT64 nSize)
+{
+    if(NULL == m_pBuffer || nOffset >= m_nBufferSize || 0 == nSize) {
+        return;
+    }
+
+    if(nSize > m_nBufferSize - nOffset) {
+        nSize = m_nBufferSize - nOffset;
+    }
+
+#ifndef LIBPE_WINOS
+    // madvise needs a page aligned address, and the mapping itself is always page aligned.
+    UINT64 nPageSize = (UINT64)::sysconf(_SC_PAGESIZE);
+    UINT64 nAlignedOffset = nOffset - (nOffset % nPageSize);
+    ::madvise(&(m_pBuffer[nAlignedOffset]), (size_t)(nOffset + nSize - nAlignedOffset), MADV_WILLNEED);
+#endif
+}
+
+BOOL
+DataLoaderMappedFile::LoadFile(const file_t &strPath)
+{
+    Reset();
+
+#ifdef LIBPE_WINOS
+    m_hFile = ::CreateFile(strPath.c_str(), FILE_GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(INVALID_HANDLE_VALUE == m_hFile) {
+        return false;
+    }
+
+    LARGE_INTEGER nFileSize;
+    if(!::GetFileSizeEx(m_hFile, &nFileSize) || 0 == nFileSize.QuadPart) {
+        Reset();
+        return false;
+    }
+    m_nBufferSize = (UINT64)nFileSize.QuadPart;
+
+    m_hFileMapping = ::CreateFileMapping(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(NULL == m_hFileMapping) {
+        Reset();
+        return false;
+    }
+
+    m_pBuffer = (INT8 *)::MapViewOfFile(m_hFileMapping, FILE_MAP_READ, 0, 0, 0);
+    if(NULL == m_pBuffer) {
+        Reset();
+        return false;
+    }
+#else
+    m_hFile = ::open(strPath.c_str(), O_RDONLY);
+    if(-1 == m_hFile) {
+        return false;
+    }
+
+    struct stat oFileStat;
+    if(0 != ::fstat(m_hFile, &oFileStat) || 0 >= oFileStat.st_size) {
+        Reset();
+        return false;
+    }
+    m_nBufferSize = (UINT64)oFileStat.st_size;
+
+    void *pMapping = ::mmap(NULL, (size_t)m_nBufferSize, PROT_READ, MAP_PRIVATE, m_hFile, 0);
+    if(MAP_FAILED == pMapping) {
+        Reset();
+        return false;
+    }
+    m_pBuffer = (INT8 *)pMapping;
+
+    // The mapping holds its own reference to the file, so the descriptor is not needed anymore.
+    ::close(m_hFile);
+    m_hFile = -1;
+#endif
 
     return true;
 }
 
+void
+DataLoaderMappedFile::Reset()
+{
+#ifdef LIBPE_WINOS
+    if(NULL != m_pBuffer) {
+        ::UnmapViewOfFile(m_pBuffer);
+        m_pBuffer = NULL;
+    }
+
+    if(NULL != m_hFileMapping) {
+        ::CloseHandle(m_hFileMapping);
+        m_hFileMapping = NULL;
+    }
+
+    if(INVALID_HANDLE_VALUE != m_hFile) {
+        ::CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+#else
+    if(NULL != m_pBuffer) {
+        ::munmap(m_pBuffer, (size_t)m_nBufferSize);
+        m_pBuffer = NULL;
+    }
+
+    if(-1 != m_hFile) {
+        ::close(m_hFile);
+        m_hFile = -1;
+    }
+#endif
+
+    m_nBufferSize = 0;
+}
+
 LIBPE_NAMESPACE_END
\ No newline at end of file
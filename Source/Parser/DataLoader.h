@@ -4,27 +4,89 @@
 
 LIBPE_NAMESPACE_BEGIN
 
+class DataLoaderReadAheadPool;
+
 class DataLoader :
     public ILibPEInterface
 {
 public:
+    virtual ~DataLoader() {}
+
     LIBPE_SINGLE_THREAD_OBJECT();
     virtual PEParserType GetType() = 0;
     virtual UINT64 GetSize() = 0;
     virtual void * GetBuffer(UINT64 nOffset, UINT64 nSize) = 0;
     virtual const char * GetAnsiString(UINT64 nOffset, UINT64 &nSize) = 0;
     virtual const wchar_t * GetUnicodeString(UINT64 nOffset, UINT64 &nSize) = 0;
+
+    // Give back a buffer got from GetBuffer with the same range, which the caller won't touch any more.
+    virtual void ReleaseBuffer(void *pBuffer, UINT64 nOffset, UINT64 nSize) {}
+
+    // Copy the range into the buffer of the caller. Unlike GetBuffer, the loader keeps nothing for it, so a large
+    // range can be read piece by piece without holding it in memory all at once.
+    virtual BOOL ReadData(UINT64 nOffset, void *pBuffer, UINT64 nSize)
+    {
+        void *pData = GetBuffer(nOffset, nSize);
+        if(NULL == pData) {
+            return false;
+        }
+
+        memcpy(pBuffer, pData, (size_t)nSize);
+        return true;
+    }
+
+    // Hint that the range will be used soon, so the loader can read it in as few I/Os as possible.
+    virtual void Prefetch(UINT64 nOffset, UINT64 nSize) {}
+
+    // Whether Prefetch returns before the data is ready, so it is cheap to hint the ranges which might not be used.
+    virtual BOOL IsPrefetchAsync() { return false; }
+
+    // Whether the memory range overlaps the data which the loader reads from, so writing to it changes the file.
+    virtual BOOL IsOverlapped(const void *pBuffer, UINT64 nSize) { return false; }
 };
 
+// DataLoaderDiskFile reads the file on demand block by block, and keeps the blocks in a bounded cache.
+// The blocks and span buffers handed out by GetBuffer are pinned until they are released, and they are counted in
+// the cache size, so the other blocks are evicted in LRU order to keep the total under the limit. A range across
+// blocks which is larger than the limit can't be pinned at all, so it has to be read by ReadData instead.
 class DataLoaderDiskFile :
     public DataLoader
 {
+    friend class DataLoaderReadAheadPool;
+
 #ifdef LIBPE_WINOS
     typedef HANDLE FileHandle;
 #else
     typedef int FileHandle;
 #endif
 
+    struct CacheBlock {
+        INT8                        *pData;
+        UINT32                      nSize;
+        UINT32                      nPinCount;
+        std::list<UINT64>::iterator itLRU;
+    };
+
+    struct SpanBuffer {
+        INT8    *pData;
+        UINT64  nSize;
+        UINT32  nRefCount;
+    };
+
+    struct ReadAheadRun {
+        UINT64  nStartBlockId;
+        UINT64  nEndBlockId;
+    };
+
+    struct ReadAheadBlock {
+        UINT64  nBlockId;
+        INT8    *pData;
+        UINT32  nSize;
+    };
+
+    typedef std::map<UINT64, CacheBlock> CacheBlockMap;
+    typedef std::map<UINT64, SpanBuffer> SpanBufferMap;
+
 public:
     DataLoaderDiskFile();
     virtual ~DataLoaderDiskFile();
@@ -37,19 +99,127 @@ public:
     virtual void * GetBuffer(UINT64 nOffset, UINT64 nSize);
     virtual const char * GetAnsiString(UINT64 nOffset, UINT64 &nSize);
     virtual const wchar_t * GetUnicodeString(UINT64 nOffset, UINT64 &nSize);
+    virtual void ReleaseBuffer(void *pBuffer, UINT64 nOffset, UINT64 nSize);
+    virtual BOOL ReadData(UINT64 nOffset, void *pBuffer, UINT64 nSize);
+    virtual void Prefetch(UINT64 nOffset, UINT64 nSize);
+    virtual BOOL IsPrefetchAsync() { return m_bReadAheadEnabled; }
+
+protected:
+    void Reset();
+    UINT64 GetBlockId(UINT64 nOffset) { return nOffset / m_nBlockSize; }
+    UINT32 GetBlockSize(UINT64 nBlockId);
+    CacheBlock * ReadBlock(UINT64 nBlockId);
+    void LoadBlocks(UINT64 nStartBlockId, UINT64 nEndBlockId);
+    BOOL LoadBlockRun(UINT64 nStartBlockId, UINT64 nEndBlockId);
+    BOOL ReadBlockRun(UINT64 nStartBlockId, UINT64 nEndBlockId, std::vector<INT8 *> &vBlockData, std::vector<UINT32> &vBlockSize);
+    void AddBlock(UINT64 nBlockId, INT8 *pData, UINT32 nSize);
+    void PinBlock(CacheBlock *pBlock);
+    void UnpinBlock(UINT64 nBlockId, CacheBlock *pBlock);
+    BOOL ReleaseSpanBuffer(SpanBuffer &oSpanBuffer, void *pBuffer);
+    void EvictBlocks(UINT64 nNeedSize);
+    BOOL ReadFileData(UINT64 nOffset, void *pBuffer, UINT32 nSize);
+    BOOL FindTerminator(UINT64 nOffset, UINT32 nCharSize, UINT64 &nSize);
+    void * GetSpanBuffer(UINT64 nOffset, UINT64 nSize);
+
+    // Read-ahead, the runs queued by Prefetch are read by the threads of DataLoaderReadAheadPool. The blocks read are
+    // handed back through m_vReadAheadBlocks, and they are only moved into the cache by the thread which owns the loader.
+    void StartReadAhead();
+    void StopReadAhead();
+    void QueueReadAhead(UINT64 nStartBlockId, UINT64 nEndBlockId);
+    BOOL IsBlockLoadedOrQueued(UINT64 nBlockId);
+    void TakeReadAheadBlocks();
+    void WaitForReadAhead(UINT64 nStartBlockId, UINT64 nEndBlockId);
+    BOOL HasReadAheadRuns();
+    void RunReadAhead();
+
+private:
+    FileHandle                  m_hFile;
+    UINT64                      m_nFileSize;
+    UINT64                      m_nBlockSize;
+    UINT64                      m_nMaxCacheSize;
+    UINT64                      m_nCachedSize;
+    UINT64                      m_nPinnedSize;
+    CacheBlockMap               m_mapBlocks;
+    std::list<UINT64>           m_lstLRUBlocks;
+    SpanBufferMap               m_mapSpanBuffers;
+    std::vector<SpanBuffer>     m_vRetiredSpanBuffers;
+
+    BOOL                        m_bReadAheadEnabled;
+    Mutex                       m_oReadAheadLock;
+    Condition                   m_oReadAheadCondition;
+    std::list<ReadAheadRun>     m_lstReadAheadRuns;
+    ReadAheadRun                m_oInFlightRun;
+    BOOL                        m_bReadAheadInFlight;
+    std::vector<ReadAheadBlock> m_vReadAheadBlocks;
+    UINT64                      m_nReadAheadPendingSize;
+};
+
+// DataLoaderMemory parses the PE file directly over a buffer in raw file layout. The buffer is not copied,
+// so it must stay valid as long as the loader is alive.
+class DataLoaderMemory :
+    public DataLoader
+{
+public:
+    DataLoaderMemory();
+    virtual ~DataLoaderMemory();
+
+    BOOL LoadBuffer(void *pBuffer, UINT64 nSize);
+
+    // Override PELoader
+    virtual PEParserType GetType() { return PE_PARSER_TYPE_MAPPED_FILE; }
+    virtual UINT64 GetSize() { return m_nBufferSize; }
+    virtual void * GetBuffer(UINT64 nOffset, UINT64 nSize);
+    virtual const char * GetAnsiString(UINT64 nOffset, UINT64 &nSize);
+    virtual const wchar_t * GetUnicodeString(UINT64 nOffset, UINT64 &nSize);
+    virtual BOOL IsOverlapped(const void *pBuffer, UINT64 nSize);
+
+protected:
+    INT8        *m_pBuffer;
+    UINT64      m_nBufferSize;
+};
+
+// DataLoaderImageBuffer is the same as DataLoaderMemory, but the buffer is in the loaded image layout, that is to say
+// every section is placed at its RVA. Memory dumps of the loaded modules are in this layout.
+class DataLoaderImageBuffer :
+    public DataLoaderMemory
+{
+public:
+    DataLoaderImageBuffer() {}
+    virtual ~DataLoaderImageBuffer() {}
+
+    // Override PELoader
+    virtual PEParserType GetType() { return PE_PARSER_TYPE_LOADED_IMAGE; }
+};
+
+// DataLoaderMappedFile maps the whole file into memory read-only, so every buffer it returns points into the
+// mapping directly. No data is copied, and the pages are shared with every other process mapping the same file.
+class DataLoaderMappedFile :
+    public DataLoaderMemory
+{
+#ifdef LIBPE_WINOS
+    typedef HANDLE FileHandle;
+#else
+    typedef int FileHandle;
+#endif
+
+public:
+    DataLoaderMappedFile();
+    virtual ~DataLoaderMappedFile();
+
+    BOOL LoadFile(const file_t &strPath);
+
+    // Override PELoader
+    virtual void Prefetch(UINT64 nOffset, UINT64 nSize);
+    virtual BOOL IsPrefetchAsync() { return true; }
 
 protected:
     void Reset();
-    INT32 GetBlockId(UINT64 nOffset);
-    BOOL ReadBlock(INT32 nBlockId);
 
 private:
     FileHandle  m_hFile;
-    INT8        *m_pFileBuffer;
-    UINT64      m_nFileSize;
-    BOOL        *m_pBlockStatus;
-    INT32       m_nBlockStatusCount;
-    UINT64      m_nBlockSize;
+#ifdef LIBPE_WINOS
+    HANDLE      m_hFileMapping;
+#endif
 };
 
 LIBPE_NAMESPACE_END
\ No newline at end of file
@@ -9,6 +9,9 @@
 #include "PE/PEResourceTable.h"
 #include "PE/PERelocationTable.h"
 #include "PE/PEImportAddressTable.h"
+#include "PE/PEBoundImportTable.h"
+#include "PE/PEDelayImportTable.h"
+#include "PE/PEVersionInfo.h"
 
 LIBPE_NAMESPACE_BEGIN
 
@@ -19,6 +22,10 @@ PEParserT<T>::Create(PEParserType nType)
     switch(nType) {
     case PE_PARSER_TYPE_DISK_FILE:
         return new PEParserDiskFileT<T>;
+    case PE_PARSER_TYPE_MAPPED_FILE:
+        return new PEParserMappedFileT<T>;
+    case PE_PARSER_TYPE_LOADED_IMAGE:
+        return new PEParserLoadedImageT<T>;
     }
 
     return NULL;
@@ -52,26 +59,14 @@ PEAddress
 PEParserT<T>::GetRVAFromFOA(PEAddress nFOA)
 {
     LIBPE_ASSERT_RET(NULL != m_pFile, 0);
-    
-    LibPEPtr<IPESection> pLastSection, pSection;
-    UINT32 nSectionId = 0, nSectionCount = m_pFile->GetSectionCount();
-    for(nSectionId = 0; nSectionId < nSectionCount; ++nSectionId) {
-        if(FAILED(m_pFile->GetSection(nSectionId, &pSection)) || NULL == pSection) {
-            return 0;
-        }
-
-        if(pSection->GetFOA() > nFOA) {
-            break;
-        }
-
-        pLastSection.Attach(pSection.Detach());
-    }
 
-    if(NULL == pLastSection) {
+    // The address before the first section is in the headers, which are the same in file and in memory.
+    const PESectionRange *pRange = m_pFile->FindSectionRangeByFOA(nFOA);
+    if(NULL == pRange) {
         return nFOA;
     }
 
-    return pLastSection->GetRVA() + nFOA - pLastSection->GetFOA();
+    return pRange->nTargetBegin + nFOA - pRange->nBegin;
 }
 
 template <class T>
@@ -79,26 +74,13 @@ PEAddress
 PEParserT<T>::GetFOAFromRVA(PEAddress nRVA)
 {
     LIBPE_ASSERT_RET(NULL != m_pFile, 0);
-    
-    LibPEPtr<IPESection> pLastSection, pSection;
-    UINT32 nSectionId = 0, nSectionCount = m_pFile->GetSectionCount();
-    for(nSectionId = 0; nSectionId < nSectionCount; ++nSectionId) {
-        if(FAILED(m_pFile->GetSection(nSectionId, &pSection)) || NULL == pSection) {
-            return 0;
-        }
-
-        if(pSection->GetRVA() > nRVA) {
-            break;
-        }
 
-        pLastSection.Attach(pSection.Detach());
-    }
-
-    if(NULL == pLastSection) {
+    const PESectionRange *pRange = m_pFile->FindSectionRangeByRVA(nRVA);
+    if(NULL == pRange) {
         return nRVA;
     }
 
-    return pLastSection->GetFOA() + nRVA - pLastSection->GetRVA();
+    return pRange->nTargetBegin + nRVA - pRange->nBegin;
 }
 
 template <class T>
@@ -123,6 +105,46 @@ PEParserT<T>::GetRawMemory(UINT64 nOffset, UINT64 nSize)
     return m_pLoader->GetBuffer(nOffset, nSize);
 }
 
+template <class T>
+void
+PEParserT<T>::ReleaseRawMemory(void *pBuffer, UINT64 nOffset, UINT64 nSize)
+{
+    LIBPE_ASSERT_RET_VOID(NULL != m_pLoader);
+    m_pLoader->ReleaseBuffer(pBuffer, nOffset, nSize);
+}
+
+template <class T>
+BOOL
+PEParserT<T>::ReadRawData(UINT64 nOffset, void *pBuffer, UINT64 nSize)
+{
+    LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != pBuffer, false);
+    return m_pLoader->ReadData(nOffset, pBuffer, nSize);
+}
+
+template <class T>
+void
+PEParserT<T>::PrefetchDataDirectories()
+{
+    LIBPE_ASSERT_RET_VOID(NULL != m_pLoader && NULL != m_pFile);
+
+    // Only hint all the data directories when it won't block us, because most callers only need a few of them.
+    if(!m_pLoader->IsPrefetchAsync()) {
+        return;
+    }
+
+    for(INT32 nDataDirectoryEntryIndex = 0; nDataDirectoryEntryIndex < IMAGE_NUMBEROF_DIRECTORY_ENTRIES; ++nDataDirectoryEntryIndex) {
+        // The certificate table is addressed by FOA and is not mapped into memory, so we leave it alone.
+        if(IMAGE_DIRECTORY_ENTRY_SECURITY == nDataDirectoryEntryIndex) {
+            continue;
+        }
+
+        PEAddress nRVA = 0, nFOA = 0, nSize = 0;
+        if(SUCCEEDED(GetDataDirectoryEntry(nDataDirectoryEntryIndex, nRVA, nFOA, nSize))) {
+            PrefetchRange(nRVA, nFOA, nSize);
+        }
+    }
+}
+
 template <class T>
 const char *
 PEParserT<T>::ParseAnsiString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize)
@@ -131,6 +153,14 @@ PEParserT<T>::ParseAnsiString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize)
     return m_pLoader->GetAnsiString(GetRawOffset(nRVA, nFOA), nSize);
 }
 
+template <class T>
+void
+PEParserT<T>::ReleaseAnsiString(const char *pString, PEAddress nRVA, PEAddress nFOA, UINT64 nSize)
+{
+    LIBPE_ASSERT_RET_VOID(NULL != m_pLoader && NULL != m_pFile);
+    m_pLoader->ReleaseBuffer((void *)pString, GetRawOffset(nRVA, nFOA), nSize);
+}
+
 template <class T>
 const wchar_t *
 PEParserT<T>::ParseUnicodeString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize)
@@ -147,7 +177,7 @@ PEParserT<T>::ParseBasicInfo(IPEDosHeader **ppDosHeader, IPENtHeaders **ppNtHead
     LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
 
     // Parse dos header
-    LibPEPtr<PEDosHeaderT<T>> pInnerDosHeader = new PEDosHeaderT<T>();
+    LibPEPtr<PEDosHeaderT<T>> pInnerDosHeader = new (m_pArena) PEDosHeaderT<T>();
     LIBPE_ASSERT_RET(NULL != pInnerDosHeader, E_OUTOFMEMORY);
     pInnerDosHeader->InnerSetBase(m_pFile, this);
     pInnerDosHeader->InnerSetMemoryInfo(0, 0, sizeof(LibPERawDosHeaderT(T)));
@@ -158,7 +188,7 @@ PEParserT<T>::ParseBasicInfo(IPEDosHeader **ppDosHeader, IPENtHeaders **ppNtHead
     LIBPE_ASSERT_RET(IMAGE_DOS_SIGNATURE == pRawDosHeader->e_magic, E_FAIL);
 
     // Parse nt headers
-    LibPEPtr<PENtHeadersT<T>> pInnerNtHeaders = new PENtHeadersT<T>();
+    LibPEPtr<PENtHeadersT<T>> pInnerNtHeaders = new (m_pArena) PENtHeadersT<T>();
     LIBPE_ASSERT_RET(NULL != pInnerNtHeaders, E_OUTOFMEMORY);
     pInnerNtHeaders->InnerSetBase(m_pFile, this);
     pInnerNtHeaders->InnerSetMemoryInfo(pRawDosHeader->e_lfanew, 0, sizeof(LibPERawNtHeadersT(T)));
@@ -175,14 +205,14 @@ PEParserT<T>::ParseBasicInfo(IPEDosHeader **ppDosHeader, IPENtHeaders **ppNtHead
     }
 
     // Parse file header
-    LibPEPtr<PEFileHeaderT<T>> pInnerFileHeader = new PEFileHeaderT<T>();
+    LibPEPtr<PEFileHeaderT<T>> pInnerFileHeader = new (m_pArena) PEFileHeaderT<T>();
     LIBPE_ASSERT_RET(NULL != pInnerFileHeader, E_OUTOFMEMORY);
     pInnerFileHeader->InnerSetBase(m_pFile, this);
     pInnerFileHeader->InnerSetMemoryInfo(pRawDosHeader->e_lfanew + sizeof(UINT32), 0, sizeof(LibPERawFileHeaderT(T)));
     pInnerFileHeader->InnerSetFileInfo(pRawDosHeader->e_lfanew + sizeof(UINT32), sizeof(LibPERawFileHeaderT(T)));
     pInnerNtHeaders->InnerSetFileHeader(pInnerFileHeader.p);
 
-    LibPEPtr<PEOptionalHeaderT<T>> pInnerOptionalHeader = new PEOptionalHeaderT<T>();
+    LibPEPtr<PEOptionalHeaderT<T>> pInnerOptionalHeader = new (m_pArena) PEOptionalHeaderT<T>();
     LIBPE_ASSERT_RET(NULL != pInnerOptionalHeader, E_OUTOFMEMORY);
     pInnerOptionalHeader->InnerSetBase(m_pFile, this);
     pInnerOptionalHeader->InnerSetMemoryInfo(pRawDosHeader->e_lfanew + sizeof(UINT32) + sizeof(LibPERawFileHeaderT(T)), 0, sizeof(LibPERawOptionalHeaderT(T)));
@@ -193,20 +223,20 @@ PEParserT<T>::ParseBasicInfo(IPEDosHeader **ppDosHeader, IPENtHeaders **ppNtHead
     *ppNtHeaders = pInnerNtHeaders.Detach();
 
     // Parse section headers
-    UINT32 nStartSectionHeaderOffset = pRawDosHeader->e_lfanew + sizeof(DWORD) + sizeof(LibPERawFileHeaderT(T)) + pRawNtHeaders->FileHeader.SizeOfOptionalHeader;
+    UINT32 nStartSectionHeaderOffset = pRawDosHeader->e_lfanew + sizeof(UINT32) + sizeof(LibPERawFileHeaderT(T)) + pRawNtHeaders->FileHeader.SizeOfOptionalHeader;
     UINT32 nSectionHeaderOffset = nStartSectionHeaderOffset;
     LibPEPtr<PESectionHeaderT<T>> pSectionHeader;
     for(UINT16 nSectionId = 0; nSectionId < pRawNtHeaders->FileHeader.NumberOfSections; ++nSectionId) {
         nSectionHeaderOffset = nStartSectionHeaderOffset + nSectionId * sizeof(LibPERawSectionHeaderT(T));
 
-        pSectionHeader = new PESectionHeaderT<T>();
+        pSectionHeader = new (m_pArena) PESectionHeaderT<T>();
         if(NULL == pSectionHeader) {
             return E_OUTOFMEMORY;
         }
 
         pSectionHeader->InnerSetBase(m_pFile, this);
-        pSectionHeader->InnerSetMemoryInfo(nSectionHeaderOffset, 0, sizeof(LibPERawOptionalHeaderT(T)));
-        pSectionHeader->InnerSetFileInfo(nSectionHeaderOffset, sizeof(LibPERawOptionalHeaderT(T)));
+        pSectionHeader->InnerSetMemoryInfo(nSectionHeaderOffset, 0, sizeof(LibPERawSectionHeaderT(T)));
+        pSectionHeader->InnerSetFileInfo(nSectionHeaderOffset, sizeof(LibPERawSectionHeaderT(T)));
 
         pSectionHeaders->push_back(pSectionHeader.p);
     }
@@ -224,11 +254,12 @@ PEParserT<T>::ParseBasicInfo(IPEDosHeader **ppDosHeader, IPENtHeaders **ppNtHead
         nOverlayBeginRVA = pSection->GetRVA() + pSection->GetSizeInMemory();
     }
 
+    // The loaded image only contains the mapped sections, so there is no overlay in it.
     PEAddress nFileSize = (PEAddress)(m_pLoader->GetSize());
-    if(nOverlayBeginFOA < nFileSize) {
+    if(!IsRawAddressVA() && nOverlayBeginFOA < nFileSize) {
         PEAddress nOverlaySize = nFileSize - nOverlayBeginFOA;
 
-        LibPEPtr<PEOverlayT<T>> pOverlay = new PEOverlayT<T>();
+        LibPEPtr<PEOverlayT<T>> pOverlay = new (m_pArena) PEOverlayT<T>();
         if(NULL == pOverlay) {
             return E_OUTOFMEMORY;
         }
@@ -250,7 +281,7 @@ PEParserT<T>::ParseSection(LibPERawSectionHeaderT(T) *pSectionHeader, IPESection
     LIBPE_ASSERT_RET(NULL != pSectionHeader && NULL != ppSection, E_POINTER);
     LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
 
-    LibPEPtr<PESectionT<T>> pRawSection = new PESectionT<T>();
+    LibPEPtr<PESectionT<T>> pRawSection = new (m_pArena) PESectionT<T>();
     if(NULL == pRawSection) {
         return E_OUTOFMEMORY;
     }
@@ -279,7 +310,9 @@ PEParserT<T>::ParseExportTable(IPEExportTable **ppExportTable)
         return E_FAIL;
     }
 
-    LibPEPtr<PEExportTableT<T>> pExportTable = new PEExportTableT<T>();
+    PrefetchRange(nExportTableRVA, nExportTableFOA, nExportTableSize);
+
+    LibPEPtr<PEExportTableT<T>> pExportTable = new (m_pArena) PEExportTableT<T>();
     if(NULL == pExportTable) {
         return E_OUTOFMEMORY;
     }
@@ -297,9 +330,17 @@ PEParserT<T>::ParseExportTable(IPEExportTable **ppExportTable)
     PEAddress nNameListOffset = GetRawOffsetFromAddressField(pExportDirectory->AddressOfNames);
     PEAddress nNameOrdinalListOffset = GetRawOffsetFromAddressField(pExportDirectory->AddressOfNameOrdinals);
 
-    UINT32 *pFunctionList = (UINT32 *)m_pLoader->GetBuffer(nFunctionListOffset, pExportDirectory->NumberOfFunctions * sizeof(PEAddress));
-    UINT32 *pNameList = (UINT32 *)m_pLoader->GetBuffer(nNameListOffset, pExportDirectory->NumberOfNames * sizeof(PEAddress));
-    UINT16 *pNameOrdinalList = (UINT16 *)m_pLoader->GetBuffer(nNameOrdinalListOffset, pExportDirectory->NumberOfFunctions * sizeof(UINT16));
+    // All the entries of these arrays are 32-bit RVAs or 16-bit indexes, and the name ordinal array is parallel to the name array.
+    // The arrays are used as long as the table is alive, so they are released along with it.
+    UINT64 nFunctionListSize = pExportDirectory->NumberOfFunctions * sizeof(UINT32);
+    UINT64 nNameListSize = pExportDirectory->NumberOfNames * sizeof(UINT32);
+    UINT64 nNameOrdinalListSize = pExportDirectory->NumberOfNames * sizeof(UINT16);
+    UINT32 *pFunctionList = (UINT32 *)m_pLoader->GetBuffer(nFunctionListOffset, nFunctionListSize);
+    pExportTable->InnerKeepRawMemory(pFunctionList, nFunctionListOffset, nFunctionListSize);
+    UINT32 *pNameList = (UINT32 *)m_pLoader->GetBuffer(nNameListOffset, nNameListSize);
+    pExportTable->InnerKeepRawMemory(pNameList, nNameListOffset, nNameListSize);
+    UINT16 *pNameOrdinalList = (UINT16 *)m_pLoader->GetBuffer(nNameOrdinalListOffset, nNameOrdinalListSize);
+    pExportTable->InnerKeepRawMemory(pNameOrdinalList, nNameOrdinalListOffset, nNameOrdinalListSize);
 
     LIBPE_ASSERT_RET(NULL != pFunctionList && NULL != pNameList && NULL != pNameOrdinalList, E_OUTOFMEMORY);
 
@@ -323,17 +364,15 @@ PEParserT<T>::ParseExportFunction(IPEExportTable *pExportTable, UINT32 nIndex, I
     LIBPE_ASSERT_RET(NULL != pExportTable && NULL != ppFunction, E_POINTER);
 
     PEExportTableT<T> *pRawExportTable = static_cast<PEExportTableT<T> *>(pExportTable);
+    LibPERawExportDirectory(T) *pExportDirectory = pRawExportTable->GetRawStruct();
     UINT32 *pFunctionList = pRawExportTable->GetRawFunctionList();
-    UINT32 *pNameList = pRawExportTable->GetRawNameList();
-    UINT16 *pNameOrdinalList = pRawExportTable->GetRawNameOrdinalList();
 
-    LIBPE_ASSERT_RET(NULL != pFunctionList && NULL != pNameList && NULL != pNameOrdinalList, E_FAIL);
+    LIBPE_ASSERT_RET(NULL != pExportDirectory && NULL != pFunctionList, E_FAIL);
+    LIBPE_ASSERT_RET(nIndex < pRawExportTable->GetFunctionCount(), E_INVALIDARG);
 
     PEAddress nFunctionRVA = pFunctionList[nIndex];
-    PEAddress nNameRVA = (nIndex < pRawExportTable->GetFunctionCount()) ? pNameList[nIndex] : 0;
-    UINT16 nNameOrdinal = pNameOrdinalList[nIndex];
 
-    LibPEPtr<PEExportFunctionT<T>> pFunction = new PEExportFunctionT<T>();
+    LibPEPtr<PEExportFunctionT<T>> pFunction = new (m_pArena) PEExportFunctionT<T>();
     if(NULL == pFunction) {
         return E_OUTOFMEMORY;
     }
@@ -341,13 +380,20 @@ PEParserT<T>::ParseExportFunction(IPEExportTable *pExportTable, UINT32 nIndex, I
     pFunction->InnerSetBase(m_pFile, this);
     pFunction->InnerSetMemoryInfo(nFunctionRVA, 0, 0);
     pFunction->InnerSetFileInfo(0, 0);
-    pFunction->InnerSetHint(nNameOrdinal);
+    pFunction->InnerSetOrdinal(pExportDirectory->Base + nIndex);
+
+    // The hint of a function is the index of its name in the name table, which is what the importers use.
+    UINT32 nNameIndex = pRawExportTable->GetNameIndexByFunctionIndex(nIndex);
+    if(EXPORT_NO_NAME_INDEX != nNameIndex) {
+        UINT64 nNameSize = 0;
+        pFunction->InnerSetHint((UINT16)nNameIndex);
+        pFunction->InnerSetName(pFunction->KeepAnsiString(pRawExportTable->GetNameRVAByNameIndex(nNameIndex), 0, nNameSize));
+    }
 
-    if(nNameRVA != 0) {
-        PEAddress nNameFOA = GetFOAFromRVA(nNameRVA);
-        UINT64 nNameBufferSize = 0;
-        const char *pName = m_pLoader->GetAnsiString(nNameFOA, nNameBufferSize);
-        pFunction->InnerSetName(pName);
+    // A function whose RVA points into the export directory is a forwarder string, not code.
+    if(nFunctionRVA >= pRawExportTable->GetRVA() && nFunctionRVA < pRawExportTable->GetRVA() + pRawExportTable->GetSizeInMemory()) {
+        UINT64 nForwarderSize = 0;
+        pFunction->InnerSetForwarder(pFunction->KeepAnsiString(nFunctionRVA, 0, nForwarderSize));
     }
 
     *ppFunction = pFunction.Detach();
@@ -369,7 +415,9 @@ PEParserT<T>::ParseImportTable(IPEImportTable **ppImportTable)
         return E_FAIL;
     }
 
-    LibPEPtr<PEImportTableT<T>> pImportTable = new PEImportTableT<T>();
+    PrefetchRange(nImportTableRVA, nImportTableFOA, nImportTableSize);
+
+    LibPEPtr<PEImportTableT<T>> pImportTable = new (m_pArena) PEImportTableT<T>();
     if(NULL == pImportTable) {
         return E_OUTOFMEMORY;
     }
@@ -383,8 +431,9 @@ PEParserT<T>::ParseImportTable(IPEImportTable **ppImportTable)
         return E_OUTOFMEMORY;
     }
 
+    // Some linkers leave OriginalFirstThunk 0 and only fill FirstThunk, so only the name and the IAT end the table.
     PEAddress nImportDescRVA = nImportTableRVA, nImportDescFOA = nImportTableFOA;
-    while(0 != pImportDesc->Characteristics && 0 != pImportDesc->Name) {
+    while(0 != pImportDesc->Name && 0 != pImportDesc->FirstThunk) {
         pImportTable->AddImportDescriptor(nImportDescRVA, nImportDescFOA, pImportDesc);
         ++pImportDesc;
         nImportDescRVA += sizeof(LibPERawImportDescriptor(T));
@@ -404,21 +453,40 @@ PEParserT<T>::ParseImportModule(PEAddress nImportDescRVA, PEAddress nImportDescF
 
     *ppImportModule = NULL;
 
-    PEAddress nImportNameFOA = GetFOAFromRVA(pImportDescriptor->Name);
-    if(0 == nImportNameFOA) {
+    PEAddress nImportNameOffset = GetRawOffsetFromRVA(pImportDescriptor->Name);
+    if(0 == nImportNameOffset) {
         return E_FAIL;
     }
 
-    UINT64 nNameBufferSize = 0;
-    const char *pImportName = m_pLoader->GetAnsiString(nImportNameFOA, nNameBufferSize);
-
-    LibPEPtr<PEImportModuleT<T>> pImportModule = new PEImportModuleT<T>();
+    LibPEPtr<PEImportModuleT<T>> pImportModule = new (m_pArena) PEImportModuleT<T>();
     LIBPE_ASSERT_RET(NULL != pImportModule, E_OUTOFMEMORY);
 
     pImportModule->InnerSetBase(m_pFile, this);
     pImportModule->InnerSetMemoryInfo(nImportDescRVA, 0, sizeof(IMAGE_IMPORT_BY_NAME));
     pImportModule->InnerSetFileInfo(nImportDescFOA, sizeof(IMAGE_IMPORT_BY_NAME));
-    pImportModule->InnerSetName(pImportName);
+
+    UINT64 nNameBufferSize = 0;
+    pImportModule->InnerSetName(pImportModule->KeepAnsiString(pImportDescriptor->Name, 0, nNameBufferSize));
+
+    ThunkDataList vThunks;
+    if(FAILED(ParseImportThunks(pImportDescriptor, vThunks))) {
+        return E_FAIL;
+    }
+
+    for(UINT32 nThunkIndex = 0; nThunkIndex < (UINT32)vThunks.size(); ++nThunkIndex) {
+        pImportModule->AddImportFunctionThunk(vThunks[nThunkIndex]);
+    }
+
+    *ppImportModule = pImportModule.Detach();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::ParseImportThunks(LibPERawImportDescriptor(T) *pImportDescriptor, ThunkDataList &vThunks)
+{
+    LIBPE_ASSERT_RET(NULL != pImportDescriptor, E_POINTER);
 
     // By default, we use the first bridge to IMAGE_IMPORT_BY_NAME. But in some cases, the first bridge is NULL.
     // Compilers use the second bridge only. So we should fix the thunk entry at that time.
@@ -426,50 +494,87 @@ PEParserT<T>::ParseImportModule(PEAddress nImportDescRVA, PEAddress nImportDescF
     if(0 == pImportDescriptor->OriginalFirstThunk) {
         nImportThunkRVA = pImportDescriptor->FirstThunk;
     }
+
+    return ParseImportThunks(nImportThunkRVA, vThunks);
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::ParseImportThunks(PEAddress nImportThunkRVA, ThunkDataList &vThunks)
+{
+    LIBPE_ASSERT_RET(NULL != m_pLoader, E_FAIL);
+
+    vThunks.clear();
+
     LIBPE_ASSERT_RET(0 != nImportThunkRVA, E_FAIL);
 
-    PEAddress nImportThunkFOA = GetFOAFromRVA(nImportThunkRVA);
-    if(0 == nImportThunkFOA) {
+    PEAddress nImportThunkOffset = GetRawOffsetFromRVA(nImportThunkRVA);
+    if(0 == nImportThunkOffset) {
         return E_FAIL;
     }
 
+    // The thunks are copied one by one up to the terminating one, so nothing is kept in the loader for them, and the
+    // caller can reuse the same list for every module.
+    PEAddress nThunkOffset = nImportThunkOffset;
     for(;;) {
-        LibPERawThunkData(T) *pThunkData = (LibPERawThunkData(T) *)m_pLoader->GetBuffer(nImportThunkFOA, sizeof(LibPERawThunkData(T)));
-        if(NULL == pThunkData || 0 == pThunkData->u1.AddressOfData) {
+        LibPERawThunkData(T) oThunkData;
+        if(!m_pLoader->ReadData(nThunkOffset, &oThunkData, sizeof(LibPERawThunkData(T))) || 0 == oThunkData.u1.AddressOfData) {
             break;
         }
-        pImportModule->AddImportFunctionThunk(pThunkData);
-        nImportThunkRVA += sizeof(LibPERawThunkData(T));
-        nImportThunkFOA += sizeof(LibPERawThunkData(T));
+        vThunks.push_back(oThunkData);
+        nThunkOffset += sizeof(LibPERawThunkData(T));
     }
 
-    *ppImportModule = pImportModule.Detach();
-
     return S_OK;
 }
 
 template <class T>
 HRESULT
-PEParserT<T>::ParseImportFunction(LibPERawImportDescriptor(T) *pImportDescriptor, LibPERawThunkData(T) *pThunkData, IPEImportFunction **ppFunction)
+PEParserT<T>::ParseImportFunction(const LibPERawThunkData(T) *pThunkData, IPEImportFunction **ppFunction)
 {
-    LIBPE_ASSERT_RET(NULL != pImportDescriptor && NULL != pThunkData && NULL != ppFunction, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != pThunkData && NULL != ppFunction, E_POINTER);
 
     *ppFunction = NULL;
 
+    // The thunk of a function imported by ordinal holds the ordinal itself, so there is nothing else to read for it.
+    if(0 != (pThunkData->u1.Ordinal & PETrait<T>::OrdinalFlag)) {
+        LibPEPtr<PEImportFunctionT<T>> pFunction = new (m_pArena) PEImportFunctionT<T>();
+        if(NULL == pFunction) {
+            return E_OUTOFMEMORY;
+        }
+
+        pFunction->InnerSetBase(m_pFile, this);
+        pFunction->InnerSetMemoryInfo(0, 0, 0);
+        pFunction->InnerSetFileInfo(0, 0);
+        pFunction->InnerSetThunkData(pThunkData);
+        pFunction->InnerSetOrdinal((UINT16)(pThunkData->u1.Ordinal & 0xFFFF));
+
+        *ppFunction = pFunction.Detach();
+
+        return S_OK;
+    }
+
+    // The name is read by its raw offset, which is valid for a mapped image even when the RVA has no file offset,
+    // e.g. a name in the tail of a section beyond its raw data. The FOA is only recorded in the file info.
     PEAddress nRawImportFunctionRVA = pThunkData->u1.AddressOfData;
-    PEAddress nRawImportFunctionFOA = GetFOAFromRVA(nRawImportFunctionRVA);
-    if(0 == nRawImportFunctionFOA) {
+    PEAddress nRawImportFunctionOffset = GetRawOffsetFromRVA(nRawImportFunctionRVA);
+    if(0 == nRawImportFunctionOffset) {
         return E_FAIL;
     }
 
+    PEAddress nRawImportFunctionFOA = GetFOAFromRVA(nRawImportFunctionRVA);
+
+    // Only the size of the name is needed here, the function loads the whole IMAGE_IMPORT_BY_NAME by itself.
     UINT64 nNameBufferSize = 0; 
-    if(NULL == m_pLoader->GetAnsiString(nRawImportFunctionFOA + sizeof(UINT16), nNameBufferSize)) {
+    const char *pName = m_pLoader->GetAnsiString(nRawImportFunctionOffset + sizeof(UINT16), nNameBufferSize);
+    if(NULL == pName) {
         return E_OUTOFMEMORY;
     }
+    m_pLoader->ReleaseBuffer((void *)pName, nRawImportFunctionOffset + sizeof(UINT16), nNameBufferSize);
 
     PEAddress nRawImportFunctionSize = (PEAddress)(sizeof(UINT16) + nNameBufferSize);
 
-    LibPEPtr<PEImportFunctionT<T>> pFunction = new PEImportFunctionT<T>();
+    LibPEPtr<PEImportFunctionT<T>> pFunction = new (m_pArena) PEImportFunctionT<T>();
     if(NULL == pFunction) {
         return E_OUTOFMEMORY;
     }
@@ -484,6 +589,34 @@ PEParserT<T>::ParseImportFunction(LibPERawImportDescriptor(T) *pImportDescriptor
     return S_OK;
 }
 
+template <class T>
+LibPERawImportByName(T) *
+PEParserT<T>::ParseImportByName(PEAddress nRVA, UINT64 &nNameSize)
+{
+    LIBPE_ASSERT_RET(NULL != m_pLoader, NULL);
+
+    PEAddress nImportByNameOffset = GetRawOffsetFromRVA(nRVA);
+    if(0 == nImportByNameOffset) {
+        return NULL;
+    }
+
+    const char *pName = m_pLoader->GetAnsiString(nImportByNameOffset + sizeof(UINT16), nNameSize);
+    if(NULL == pName) {
+        return NULL;
+    }
+    m_pLoader->ReleaseBuffer((void *)pName, nImportByNameOffset + sizeof(UINT16), nNameSize);
+
+    return (LibPERawImportByName(T) *)m_pLoader->GetBuffer(nImportByNameOffset, sizeof(UINT16) + nNameSize);
+}
+
+template <class T>
+void
+PEParserT<T>::ReleaseImportByName(LibPERawImportByName(T) *pImportByName, PEAddress nRVA, UINT64 nNameSize)
+{
+    LIBPE_ASSERT_RET_VOID(NULL != m_pLoader);
+    m_pLoader->ReleaseBuffer(pImportByName, GetRawOffsetFromRVA(nRVA), sizeof(UINT16) + nNameSize);
+}
+
 template <class T>
 HRESULT
 PEParserT<T>::ParseResourceTable(IPEResourceTable **ppResourceTable)
@@ -498,7 +631,13 @@ PEParserT<T>::ParseResourceTable(IPEResourceTable **ppResourceTable)
         return E_FAIL;
     }
 
-    LibPEPtr<PEResourceTableT<T>> pInnerTable = new PEResourceTableT<T>();
+    PrefetchRange(nResourceTableRVA, nResourceTableFOA, nResourceTableSize);
+
+    // All the offsets in the resource tree are relative to the resource table, so its address is kept for the entries.
+    m_nResourceTableRVA = nResourceTableRVA;
+    m_nResourceTableFOA = nResourceTableFOA;
+
+    LibPEPtr<PEResourceTableT<T>> pInnerTable = new (m_pArena) PEResourceTableT<T>();
     if(NULL == pInnerTable) {
         return E_OUTOFMEMORY;
     }
@@ -528,7 +667,7 @@ PEParserT<T>::ParseResourceDirectory(PEAddress nRVA, PEAddress nFOA, IPEResource
 
     *ppDirectory = NULL;
 
-    LibPEPtr<PEResourceDirectoryT<T>> pInnerDirectory = new PEResourceDirectoryT<T>();
+    LibPEPtr<PEResourceDirectoryT<T>> pInnerDirectory = new (m_pArena) PEResourceDirectoryT<T>();
     if(NULL == pInnerDirectory) {
         return E_OUTOFMEMORY;
     }
@@ -564,7 +703,7 @@ PEParserT<T>::ParseResourceDirectoryEntry(IPEResourceDirectory *pDirectory, UINT
     PEAddress nEntryRVA = nFirstEntryRVA + nEntryIndex * sizeof(LibPERawResourceDirectoryEntry(T));
     PEAddress nEntryFOA = nFirstEntryFOA + nEntryIndex * sizeof(LibPERawResourceDirectoryEntry(T));
 
-    LibPEPtr<PEResourceDirectoryEntryT<T>> pInnerEntry = new PEResourceDirectoryEntryT<T>();
+    LibPEPtr<PEResourceDirectoryEntryT<T>> pInnerEntry = new (m_pArena) PEResourceDirectoryEntryT<T>();
     if(NULL == pInnerEntry) {
         return E_OUTOFMEMORY;
     }
@@ -587,7 +726,7 @@ PEParserT<T>::ParseResourceDataEntry(PEAddress nRVA, PEAddress nFOA, IPEResource
 
     *ppDataEntry = NULL;
 
-    LibPEPtr<PEResourceDataEntryT<T>> pInnerDataEntry = new PEResourceDataEntryT<T>();
+    LibPEPtr<PEResourceDataEntryT<T>> pInnerDataEntry = new (m_pArena) PEResourceDataEntryT<T>();
     if(NULL == pInnerDataEntry) {
         return E_OUTOFMEMORY;
     }
@@ -613,7 +752,7 @@ PEParserT<T>::ParseResource(IPEResourceDataEntry *pDataEntry, IPEResource **ppRe
     LibPERawResourceDataEntry(T) *pRawDataEntry = (LibPERawResourceDataEntry(T) *)pDataEntry->GetRawMemory();
     LIBPE_ASSERT_RET(NULL != pRawDataEntry, E_FAIL);
 
-    LibPEPtr<PEResourceT<T>> pInnerResource = new PEResourceT<T>();
+    LibPEPtr<PEResourceT<T>> pInnerResource = new (m_pArena) PEResourceT<T>();
     if(NULL == pInnerResource) {
         return E_OUTOFMEMORY;
     }
@@ -633,17 +772,23 @@ PEParserT<T>::ParseResourceString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize)
 {
     LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, NULL);
 
+    // The length is read first, and then the whole string is handed out as one buffer, so the text is always
+    // in the same buffer as the length, even if the string is across two blocks of the loader.
     PEAddress nRawOffset = GetRawOffset(nRVA, nFOA);
-    UINT16 *pRawStringSize = (UINT16 *)m_pLoader->GetBuffer(nRawOffset, sizeof(UINT16));
-    if(NULL == pRawStringSize) {
+    UINT16 nRawStringLength = 0;
+    if(!m_pLoader->ReadData(nRawOffset, &nRawStringLength, sizeof(UINT16))) {
         return NULL;
     }
 
-    if(NULL == m_pLoader->GetBuffer(nRawOffset + sizeof(UINT16), *pRawStringSize)) {
+    UINT64 nRawStringSize = sizeof(UINT16) + nRawStringLength;
+    LibPERawResourceString(T) *pRawString = (LibPERawResourceString(T) *)m_pLoader->GetBuffer(nRawOffset, nRawStringSize);
+    if(NULL == pRawString) {
         return NULL;
     }
 
-    return (LibPERawResourceString(T) *)pRawStringSize;
+    nSize = nRawStringSize;
+
+    return pRawString;
 }
 
 template <class T>
@@ -653,16 +798,63 @@ PEParserT<T>::ParseResourceStringU(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize
     LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, NULL);
 
     PEAddress nRawOffset = GetRawOffset(nRVA, nFOA);
-    UINT16 *pRawStringSize = (UINT16 *)m_pLoader->GetBuffer(nRawOffset, sizeof(UINT16));
-    if(NULL == pRawStringSize) {
+    UINT16 nRawStringLength = 0;
+    if(!m_pLoader->ReadData(nRawOffset, &nRawStringLength, sizeof(UINT16))) {
         return NULL;
     }
 
-    if(NULL == m_pLoader->GetBuffer(nRawOffset + sizeof(UINT16), *pRawStringSize)) {
+    // The length of the unicode string is in UTF-16 units, which are not wchar_t everywhere.
+    UINT64 nRawStringSize = sizeof(UINT16) + nRawStringLength * sizeof(UINT16);
+    LibPERawResourceStringU(T) *pRawString = (LibPERawResourceStringU(T) *)m_pLoader->GetBuffer(nRawOffset, nRawStringSize);
+    if(NULL == pRawString) {
         return NULL;
     }
 
-    return (LibPERawResourceStringU(T) *)pRawStringSize;
+    nSize = nRawStringSize;
+
+    return pRawString;
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::ParseVersionInfo(IPEResource *pResource, IPEVersionInfo **ppVersionInfo)
+{
+    LIBPE_ASSERT_RET(NULL != pResource && NULL != ppVersionInfo, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
+
+    *ppVersionInfo = NULL;
+
+    LibPEPtr<PEVersionInfoT<T>> pInnerVersionInfo = new (m_pArena) PEVersionInfoT<T>();
+    if(NULL == pInnerVersionInfo) {
+        return E_OUTOFMEMORY;
+    }
+
+    // The version info covers the same bytes as the resource. It loads them by itself, so it can outlive the resource,
+    // and the loader hands out the buffer of the resource again if it is still alive.
+    pInnerVersionInfo->InnerSetBase(m_pFile, this);
+    pInnerVersionInfo->InnerSetMemoryInfo(pResource->GetRVA(), 0, pResource->GetSizeInMemory());
+    pInnerVersionInfo->InnerSetFileInfo(0, pResource->GetSizeInFile());
+
+    if(!pInnerVersionInfo->Decode()) {
+        return E_FAIL;
+    }
+
+    *ppVersionInfo = pInnerVersionInfo.Detach();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::GetResourceAddress(UINT32 nOffset, PEAddress &nRVA, PEAddress &nFOA)
+{
+    LIBPE_ASSERT_RET(0 != m_nResourceTableRVA, E_FAIL);
+
+    // The FOA of the resource table can be 0 when the image is parsed from memory, and then only the RVA is used.
+    nRVA = m_nResourceTableRVA + nOffset;
+    nFOA = (0 != m_nResourceTableFOA) ? m_nResourceTableFOA + nOffset : 0;
+
+    return S_OK;
 }
 
 template <class T>
@@ -693,7 +885,9 @@ PEParserT<T>::ParseRelocationTable(IPERelocationTable **ppRelocationTable)
         return E_FAIL;
     }
 
-    LibPEPtr<PERelocationTableT<T>> pRelocationTable = new PERelocationTableT<T>();
+    PrefetchRange(nRelocationTableRVA, nRelocationTableFOA, nRelocationTableSize);
+
+    LibPEPtr<PERelocationTableT<T>> pRelocationTable = new (m_pArena) PERelocationTableT<T>();
     if(NULL == pRelocationTable) {
         return E_OUTOFMEMORY;
     }
@@ -702,57 +896,97 @@ PEParserT<T>::ParseRelocationTable(IPERelocationTable **ppRelocationTable)
     pRelocationTable->InnerSetMemoryInfo(nRelocationTableRVA, 0, nRelocationTableSize);
     pRelocationTable->InnerSetFileInfo(nRelocationTableFOA, nRelocationTableSize);
 
-    LibPERawBaseRelocation(T) *pRawRelocationPage = (LibPERawBaseRelocation(T) *)pRelocationTable->GetRawStruct();
-    if(NULL == pRawRelocationPage) {
+    UINT8 *pRawRelocationTable = (UINT8 *)pRelocationTable->GetRawStruct();
+    if(NULL == pRawRelocationTable) {
         return E_OUTOFMEMORY;
     }
 
-    PEAddress nRelocationPageRVA = nRelocationTableRVA;
-    PEAddress nRelocationPageFOA = nRelocationTableFOA;
-    while(0 != pRawRelocationPage->VirtualAddress) {
-        UINT16 *pRawItemList = (UINT16 *)(&pRawRelocationPage[1]);
-        UINT32 nItemIndex = 0;
-        UINT32 nItemCount = (pRawRelocationPage->SizeOfBlock - sizeof(LibPERawBaseRelocation(T))) / sizeof(UINT16);
+    // Only walk the block headers here. The pages and items are created when they are asked for.
+    PEAddress nBlockOffset = 0;
+    while(nBlockOffset + sizeof(LibPERawBaseRelocation(T)) <= nRelocationTableSize) {
+        LibPERawBaseRelocation(T) *pRawBlock = (LibPERawBaseRelocation(T) *)(pRawRelocationTable + nBlockOffset);
+        if(0 == pRawBlock->VirtualAddress || pRawBlock->SizeOfBlock < sizeof(LibPERawBaseRelocation(T))) {
+            break;
+        }
 
-        LibPEPtr<PERelocationPageT<T>> pRelocationPage = new PERelocationPageT<T>;
-        if(NULL == pRelocationPage) {
-            return E_OUTOFMEMORY;
+        PEAddress nBlockSize = pRawBlock->SizeOfBlock;
+        if(nBlockSize > nRelocationTableSize - nBlockOffset) {
+            nBlockSize = nRelocationTableSize - nBlockOffset;
         }
 
-        PEAddress nPageSize = sizeof(LibPERawBaseRelocation(T)) + nItemCount * sizeof(UINT16);
+        UINT32 nItemCount = (UINT32)((nBlockSize - sizeof(LibPERawBaseRelocation(T))) / sizeof(UINT16));
+        pRelocationTable->InnerAddRelocationBlock((UINT32)nBlockOffset, nItemCount);
+
+        nBlockOffset += nBlockSize;
+    }
 
-        pRelocationPage->InnerSetBase(m_pFile, this);
-        pRelocationPage->InnerSetMemoryInfo(nRelocationPageRVA, 0, nPageSize);
-        pRelocationPage->InnerSetFileInfo(nRelocationPageFOA, nPageSize);
+    if(!pRelocationTable->PrepareForUsing()) {
+        return E_FAIL;
+    }
 
-        pRelocationTable->InnerAddRelocationPage(pRelocationPage);
+    *ppRelocationTable = pRelocationTable.Detach();
 
-        PEAddress nRelocationItemRVA = nRelocationPageRVA + sizeof(LibPERawBaseRelocation(T));
-        PEAddress nRelocationItemFOA = nRelocationPageFOA + sizeof(LibPERawBaseRelocation(T));
-        while(nItemIndex < nItemCount) {
-            LibPEPtr<PERelocationItemT<T>> pRelocationItem = new PERelocationItemT<T>();
-            if(NULL == pRelocationItem) {
-                return E_OUTOFMEMORY;
-            }
+    return S_OK;
+}
 
-            pRelocationItem->InnerSetBase(m_pFile, this);
-            pRelocationItem->InnerSetMemoryInfo(nRelocationItemRVA, 0, sizeof(UINT16));
-            pRelocationItem->InnerSetFileInfo(nRelocationItemFOA, sizeof(UINT16));
-            pRelocationItem->InnerSetRelocateFlag(pRawItemList[nItemIndex] & 0xF000);
-            pRelocationItem->InnerSetAddressRVA(pRawRelocationPage->VirtualAddress + (pRawItemList[nItemIndex] & 0x0FFF));
-            pRelocationPage->InnerAddRelocationItem(pRelocationItem);
+template <class T>
+HRESULT
+PEParserT<T>::ParseRelocationPage(IPERelocationTable *pRelocationTable, UINT32 nIndex, IPERelocationPage **ppRelocationPage)
+{
+    LIBPE_ASSERT_RET(NULL != pRelocationTable && NULL != ppRelocationPage, E_POINTER);
 
-            nRelocationItemRVA += sizeof(UINT16);
-            nRelocationItemFOA += sizeof(UINT16);
-            ++nItemIndex;
-        }
+    PERelocationTableT<T> *pRawRelocationTable = static_cast<PERelocationTableT<T> *>(pRelocationTable);
+    const PERelocationBlock *pBlock = pRawRelocationTable->GetRelocationBlock(nIndex);
+    LIBPE_ASSERT_RET(NULL != pBlock, E_INVALIDARG);
 
-        nRelocationPageRVA = nRelocationItemRVA;
-        nRelocationPageFOA = nRelocationItemFOA;
-        pRawRelocationPage = (LibPERawBaseRelocation(T) *)(((UINT8 *)pRawRelocationPage) + sizeof(LibPERawBaseRelocation(T)) + sizeof(UINT16) * nItemCount);
+    LibPEPtr<PERelocationPageT<T>> pRelocationPage = new (m_pArena) PERelocationPageT<T>();
+    if(NULL == pRelocationPage) {
+        return E_OUTOFMEMORY;
     }
 
-    *ppRelocationTable = pRelocationTable.Detach();
+    PEAddress nPageRVA = pRawRelocationTable->GetRVA() + pBlock->nOffset;
+    PEAddress nPageFOA = pRawRelocationTable->GetFOA() + pBlock->nOffset;
+    PEAddress nPageSize = sizeof(LibPERawBaseRelocation(T)) + pBlock->nItemCount * sizeof(UINT16);
+
+    pRelocationPage->InnerSetBase(m_pFile, this);
+    pRelocationPage->InnerSetMemoryInfo(nPageRVA, 0, nPageSize);
+    pRelocationPage->InnerSetFileInfo(nPageFOA, nPageSize);
+
+    if(!pRelocationPage->PrepareForUsing(pBlock->nItemCount)) {
+        return E_FAIL;
+    }
+
+    *ppRelocationPage = pRelocationPage.Detach();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::ParseRelocationItem(IPERelocationPage *pRelocationPage, UINT32 nIndex, IPERelocationItem **ppRelocationItem)
+{
+    LIBPE_ASSERT_RET(NULL != pRelocationPage && NULL != ppRelocationItem, E_POINTER);
+
+    PERelocationPageT<T> *pRawRelocationPage = static_cast<PERelocationPageT<T> *>(pRelocationPage);
+    LibPERawBaseRelocation(T) *pRawBlock = pRawRelocationPage->GetRawStruct();
+    LIBPE_ASSERT_RET(NULL != pRawBlock, E_FAIL);
+    LIBPE_ASSERT_RET(nIndex < pRawRelocationPage->GetItemCount(), E_INVALIDARG);
+
+    LibPEPtr<PERelocationItemT<T>> pRelocationItem = new (m_pArena) PERelocationItemT<T>();
+    if(NULL == pRelocationItem) {
+        return E_OUTOFMEMORY;
+    }
+
+    UINT16 nRawItem = ((UINT16 *)(&pRawBlock[1]))[nIndex];
+    PEAddress nItemOffset = sizeof(LibPERawBaseRelocation(T)) + nIndex * sizeof(UINT16);
+
+    pRelocationItem->InnerSetBase(m_pFile, this);
+    pRelocationItem->InnerSetMemoryInfo(pRawRelocationPage->GetRVA() + nItemOffset, 0, sizeof(UINT16));
+    pRelocationItem->InnerSetFileInfo(pRawRelocationPage->GetFOA() + nItemOffset, sizeof(UINT16));
+    pRelocationItem->InnerSetRelocateFlag(nRawItem & 0xF000);
+    pRelocationItem->InnerSetAddressRVA(pRawBlock->VirtualAddress + (nRawItem & 0x0FFF));
+
+    *ppRelocationItem = pRelocationItem.Detach();
 
     return S_OK;
 }
@@ -782,7 +1016,83 @@ template <class T>
 HRESULT
 PEParserT<T>::ParseBoundImportTable(IPEBoundImportTable **ppBoundImportTable)
 {
-    return E_NOTIMPL;
+    LIBPE_ASSERT_RET(NULL != ppBoundImportTable, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
+
+    *ppBoundImportTable = NULL;
+
+    PEAddress nBoundImportTableRVA = 0, nBoundImportTableFOA = 0, nBoundImportTableSize = 0;
+    if(FAILED(GetDataDirectoryEntry(IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT, nBoundImportTableRVA, nBoundImportTableFOA, nBoundImportTableSize))) {
+        return E_FAIL;
+    }
+
+    LibPEPtr<PEBoundImportTableT<T>> pBoundImportTable = new (m_pArena) PEBoundImportTableT<T>();
+    if(NULL == pBoundImportTable) {
+        return E_OUTOFMEMORY;
+    }
+
+    pBoundImportTable->InnerSetBase(m_pFile, this);
+    pBoundImportTable->InnerSetMemoryInfo(nBoundImportTableRVA, 0, nBoundImportTableSize);
+    pBoundImportTable->InnerSetFileInfo(nBoundImportTableFOA, nBoundImportTableSize);
+
+    // The descriptors are in the memory of the table, the same as the regular import descriptors.
+    UINT8 *pRawBoundImportTable = (UINT8 *)pBoundImportTable->GetRawStruct();
+    if(NULL == pRawBoundImportTable) {
+        return E_OUTOFMEMORY;
+    }
+
+    // Each descriptor is followed by its forwarder refs, and the table ends with an empty descriptor.
+    PEAddress nDescOffset = 0;
+    while(nDescOffset + sizeof(LibPERawBoundImportDescriptor(T)) <= nBoundImportTableSize) {
+        LibPERawBoundImportDescriptor(T) *pBoundImportDesc = (LibPERawBoundImportDescriptor(T) *)(pRawBoundImportTable + nDescOffset);
+        if(0 == pBoundImportDesc->TimeDateStamp && 0 == pBoundImportDesc->OffsetModuleName) {
+            break;
+        }
+
+        pBoundImportTable->InnerAddBoundImportDescriptor(nBoundImportTableRVA + nDescOffset, nBoundImportTableFOA + nDescOffset, pBoundImportDesc);
+        nDescOffset += sizeof(LibPERawBoundImportDescriptor(T)) + pBoundImportDesc->NumberOfModuleForwarderRefs * sizeof(LibPERawBoundForwarderRef(T));
+    }
+
+    *ppBoundImportTable = pBoundImportTable.Detach();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::ParseBoundImportModule(PEAddress nBoundImportTableRVA, PEAddress nBoundImportDescRVA, PEAddress nBoundImportDescFOA, LibPERawBoundImportDescriptor(T) *pBoundImportDesc, IPEBoundImportModule **ppBoundImportModule)
+{
+    LIBPE_ASSERT_RET(NULL != pBoundImportDesc && NULL != ppBoundImportModule, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
+
+    *ppBoundImportModule = NULL;
+
+    LibPEPtr<PEBoundImportModuleT<T>> pBoundImportModule = new (m_pArena) PEBoundImportModuleT<T>();
+    if(NULL == pBoundImportModule) {
+        return E_OUTOFMEMORY;
+    }
+
+    PEAddress nBoundImportModuleSize = sizeof(LibPERawBoundImportDescriptor(T)) + pBoundImportDesc->NumberOfModuleForwarderRefs * sizeof(LibPERawBoundForwarderRef(T));
+
+    pBoundImportModule->InnerSetBase(m_pFile, this);
+    pBoundImportModule->InnerSetMemoryInfo(nBoundImportDescRVA, 0, nBoundImportModuleSize);
+    pBoundImportModule->InnerSetFileInfo(nBoundImportDescFOA, nBoundImportModuleSize);
+    pBoundImportModule->InnerSetBoundImportTableRVA(nBoundImportTableRVA);
+
+    UINT64 nNameSize = 0;
+    pBoundImportModule->InnerSetName(pBoundImportModule->KeepAnsiString(nBoundImportTableRVA + pBoundImportDesc->OffsetModuleName, 0, nNameSize));
+
+    // The forwarder refs follow the descriptor, so they are in the memory of the module already.
+    if(0 != pBoundImportDesc->NumberOfModuleForwarderRefs) {
+        LibPERawBoundImportDescriptor(T) *pRawBoundImportDesc = pBoundImportModule->GetRawStruct();
+        if(NULL != pRawBoundImportDesc) {
+            pBoundImportModule->InnerSetForwarderRefs((LibPERawBoundForwarderRef(T) *)&pRawBoundImportDesc[1], pBoundImportDesc->NumberOfModuleForwarderRefs);
+        }
+    }
+
+    *ppBoundImportModule = pBoundImportModule.Detach();
+
+    return S_OK;
 }
 
 template <class T>
@@ -799,7 +1109,9 @@ PEParserT<T>::ParseImportAddressTable(IPEImportAddressTable **ppImportAddressTab
         return E_FAIL;
     }
 
-    LibPEPtr<PEImportAddressTableT<T>> pImportAddressTable = new PEImportAddressTableT<T>();
+    PrefetchRange(nImportAddressTableRVA, nImportAddressTableFOA, nImportAddressTableSize);
+
+    LibPEPtr<PEImportAddressTableT<T>> pImportAddressTable = new (m_pArena) PEImportAddressTableT<T>();
     if(NULL == pImportAddressTable) {
         return E_OUTOFMEMORY;
     }
@@ -854,13 +1166,13 @@ PEParserT<T>::ParseImportAddressBlock(LibPERawThunkData(T) *pRawBlock, PEAddress
 
     *ppBlock = NULL;
 
-    LibPEPtr<PEImportAddressBlockT<T>> pBlock = new PEImportAddressBlockT<T>();
+    LibPEPtr<PEImportAddressBlockT<T>> pBlock = new (m_pArena) PEImportAddressBlockT<T>();
     if(NULL == pBlock) {
         return E_OUTOFMEMORY;
     }
 
+    // The block and the items load their own memory when it is used, because they may outlive the table.
     pBlock->InnerSetBase(m_pFile, this);
-    pBlock->InnerSetRawMemory(pRawBlock);
     pBlock->InnerSetMemoryInfo(nBlockRVA, 0, 0);
     pBlock->InnerSetFileInfo(nBlockFOA, 0);
 
@@ -869,13 +1181,16 @@ PEParserT<T>::ParseImportAddressBlock(LibPERawThunkData(T) *pRawBlock, PEAddress
         nBlockFOA = GetFOAFromRVA(nBlockRVA);
     }
 
-    // If the RawBlock is NULL, we should ready the memory ourself.
+    // If the RawBlock is NULL, we should read the items ourself. They are only probed for the end of the block,
+    // so they are copied instead of being kept in the loader.
+    PEAddress nBlockRawOffset = GetRawOffset(nBlockRVA, nBlockFOA);
+    LibPERawThunkData(T) oRawItem;
     LibPERawThunkData(T) *pRawItem = NULL;
     BOOL bNeedLoadMemory = false;
     if(NULL == pRawBlock) {
         LIBPE_ASSERT_RET(NULL != m_pLoader, E_FAIL);
-        pRawItem = (LibPERawThunkData(T) *)m_pLoader->GetBuffer(nBlockFOA, sizeof(LibPERawThunkData(T)));
-        LIBPE_ASSERT_RET(NULL != pRawItem, E_OUTOFMEMORY);
+        LIBPE_ASSERT_RET(m_pLoader->ReadData(nBlockRawOffset, &oRawItem, sizeof(LibPERawThunkData(T))), E_OUTOFMEMORY);
+        pRawItem = &oRawItem;
         bNeedLoadMemory = true;
     } else {
         pRawItem = pRawBlock;
@@ -893,8 +1208,7 @@ PEParserT<T>::ParseImportAddressBlock(LibPERawThunkData(T) *pRawBlock, PEAddress
         nBlockSize += sizeof(LibPERawThunkData(T));
 
         if(bNeedLoadMemory) {
-            pRawItem = (LibPERawThunkData(T) *)m_pLoader->GetBuffer(nBlockFOA + nBlockSize, sizeof(LibPERawThunkData(T)));
-            LIBPE_ASSERT_RET(NULL != pRawItem, E_OUTOFMEMORY);
+            LIBPE_ASSERT_RET(m_pLoader->ReadData(nBlockRawOffset + nBlockSize, &oRawItem, sizeof(LibPERawThunkData(T))), E_OUTOFMEMORY);
         } else {
             ++pRawItem;
         }
@@ -921,15 +1235,14 @@ PEParserT<T>::ParseImportAddressItem(LibPERawThunkData(T) *pRawItem, PEAddress n
 
     *ppItem = NULL;
 
-    LibPEPtr<PEImportAddressItemT<T>> pItem = new PEImportAddressItemT<T>();
+    LibPEPtr<PEImportAddressItemT<T>> pItem = new (m_pArena) PEImportAddressItemT<T>();
     if(NULL == pItem) {
         return E_OUTOFMEMORY;
     }
 
     pItem->InnerSetBase(m_pFile, this);
-    pItem->InnerSetRawMemory(pRawItem);
     pItem->InnerSetMemoryInfo(nItemRVA, 0, sizeof(LibPERawThunkData(T)));
-    pItem->InnerSetFileInfo(nItemRVA, sizeof(LibPERawThunkData(T)));
+    pItem->InnerSetFileInfo(nItemFOA, sizeof(LibPERawThunkData(T)));
 
     *ppItem = pItem.Detach();
 
@@ -940,7 +1253,88 @@ template <class T>
 HRESULT
 PEParserT<T>::ParseDelayImportTable(IPEDelayImportTable **ppDelayImportTable)
 {
-    return E_NOTIMPL;
+    LIBPE_ASSERT_RET(NULL != ppDelayImportTable, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
+
+    *ppDelayImportTable = NULL;
+
+    PEAddress nDelayImportTableRVA = 0, nDelayImportTableFOA = 0, nDelayImportTableSize = 0;
+    if(FAILED(GetDataDirectoryEntry(IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT, nDelayImportTableRVA, nDelayImportTableFOA, nDelayImportTableSize))) {
+        return E_FAIL;
+    }
+
+    LibPEPtr<PEDelayImportTableT<T>> pDelayImportTable = new (m_pArena) PEDelayImportTableT<T>();
+    if(NULL == pDelayImportTable) {
+        return E_OUTOFMEMORY;
+    }
+
+    pDelayImportTable->InnerSetBase(m_pFile, this);
+    pDelayImportTable->InnerSetMemoryInfo(nDelayImportTableRVA, 0, nDelayImportTableSize);
+    pDelayImportTable->InnerSetFileInfo(nDelayImportTableFOA, nDelayImportTableSize);
+
+    UINT8 *pRawDelayImportTable = (UINT8 *)pDelayImportTable->GetRawStruct();
+    if(NULL == pRawDelayImportTable) {
+        return E_OUTOFMEMORY;
+    }
+
+    // The descriptors end with an empty one, the same as the regular import descriptors, and they never go beyond the
+    // size of the directory, so a missing terminator can't make us walk the rest of the file.
+    PEAddress nDescOffset = 0;
+    while(nDescOffset + sizeof(LibPERawDelayImportDescriptor(T)) <= nDelayImportTableSize) {
+        LibPERawDelayImportDescriptor(T) *pDelayImportDesc = (LibPERawDelayImportDescriptor(T) *)(pRawDelayImportTable + nDescOffset);
+        if(0 == pDelayImportDesc->DllNameRVA) {
+            break;
+        }
+
+        pDelayImportTable->InnerAddDelayImportDescriptor(nDelayImportTableRVA + nDescOffset, nDelayImportTableFOA + nDescOffset, pDelayImportDesc);
+        nDescOffset += sizeof(LibPERawDelayImportDescriptor(T));
+    }
+
+    *ppDelayImportTable = pDelayImportTable.Detach();
+
+    return S_OK;
+}
+
+template <class T>
+HRESULT
+PEParserT<T>::ParseDelayImportModule(PEAddress nDelayImportDescRVA, PEAddress nDelayImportDescFOA, LibPERawDelayImportDescriptor(T) *pDelayImportDesc, IPEDelayImportModule **ppDelayImportModule)
+{
+    LIBPE_ASSERT_RET(NULL != pDelayImportDesc && NULL != ppDelayImportModule, E_POINTER);
+    LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, E_FAIL);
+
+    *ppDelayImportModule = NULL;
+
+    LibPEPtr<PEDelayImportModuleT<T>> pDelayImportModule = new (m_pArena) PEDelayImportModuleT<T>();
+    if(NULL == pDelayImportModule) {
+        return E_OUTOFMEMORY;
+    }
+
+    pDelayImportModule->InnerSetBase(m_pFile, this);
+    pDelayImportModule->InnerSetMemoryInfo(nDelayImportDescRVA, 0, sizeof(LibPERawDelayImportDescriptor(T)));
+    pDelayImportModule->InnerSetFileInfo(nDelayImportDescFOA, sizeof(LibPERawDelayImportDescriptor(T)));
+
+    // Without the RvaBased attribute, the descriptor was written by an old linker and holds VAs, including the ones in the thunks.
+    // Only the module name is resolved for them, because the thunks cannot be read as the regular ones.
+    BOOL bIsRVABased = (0 != (pDelayImportDesc->Attributes & PE_DELAY_IMPORT_ATTRIBUTE_RVA_BASED));
+    PEAddress nNameRVA = bIsRVABased ? pDelayImportDesc->DllNameRVA : GetRVAFromVA(pDelayImportDesc->DllNameRVA);
+
+    UINT64 nNameSize = 0;
+    pDelayImportModule->InnerSetName(pDelayImportModule->KeepAnsiString(nNameRVA, 0, nNameSize));
+
+    if(bIsRVABased && 0 != pDelayImportDesc->ImportNameTableRVA) {
+        ThunkDataList vThunks;
+        if(FAILED(ParseImportThunks(pDelayImportDesc->ImportNameTableRVA, vThunks))) {
+            return E_FAIL;
+        }
+
+        for(UINT32 nThunkIndex = 0; nThunkIndex < (UINT32)vThunks.size(); ++nThunkIndex) {
+            pDelayImportModule->InnerAddImportFunctionThunk(vThunks[nThunkIndex]);
+        }
+    }
+
+    *ppDelayImportModule = pDelayImportModule.Detach();
+
+    return S_OK;
 }
 
 template <class T>
@@ -2,23 +2,29 @@
 
 #include "Parser/PEParserCommon.h"
 #include "Parser/DataLoader.h"
+#include "PE/PEArena.h"
 
 LIBPE_NAMESPACE_BEGIN
 
 template <class T> class PEFileT;
 
+enum {
+    MAX_SYNC_PREFETCH_SIZE  = 0x10000,
+};
+
 template <class T>
 class PEParserT :
     public ILibPEInterface
 {
 public:
     typedef std::vector<LibPEPtr<IPESectionHeader>> SectionHeaderList;
+    typedef std::vector<LibPERawThunkData(T)> ThunkDataList;
 
 public:
     static LibPEPtr<PEParserT<T>> Create(PEParserType nType);
 
 public:
-    PEParserT() : m_pFile(NULL) {}
+    PEParserT() : m_pFile(NULL), m_pArena(new PEArena), m_nResourceTableRVA(0), m_nResourceTableFOA(0) {}
     virtual ~PEParserT() {}
 
     LIBPE_SINGLE_THREAD_OBJECT();
@@ -37,11 +43,22 @@ public:
     virtual PEAddress GetVAFromFOA(PEAddress nFOA);
     virtual PEAddress GetFOAFromVA(PEAddress nVA);
 
+    PEAddress GetRawOffset(PEAddress nRVA, PEAddress nFOA)
+    {
+        LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, NULL);
+        return (0 != nRVA) ? GetRawOffsetFromRVA(nRVA) : GetRawOffsetFromFOA(nFOA);
+    }
+
     // Raw memory getter
     virtual void * GetRawMemory(UINT64 nOffset, UINT64 nSize);
+    virtual void ReleaseRawMemory(void *pBuffer, UINT64 nOffset, UINT64 nSize);
+    virtual BOOL ReadRawData(UINT64 nOffset, void *pBuffer, UINT64 nSize);
+    BOOL IsRawDataOverlapped(const void *pBuffer, UINT64 nSize) { return (NULL != m_pLoader && m_pLoader->IsOverlapped(pBuffer, nSize)); }
+    virtual void PrefetchDataDirectories();
 
-    // String parser
+    // String parser, the strings are given back by ReleaseAnsiString with the same address and size.
     virtual const char * ParseAnsiString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize);
+    virtual void ReleaseAnsiString(const char *pString, PEAddress nRVA, PEAddress nFOA, UINT64 nSize);
     virtual const wchar_t * ParseUnicodeString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize);
 
     // Basic info related functions
@@ -55,7 +72,11 @@ public:
     // Import table related functions
     virtual HRESULT ParseImportTable(IPEImportTable **ppImportTable);
     virtual HRESULT ParseImportModule(PEAddress nImportDescRVA, PEAddress nImportDescFOA, LibPERawImportDescriptor(T) *pImportDescriptor, IPEImportModule **ppImportModule);
-    virtual HRESULT ParseImportFunction(LibPERawImportDescriptor(T) *pImportDescriptor, LibPERawThunkData(T) *pThunkData, IPEImportFunction **ppFunction);
+    virtual HRESULT ParseImportThunks(LibPERawImportDescriptor(T) *pImportDescriptor, ThunkDataList &vThunks);
+    virtual HRESULT ParseImportThunks(PEAddress nImportThunkRVA, ThunkDataList &vThunks);
+    virtual HRESULT ParseImportFunction(const LibPERawThunkData(T) *pThunkData, IPEImportFunction **ppFunction);
+    virtual LibPERawImportByName(T) * ParseImportByName(PEAddress nRVA, UINT64 &nNameSize);
+    virtual void ReleaseImportByName(LibPERawImportByName(T) *pImportByName, PEAddress nRVA, UINT64 nNameSize);
 
     // Resource table related functions
     virtual HRESULT ParseResourceTable(IPEResourceTable **ppResourceTable);
@@ -65,17 +86,24 @@ public:
     virtual HRESULT ParseResource(IPEResourceDataEntry *pDataEntry, IPEResource **ppResource);
     virtual LibPERawResourceString(T) * ParseResourceString(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize);
     virtual LibPERawResourceStringU(T) * ParseResourceStringU(PEAddress nRVA, PEAddress nFOA, UINT64 &nSize);
+    virtual HRESULT GetResourceAddress(UINT32 nOffset, PEAddress &nRVA, PEAddress &nFOA);
+    virtual HRESULT ParseVersionInfo(IPEResource *pResource, IPEVersionInfo **ppVersionInfo);
 
     virtual HRESULT ParseExceptionTable(IPEExceptionTable **ppExceptionTable);
     virtual HRESULT ParseCertificateTable(IPECertificateTable **ppCertificateTable);
 
     // Relocation table related functions.
     virtual HRESULT ParseRelocationTable(IPERelocationTable **ppRelocationTable);
+    virtual HRESULT ParseRelocationPage(IPERelocationTable *pRelocationTable, UINT32 nIndex, IPERelocationPage **ppRelocationPage);
+    virtual HRESULT ParseRelocationItem(IPERelocationPage *pRelocationPage, UINT32 nIndex, IPERelocationItem **ppRelocationItem);
 
     virtual HRESULT ParseDebugInfoTable(IPEDebugInfoTable **ppDebugInfoTable);
     virtual HRESULT ParseGlobalRegister(IPEGlobalRegister **ppGlobalRegister);
     virtual HRESULT ParseTlsTable(IPETlsTable **ppTlsTable);
+
+    // Bound import table related functions.
     virtual HRESULT ParseBoundImportTable(IPEBoundImportTable **ppBoundImportTable);
+    virtual HRESULT ParseBoundImportModule(PEAddress nBoundImportTableRVA, PEAddress nBoundImportDescRVA, PEAddress nBoundImportDescFOA, LibPERawBoundImportDescriptor(T) *pBoundImportDesc, IPEBoundImportModule **ppBoundImportModule);
 
     // Import Address table related functions.
     virtual HRESULT ParseImportAddressTable(IPEImportAddressTable **ppImportAddressTable);
@@ -83,7 +111,10 @@ public:
     virtual HRESULT ParseImportAddressBlock(LibPERawThunkData(T) *pRawBlock, PEAddress nBlockRVA, PEAddress nBlockFOA, IPEImportAddressBlock **ppBlock);
     virtual HRESULT ParseImportAddressItem(LibPERawThunkData(T) *pRawItem, PEAddress nItemRVA, PEAddress nItemFOA, IPEImportAddressItem **ppItem);
 
+    // Delay import table related functions.
     virtual HRESULT ParseDelayImportTable(IPEDelayImportTable **ppDelayImportTable);
+    virtual HRESULT ParseDelayImportModule(PEAddress nDelayImportDescRVA, PEAddress nDelayImportDescFOA, LibPERawDelayImportDescriptor(T) *pDelayImportDesc, IPEDelayImportModule **ppDelayImportModule);
+
     virtual HRESULT ParseCLRHeader(IPECLRHeader **ppCLRHeader);
 
 protected:
@@ -95,10 +126,17 @@ protected:
     virtual PEAddress GetRVAFromRawOffset(PEAddress nRawOffset) = 0;
     virtual PEAddress GetFOAFromRawOffset(PEAddress nRawOffset) = 0;
 
-    PEAddress GetRawOffset(PEAddress nRVA, PEAddress nFOA)
+    void PrefetchRange(PEAddress nRVA, PEAddress nFOA, PEAddress nSize)
     {
-        LIBPE_ASSERT_RET(NULL != m_pLoader && NULL != m_pFile, NULL);
-        return (0 != nRVA) ? GetRawOffsetFromRVA(nRVA) : GetRawOffsetFromFOA(nFOA);
+        LIBPE_ASSERT_RET_VOID(NULL != m_pLoader);
+
+        // A synchronous prefetch blocks us until the whole range is read, while most callers only need the head of a
+        // table, such as the root directory of the resources. So only a small window is read ahead then.
+        if(!m_pLoader->IsPrefetchAsync() && nSize > MAX_SYNC_PREFETCH_SIZE) {
+            nSize = MAX_SYNC_PREFETCH_SIZE;
+        }
+
+        m_pLoader->Prefetch(GetRawOffset(nRVA, nFOA), nSize);
     }
 
     HRESULT GetDataDirectoryEntry(INT32 nDataDirectoryEntryIndex, PEAddress &nRVA, PEAddress &nFOA, PEAddress &nSize)
@@ -117,7 +155,7 @@ protected:
         nRVA = GetRVAFromAddressField(pDataDirectory->VirtualAddress);
         nSize = pDataDirectory->Size;
         nFOA = GetFOAFromRVA(nRVA);
-        if(0 == nFOA) {
+        if(0 == nFOA && !IsRawAddressVA()) {
             return E_FAIL;
         }
 
@@ -127,6 +165,9 @@ protected:
 protected:
     LibPEPtr<DataLoader>    m_pLoader;
     PEFileT<T>              *m_pFile;
+    LibPEPtr<PEArena>       m_pArena;
+    PEAddress               m_nResourceTableRVA;
+    PEAddress               m_nResourceTableFOA;
 };
 
 typedef PEParserT<PE32> PEParser32;
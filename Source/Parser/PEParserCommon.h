@@ -5,6 +5,7 @@ LIBPE_NAMESPACE_BEGIN
 enum PEParserType {
     PE_PARSER_TYPE_DISK_FILE        = 1,
     PE_PARSER_TYPE_MAPPED_FILE,
+    PE_PARSER_TYPE_LOADED_IMAGE,
 
 #ifdef LIBPE_WINOS
     PE_PARSER_TYPE_MAPPED_RESOURCE,
@@ -4,5 +4,7 @@
 LIBPE_NAMESPACE_BEGIN
 
 LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEParserDiskFileT);
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEParserMappedFileT);
+LIBPE_FORCE_TEMPLATE_REDUCTION_CLASS(PEParserLoadedImageT);
 
 LIBPE_NAMESPACE_END
\ No newline at end of file
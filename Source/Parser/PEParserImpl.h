@@ -16,23 +16,65 @@ public:
     virtual BOOL IsRawAddressVA() { return false; }
 
 protected:
-    virtual PEAddress GetRawOffsetFromAddressField(PEAddress nAddress) { return GetFOAFromRVA(nAddress); }
+    virtual PEAddress GetRawOffsetFromAddressField(PEAddress nAddress) { return this->GetFOAFromRVA(nAddress); }
     virtual PEAddress GetRVAFromAddressField(PEAddress nAddress) { return nAddress; }
-    virtual PEAddress GetFOAFromAddressField(PEAddress nAddress) { return GetFOAFromRVA(nAddress); }
-    virtual PEAddress GetRawOffsetFromRVA(PEAddress nRVA) { return GetFOAFromRVA(nRVA); }
+    virtual PEAddress GetFOAFromAddressField(PEAddress nAddress) { return this->GetFOAFromRVA(nAddress); }
+    virtual PEAddress GetRawOffsetFromRVA(PEAddress nRVA) { return this->GetFOAFromRVA(nRVA); }
     virtual PEAddress GetRawOffsetFromFOA(PEAddress nFOA) { return nFOA; }
-    virtual PEAddress GetRVAFromRawOffset(PEAddress nRawOffset) { return GetFOAFromRVA(nRawOffset); }
+    virtual PEAddress GetRVAFromRawOffset(PEAddress nRawOffset) { return this->GetRVAFromFOA(nRawOffset); }
     virtual PEAddress GetFOAFromRawOffset(PEAddress nRawOffset) { return nRawOffset; }
 };
 typedef PEParserDiskFileT<PE32> PEParserDiskFile32;
 typedef PEParserDiskFileT<PE64> PEParserDiskFile64;
 
+// The mapped file keeps the raw file layout in memory, so the raw offsets are still FOAs.
 template <class T>
 class PEParserMappedFileT :
     public PEParserT<T>
 {
 public:
+    PEParserMappedFileT() {}
+    virtual ~PEParserMappedFileT() {}
+
+    virtual PEParserType GetType() { return PE_PARSER_TYPE_MAPPED_FILE; }
+    virtual BOOL IsRawAddressVA() { return false; }
+
+protected:
+    virtual PEAddress GetRawOffsetFromAddressField(PEAddress nAddress) { return this->GetFOAFromRVA(nAddress); }
+    virtual PEAddress GetRVAFromAddressField(PEAddress nAddress) { return nAddress; }
+    virtual PEAddress GetFOAFromAddressField(PEAddress nAddress) { return this->GetFOAFromRVA(nAddress); }
+    virtual PEAddress GetRawOffsetFromRVA(PEAddress nRVA) { return this->GetFOAFromRVA(nRVA); }
+    virtual PEAddress GetRawOffsetFromFOA(PEAddress nFOA) { return nFOA; }
+    virtual PEAddress GetRVAFromRawOffset(PEAddress nRawOffset) { return this->GetRVAFromFOA(nRawOffset); }
+    virtual PEAddress GetFOAFromRawOffset(PEAddress nRawOffset) { return nRawOffset; }
+};
+typedef PEParserMappedFileT<PE32> PEParserMappedFile32;
+typedef PEParserMappedFileT<PE64> PEParserMappedFile64;
+
+// The loaded image keeps every section at its virtual address, such as a module dumped from a process,
+// so the raw offsets are RVAs and no section walk is needed to reach the data.
+template <class T>
+class PEParserLoadedImageT :
+    public PEParserT<T>
+{
+public:
+    PEParserLoadedImageT() {}
+    virtual ~PEParserLoadedImageT() {}
+
+    virtual PEParserType GetType() { return PE_PARSER_TYPE_LOADED_IMAGE; }
+    virtual BOOL IsRawAddressVA() { return true; }
+
+protected:
+    virtual PEAddress GetRawOffsetFromAddressField(PEAddress nAddress) { return nAddress; }
+    virtual PEAddress GetRVAFromAddressField(PEAddress nAddress) { return nAddress; }
+    virtual PEAddress GetFOAFromAddressField(PEAddress nAddress) { return this->GetFOAFromRVA(nAddress); }
+    virtual PEAddress GetRawOffsetFromRVA(PEAddress nRVA) { return nRVA; }
+    virtual PEAddress GetRawOffsetFromFOA(PEAddress nFOA) { return this->GetRVAFromFOA(nFOA); }
+    virtual PEAddress GetRVAFromRawOffset(PEAddress nRawOffset) { return nRawOffset; }
+    virtual PEAddress GetFOAFromRawOffset(PEAddress nRawOffset) { return this->GetFOAFromRVA(nRawOffset); }
 };
+typedef PEParserLoadedImageT<PE32> PEParserLoadedImage32;
+typedef PEParserLoadedImageT<PE64> PEParserLoadedImage64;
 
 #ifdef LIBPE_WINOS
 
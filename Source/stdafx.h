@@ -29,9 +29,19 @@
 #include <map>
 #include <vector>
 #include <list>
+#include <algorithm>
 
+#ifdef WIN32
 #include <windows.h>
 #include <WinNT.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#endif
 
 #include "LibPE.h"
 #include "LibPEInternal.h"
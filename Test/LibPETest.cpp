@@ -72,7 +72,10 @@ void TestImportTable(IPEFile *pFile)
 
         for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < pImportModule->GetFunctionCount(); ++nImportFunctionIndex) {
             LibPEPtr<IPEImportFunction> pImportFunction;
-            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+            if(FAILED(pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction))) {
+                printf("Import Function: (bound)\n");
+                continue;
+            }
             printf("Import Function: %s\n", pImportFunction->GetName());
         }
 
@@ -183,21 +186,1807 @@ void TestImportAddressTable(IPEFile *pFile)
     }
 }
 
-int wmain(int argc, wchar_t* argv[])
+static UINT32 s_nFailedCheckCount = 0;
+
+void TestCheck(BOOL bPassed, const char *pCheckName)
+{
+    printf("%s: %s\n", bPassed ? "PASS" : "FAIL", pCheckName);
+    if(!bPassed) {
+        ++s_nFailedCheckCount;
+    }
+}
+
+#ifdef LIBPE_WINOS
+
+BOOL ComputeMD5(const void *pData, UINT32 nSize, UINT8 *pDigest)
+{
+    HCRYPTPROV hProvider = NULL;
+    if(!CryptAcquireContext(&hProvider, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT)) {
+        return false;
+    }
+
+    BOOL bSucceeded = false;
+    HCRYPTHASH hHash = NULL;
+    if(CryptCreateHash(hProvider, CALG_MD5, 0, 0, &hHash)) {
+        DWORD nDigestSize = 16;
+        bSucceeded = CryptHashData(hHash, (const BYTE *)pData, nSize, 0) && CryptGetHashParam(hHash, HP_HASHVAL, pDigest, &nDigestSize, 0);
+        CryptDestroyHash(hHash);
+    }
+
+    CryptReleaseContext(hProvider, 0);
+
+    return bSucceeded;
+}
+
+#else
+
+// There is no CryptoAPI here, so the reference digest comes from a plain RFC 1321 implementation.
+void TransformMD5(UINT32 *pState, const UINT8 *pBlock)
+{
+    static const UINT32 s_pShifts[64] = {
+        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+        5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+    };
+    static const UINT32 s_pSines[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+    };
+
+    UINT32 pWords[16];
+    for(UINT32 nIndex = 0; nIndex < 16; ++nIndex) {
+        pWords[nIndex] = pBlock[nIndex * 4] | (pBlock[nIndex * 4 + 1] << 8) | (pBlock[nIndex * 4 + 2] << 16) | ((UINT32)pBlock[nIndex * 4 + 3] << 24);
+    }
+
+    UINT32 a = pState[0], b = pState[1], c = pState[2], d = pState[3];
+    for(UINT32 nStep = 0; nStep < 64; ++nStep) {
+        UINT32 f = 0, g = 0;
+        if(nStep < 16) {
+            f = (b & c) | (~b & d);
+            g = nStep;
+        } else if(nStep < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * nStep + 1) % 16;
+        } else if(nStep < 48) {
+            f = b ^ c ^ d;
+            g = (3 * nStep + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * nStep) % 16;
+        }
+
+        UINT32 nSum = a + f + s_pSines[nStep] + pWords[g];
+        a = d;
+        d = c;
+        c = b;
+        b = b + ((nSum << s_pShifts[nStep]) | (nSum >> (32 - s_pShifts[nStep])));
+    }
+
+    pState[0] += a;
+    pState[1] += b;
+    pState[2] += c;
+    pState[3] += d;
+}
+
+BOOL ComputeMD5(const void *pData, UINT32 nSize, UINT8 *pDigest)
+{
+    UINT32 pState[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+    // The message is padded with 0x80, zeros and its size in bits, up to a whole number of 64 bytes blocks.
+    std::vector<UINT8> vMessage((const UINT8 *)pData, (const UINT8 *)pData + nSize);
+    vMessage.push_back(0x80);
+    while(vMessage.size() % 64 != 56) {
+        vMessage.push_back(0);
+    }
+
+    UINT64 nBitCount = (UINT64)nSize * 8;
+    for(UINT32 nIndex = 0; nIndex < 8; ++nIndex) {
+        vMessage.push_back((UINT8)(nBitCount >> (nIndex * 8)));
+    }
+
+    for(size_t nOffset = 0; nOffset < vMessage.size(); nOffset += 64) {
+        TransformMD5(pState, &vMessage[nOffset]);
+    }
+
+    for(UINT32 nIndex = 0; nIndex < 16; ++nIndex) {
+        pDigest[nIndex] = (UINT8)(pState[nIndex / 4] >> ((nIndex % 4) * 8));
+    }
+
+    return true;
+}
+
+#endif
+
+std::string ToLowerCase(const char *pString)
+{
+    std::string strLowerCase = (NULL != pString) ? pString : "";
+    for(size_t nIndex = 0; nIndex < strLowerCase.size(); ++nIndex) {
+        if(strLowerCase[nIndex] >= 'A' && strLowerCase[nIndex] <= 'Z') {
+            strLowerCase[nIndex] = (char)(strLowerCase[nIndex] - 'A' + 'a');
+        }
+    }
+
+    return strLowerCase;
+}
+
+BOOL ReadWholeFile(const file_char_t *pFilePath, std::vector<UINT8> &vFileData)
+{
+#ifdef LIBPE_WINOS
+    FILE *pFile = _wfopen(pFilePath, L"rb");
+#else
+    FILE *pFile = fopen(pFilePath, "rb");
+#endif
+    if(NULL == pFile) {
+        return false;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    long nFileSize = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    vFileData.resize((size_t)nFileSize);
+    BOOL bSucceeded = (nFileSize > 0 && fread(&vFileData[0], 1, (size_t)nFileSize, pFile) == (size_t)nFileSize);
+    fclose(pFile);
+
+    return bSucceeded;
+}
+
+void TestAddressTranslation(IPEFile *pFile)
+{
+    // The first, middle and last byte of every section are translated in an order which jumps between the sections, so
+    // the last hit is never reused, and each result must match a linear walk of the section headers.
+    std::vector<PEAddress> vRVAs;
+    UINT32 nSectionCount = pFile->GetSectionCount();
+    for(UINT32 nSectionIndex = 0; nSectionIndex < nSectionCount; ++nSectionIndex) {
+        LibPEPtr<IPESectionHeader> pSectionHeader;
+        pFile->GetSectionHeader(nSectionIndex, &pSectionHeader);
+        if(NULL == pSectionHeader || 0 == pSectionHeader->GetFieldSizeOfRawData()) {
+            continue;
+        }
+
+        UINT32 nSize = pSectionHeader->GetFieldSizeOfRawData();
+        if(0 != pSectionHeader->GetFieldVirtualSize() && pSectionHeader->GetFieldVirtualSize() < nSize) {
+            nSize = pSectionHeader->GetFieldVirtualSize();
+        }
+
+        vRVAs.push_back(pSectionHeader->GetFieldVirtualAddress());
+        vRVAs.push_back(pSectionHeader->GetFieldVirtualAddress() + nSize / 2);
+        vRVAs.push_back(pSectionHeader->GetFieldVirtualAddress() + nSize - 1);
+    }
+
+    UINT32 nBadAddressCount = 0;
+    for(UINT32 nIndex = 0; nIndex < vRVAs.size(); ++nIndex) {
+        PEAddress nRVA = vRVAs[(nIndex * 7) % vRVAs.size()];
+
+        PEAddress nExpectedFOA = 0, nSectionRVA = 0;
+        for(UINT32 nSectionIndex = 0; nSectionIndex < nSectionCount; ++nSectionIndex) {
+            LibPEPtr<IPESectionHeader> pSectionHeader;
+            pFile->GetSectionHeader(nSectionIndex, &pSectionHeader);
+            if(NULL != pSectionHeader && nRVA >= pSectionHeader->GetFieldVirtualAddress() && nRVA < pSectionHeader->GetFieldVirtualAddress() + pSectionHeader->GetFieldSizeOfRawData()) {
+                nSectionRVA = pSectionHeader->GetFieldVirtualAddress();
+                nExpectedFOA = pSectionHeader->GetFieldPointerToRawData() + nRVA - nSectionRVA;
+                break;
+            }
+        }
+
+        LibPEPtr<IPESection> pSection;
+        pFile->GetSectionByRVA(nRVA, &pSection);
+        if(pFile->GetFOAFromRVA(nRVA) != nExpectedFOA || pFile->GetRVAFromFOA(nExpectedFOA) != nRVA || NULL == pSection || pSection->GetRVA() != nSectionRVA) {
+            ++nBadAddressCount;
+        }
+    }
+
+    TestCheck(!vRVAs.empty() && 0 == nBadAddressCount, "RVA and FOA translation matches the section headers");
+
+    printf("\n");
+}
+
+void TestBlockCache(const file_char_t *pFilePath)
 {
+    // With a cache of a few small blocks, walking the file evicts the blocks again and again. The names kept by the
+    // export functions must survive that, and every section read through the cache must match the file.
+    SetPELoaderIOBlockSize(0x1000, 0x1000);
+    SetPELoaderCacheSize(0x4000);
+
     LibPEPtr<IPEFile> pFile;
-    ParsePEFromDiskFile(L"C:\\Windows\\system32\\kernel32.dll", &pFile);
+    ParsePEFromDiskFile(pFilePath, &pFile);
 
-    printf("AddRef: %d\n", pFile->AddRef());
-    printf("Release: %d\n", pFile->Release());
+    SetPELoaderIOBlockSize(0, 0);
+    SetPELoaderCacheSize(0);
 
-    TestBasicInfo(pFile);
-    TestSection(pFile);
-    TestExportTable(pFile);
-    TestImportTable(pFile);
-    TestResourceTable(pFile);
-    TestRelocationTable(pFile);
-    TestImportAddressTable(pFile);
+    std::vector<UINT8> vFileData;
+    LibPEPtr<IPEFile> pReferenceFile;
+    if(ReadWholeFile(pFilePath, vFileData)) {
+        ParsePEFromMappedFile(&vFileData[0], vFileData.size(), &pReferenceFile);
+    }
+
+    if(NULL == pFile || NULL == pReferenceFile) {
+        TestCheck(false, "Small block cache");
+        return;
+    }
+
+    LibPEPtr<IPEExportTable> pExportTable;
+    pFile->GetExportTable(&pExportTable);
+
+    std::vector<IPEExportFunction *> vExportFunctions;
+    std::vector<const char *> vExportNames;
+    UINT32 nExportFunctionCount = (NULL != pExportTable) ? pExportTable->GetFunctionCount() : 0;
+    for(UINT32 nExportFunctionIndex = 0; nExportFunctionIndex < nExportFunctionCount; ++nExportFunctionIndex) {
+        IPEExportFunction *pExportFunction = NULL;
+        pExportTable->GetFunctionByIndex(nExportFunctionIndex, &pExportFunction);
+        vExportFunctions.push_back(pExportFunction);
+        vExportNames.push_back((NULL != pExportFunction) ? pExportFunction->GetName() : NULL);
+    }
+
+    UINT32 nBadImportCount = 0;
+    LibPEPtr<IPEImportTable> pImportTable, pReferenceImportTable;
+    pFile->GetImportTable(&pImportTable);
+    pReferenceFile->GetImportTable(&pReferenceImportTable);
+    UINT32 nImportModuleCount = (NULL != pImportTable) ? pImportTable->GetModuleCount() : 0;
+    for(UINT32 nImportModuleIndex = 0; nImportModuleIndex < nImportModuleCount; ++nImportModuleIndex) {
+        LibPEPtr<IPEImportModule> pImportModule, pReferenceImportModule;
+        pImportTable->GetModuleByIndex(nImportModuleIndex, &pImportModule);
+        pReferenceImportTable->GetModuleByIndex(nImportModuleIndex, &pReferenceImportModule);
+        if(NULL == pImportModule || NULL == pReferenceImportModule || NULL == pImportModule->GetName()
+            || 0 != strcmp(pImportModule->GetName(), pReferenceImportModule->GetName())
+            || pImportModule->GetFunctionCount() != pReferenceImportModule->GetFunctionCount()) {
+            ++nBadImportCount;
+            continue;
+        }
+
+        for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < pImportModule->GetFunctionCount(); ++nImportFunctionIndex) {
+            LibPEPtr<IPEImportFunction> pImportFunction, pReferenceImportFunction;
+            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+            pReferenceImportModule->GetFunctionByIndex(nImportFunctionIndex, &pReferenceImportFunction);
+            if(NULL == pImportFunction && NULL == pReferenceImportFunction) {
+                continue;
+            }
+
+            if(NULL == pImportFunction || NULL == pReferenceImportFunction || pImportFunction->IsByOrdinal() != pReferenceImportFunction->IsByOrdinal()) {
+                ++nBadImportCount;
+            } else if(!pImportFunction->IsByOrdinal() && (NULL == pImportFunction->GetName() || 0 != strcmp(pImportFunction->GetName(), pReferenceImportFunction->GetName()))) {
+                ++nBadImportCount;
+            }
+        }
+    }
+
+    // A section larger than the whole cache can't be pinned, so it is only read when it fits.
+    UINT32 nBadSectionCount = 0;
+    for(UINT32 nSectionIndex = 0; nSectionIndex < pFile->GetSectionCount(); ++nSectionIndex) {
+        LibPEPtr<IPESection> pSection;
+        pFile->GetSection(nSectionIndex, &pSection);
+        if(NULL == pSection || 0 == pSection->GetSizeInFile()) {
+            continue;
+        }
+
+        const void *pSectionData = pSection->GetRawMemory();
+        if(pSection->GetSizeInFile() > 0x4000) {
+            if(NULL != pSectionData) {
+                ++nBadSectionCount;
+            }
+        } else if(NULL == pSectionData || pSection->GetFOA() + pSection->GetSizeInFile() > vFileData.size()
+            || 0 != memcmp(pSectionData, &vFileData[(size_t)pSection->GetFOA()], pSection->GetSizeInFile())) {
+            ++nBadSectionCount;
+        }
+    }
+
+    LibPEPtr<IPEExportTable> pReferenceExportTable;
+    pReferenceFile->GetExportTable(&pReferenceExportTable);
+
+    UINT32 nBadExportCount = 0;
+    for(UINT32 nExportFunctionIndex = 0; nExportFunctionIndex < nExportFunctionCount; ++nExportFunctionIndex) {
+        LibPEPtr<IPEExportFunction> pReferenceExportFunction;
+        pReferenceExportTable->GetFunctionByIndex(nExportFunctionIndex, &pReferenceExportFunction);
+
+        IPEExportFunction *pExportFunction = vExportFunctions[nExportFunctionIndex];
+        const char *pExportName = vExportNames[nExportFunctionIndex];
+        const char *pReferenceExportName = (NULL != pReferenceExportFunction) ? pReferenceExportFunction->GetName() : NULL;
+        if(NULL == pExportFunction || NULL == pReferenceExportFunction || pExportFunction->GetRVA() != pReferenceExportFunction->GetRVA()
+            || (NULL == pExportName) != (NULL == pReferenceExportName)
+            || (NULL != pExportName && 0 != strcmp(pExportName, pReferenceExportName))) {
+            ++nBadExportCount;
+        }
+
+        if(NULL != pExportFunction) {
+            pExportFunction->Release();
+        }
+    }
+
+    TestCheck(0 == nBadImportCount, "Import names read through a small block cache match the mapped file");
+    TestCheck(0 == nBadSectionCount, "Sections read through a small block cache match the file");
+    TestCheck(0 == nBadExportCount, "Export names kept by their functions survive the block evictions");
+
+    printf("\n");
+}
+
+void TestStringTerminators(const file_char_t *pFilePath)
+{
+    // With blocks this small, a lot of names are split across two or more blocks, so the terminator scan has to carry
+    // on over the block boundaries to find the same names.
+    SetPELoaderIOBlockSize(0x40, 0x40);
+
+    LibPEPtr<IPEFile> pFile;
+    ParsePEFromDiskFile(pFilePath, &pFile);
+
+    SetPELoaderIOBlockSize(0, 0);
 
-    return 0;
+    std::vector<UINT8> vFileData;
+    LibPEPtr<IPEFile> pReferenceFile;
+    if(ReadWholeFile(pFilePath, vFileData)) {
+        ParsePEFromMappedFile(&vFileData[0], vFileData.size(), &pReferenceFile);
+    }
+
+    if(NULL == pFile || NULL == pReferenceFile) {
+        TestCheck(false, "Names split across the blocks");
+        return;
+    }
+
+    UINT32 nNameCount = 0, nBadNameCount = 0;
+    LibPEPtr<IPEExportTable> pExportTable, pReferenceExportTable;
+    pFile->GetExportTable(&pExportTable);
+    pReferenceFile->GetExportTable(&pReferenceExportTable);
+    UINT32 nExportFunctionCount = (NULL != pExportTable) ? pExportTable->GetFunctionCount() : 0;
+    for(UINT32 nExportFunctionIndex = 0; nExportFunctionIndex < nExportFunctionCount; ++nExportFunctionIndex) {
+        LibPEPtr<IPEExportFunction> pExportFunction, pReferenceExportFunction;
+        pExportTable->GetFunctionByIndex(nExportFunctionIndex, &pExportFunction);
+        pReferenceExportTable->GetFunctionByIndex(nExportFunctionIndex, &pReferenceExportFunction);
+        if(NULL == pExportFunction || NULL == pReferenceExportFunction) {
+            ++nBadNameCount;
+            continue;
+        }
+
+        const char *pNames[2] = { pExportFunction->GetName(), pExportFunction->GetForwarder() };
+        const char *pReferenceNames[2] = { pReferenceExportFunction->GetName(), pReferenceExportFunction->GetForwarder() };
+        for(UINT32 nNameIndex = 0; nNameIndex < 2; ++nNameIndex) {
+            if(NULL != pReferenceNames[nNameIndex]) {
+                ++nNameCount;
+            }
+            if((NULL == pNames[nNameIndex]) != (NULL == pReferenceNames[nNameIndex])
+                || (NULL != pNames[nNameIndex] && 0 != strcmp(pNames[nNameIndex], pReferenceNames[nNameIndex]))) {
+                ++nBadNameCount;
+            }
+        }
+    }
+
+    LibPEPtr<IPEImportTable> pImportTable, pReferenceImportTable;
+    pFile->GetImportTable(&pImportTable);
+    pReferenceFile->GetImportTable(&pReferenceImportTable);
+    UINT32 nImportModuleCount = (NULL != pImportTable) ? pImportTable->GetModuleCount() : 0;
+    for(UINT32 nImportModuleIndex = 0; nImportModuleIndex < nImportModuleCount; ++nImportModuleIndex) {
+        LibPEPtr<IPEImportModule> pImportModule, pReferenceImportModule;
+        pImportTable->GetModuleByIndex(nImportModuleIndex, &pImportModule);
+        pReferenceImportTable->GetModuleByIndex(nImportModuleIndex, &pReferenceImportModule);
+        if(NULL == pImportModule || NULL == pReferenceImportModule || pImportModule->GetFunctionCount() != pReferenceImportModule->GetFunctionCount()) {
+            ++nBadNameCount;
+            continue;
+        }
+
+        ++nNameCount;
+        if(NULL == pImportModule->GetName() || 0 != strcmp(pImportModule->GetName(), pReferenceImportModule->GetName())) {
+            ++nBadNameCount;
+        }
+
+        for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < pImportModule->GetFunctionCount(); ++nImportFunctionIndex) {
+            LibPEPtr<IPEImportFunction> pImportFunction, pReferenceImportFunction;
+            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+            pReferenceImportModule->GetFunctionByIndex(nImportFunctionIndex, &pReferenceImportFunction);
+            if((NULL == pImportFunction) != (NULL == pReferenceImportFunction)) {
+                ++nBadNameCount;
+                continue;
+            }
+
+            if(NULL != pReferenceImportFunction && !pReferenceImportFunction->IsByOrdinal()) {
+                ++nNameCount;
+                if(pImportFunction->IsByOrdinal() || NULL == pImportFunction->GetName() || 0 != strcmp(pImportFunction->GetName(), pReferenceImportFunction->GetName())) {
+                    ++nBadNameCount;
+                }
+            }
+        }
+    }
+
+    printf("Names read with small blocks: %u\n", nNameCount);
+    TestCheck(0 != nNameCount && 0 == nBadNameCount, "Names split across the blocks match the mapped file");
+
+    printf("\n");
+}
+
+void TestArena(const file_char_t *pFilePath, IPEFile *pReferenceFile)
+{
+    // The elements are allocated from the arena of the file they are parsed from. An element which is still referenced
+    // keeps the arena alive, so it must stay usable after its file is released.
+    LibPEPtr<IPEFile> pFile;
+    ParsePEFromDiskFile(pFilePath, &pFile);
+    if(NULL == pFile) {
+        TestCheck(false, "Elements outlive their file");
+        return;
+    }
+
+    LibPEPtr<IPESection> pSection, pReferenceSection;
+    pFile->GetSection(0, &pSection);
+    pReferenceFile->GetSection(0, &pReferenceSection);
+
+    LibPEPtr<IPEImportModule> pImportModule, pReferenceImportModule;
+    LibPEPtr<IPEImportTable> pImportTable, pReferenceImportTable;
+    pFile->GetImportTable(&pImportTable);
+    pReferenceFile->GetImportTable(&pReferenceImportTable);
+    if(NULL != pImportTable && NULL != pReferenceImportTable) {
+        pImportTable->GetModuleByIndex(0, &pImportModule);
+        pReferenceImportTable->GetModuleByIndex(0, &pReferenceImportModule);
+    }
+
+    pImportTable.Reset();
+    pFile.Reset();
+
+    TestCheck(NULL != pSection && NULL != pReferenceSection && 0 == strcmp(pSection->GetName(), pReferenceSection->GetName()) && pSection->GetRVA() == pReferenceSection->GetRVA()
+        && NULL != pImportModule && NULL != pReferenceImportModule && 0 == strcmp(pImportModule->GetName(), pReferenceImportModule->GetName())
+        && pImportModule->GetFunctionCount() == pReferenceImportModule->GetFunctionCount(), "Elements outlive their file");
+
+    // Each file gets an arena of its own, and the memory of the elements freed with a file must not leak into the
+    // elements of the next one.
+    UINT32 nBadFileCount = 0;
+    for(UINT32 nFileIndex = 0; nFileIndex < 16; ++nFileIndex) {
+        LibPEPtr<IPEFile> pRepeatedFile;
+        ParsePEFromDiskFile(pFilePath, &pRepeatedFile);
+        if(NULL == pRepeatedFile) {
+            ++nBadFileCount;
+            continue;
+        }
+
+        LibPEPtr<IPEExportTable> pExportTable, pReferenceExportTable;
+        pRepeatedFile->GetExportTable(&pExportTable);
+        pReferenceFile->GetExportTable(&pReferenceExportTable);
+        UINT32 nExportFunctionCount = (NULL != pExportTable) ? pExportTable->GetFunctionCount() : 0;
+        if(NULL == pReferenceExportTable || nExportFunctionCount != pReferenceExportTable->GetFunctionCount()) {
+            ++nBadFileCount;
+            continue;
+        }
+
+        for(UINT32 nExportFunctionIndex = 0; nExportFunctionIndex < nExportFunctionCount; ++nExportFunctionIndex) {
+            LibPEPtr<IPEExportFunction> pExportFunction, pReferenceExportFunction;
+            pExportTable->GetFunctionByIndex(nExportFunctionIndex, &pExportFunction);
+            pReferenceExportTable->GetFunctionByIndex(nExportFunctionIndex, &pReferenceExportFunction);
+            if(NULL == pExportFunction || NULL == pReferenceExportFunction || pExportFunction->GetRVA() != pReferenceExportFunction->GetRVA()
+                || pExportFunction->GetOrdinal() != pReferenceExportFunction->GetOrdinal()) {
+                ++nBadFileCount;
+                break;
+            }
+        }
+    }
+
+    TestCheck(0 == nBadFileCount, "Files parsed again and again give the same elements");
+
+    printf("\n");
+}
+
+void DecodeRelocations(IPERelocationTable *pRelocationTable, const std::vector<UINT8> &vFileData, std::vector<PERelocationEntry> &vEntries)
+{
+    // Walk the blocks of the relocation directory straight from the file. The item after a HIGHADJ one holds its
+    // parameter, which the table reports as an IMAGE_REL_BASED_ABSOLUTE item at the page RVA.
+    PEAddress nOffset = pRelocationTable->GetFOA();
+    PEAddress nEndOffset = nOffset + pRelocationTable->GetSizeInFile();
+    while(nOffset + 8 <= nEndOffset && nEndOffset <= vFileData.size()) {
+        UINT32 nPageRVA = 0, nBlockSize = 0;
+        memcpy(&nPageRVA, &vFileData[(size_t)nOffset], sizeof(nPageRVA));
+        memcpy(&nBlockSize, &vFileData[(size_t)nOffset + 4], sizeof(nBlockSize));
+        if(nBlockSize < 8 || nOffset + nBlockSize > nEndOffset) {
+            break;
+        }
+
+        BOOL bIsParameterItem = false;
+        for(UINT32 nItemOffset = 8; nItemOffset + 2 <= nBlockSize; nItemOffset += 2) {
+            UINT16 nRawItem = 0;
+            memcpy(&nRawItem, &vFileData[(size_t)(nOffset + nItemOffset)], sizeof(nRawItem));
+
+            PERelocationEntry oEntry;
+            oEntry.nType = bIsParameterItem ? IMAGE_REL_BASED_ABSOLUTE : (nRawItem >> 12);
+            oEntry.nRVA = nPageRVA + (bIsParameterItem ? 0 : (nRawItem & 0x0FFF));
+            bIsParameterItem = (!bIsParameterItem && IMAGE_REL_BASED_HIGHADJ == oEntry.nType);
+            vEntries.push_back(oEntry);
+        }
+
+        nOffset += nBlockSize;
+    }
+}
+
+void TestRelocationDecoding(IPEFile *pFile, const std::vector<UINT8> &vFileData)
+{
+    LibPEPtr<IPERelocationTable> pRelocationTable;
+    pFile->GetRelocationTable(&pRelocationTable);
+    if(NULL == pRelocationTable) {
+        TestCheck(false, "Relocation items are decoded from the raw blocks");
+        return;
+    }
+
+    std::vector<PERelocationEntry> vExpectedEntries;
+    DecodeRelocations(pRelocationTable, vFileData, vExpectedEntries);
+
+    // The batches are of an odd size, so they start in the middle of the pages, and after the parameter items.
+    std::vector<PERelocationEntry> vEntries;
+    PERelocationEntry pBatch[7];
+    UINT32 nBatchSize = 0;
+    while(0 != (nBatchSize = pRelocationTable->GetItems((UINT32)vEntries.size(), pBatch, 7))) {
+        vEntries.insert(vEntries.end(), pBatch, pBatch + nBatchSize);
+    }
+
+    UINT32 nBadItemCount = (vEntries.size() == vExpectedEntries.size() && pRelocationTable->GetItemCount() == vExpectedEntries.size()) ? 0 : 1;
+    for(UINT32 nItemIndex = 0; 0 == nBadItemCount && nItemIndex < vEntries.size(); ++nItemIndex) {
+        if(vEntries[nItemIndex].nType != vExpectedEntries[nItemIndex].nType || vEntries[nItemIndex].nRVA != vExpectedEntries[nItemIndex].nRVA) {
+            ++nBadItemCount;
+        }
+    }
+
+    printf("Relocation items decoded: %u\n", (UINT32)vEntries.size());
+    TestCheck(!vExpectedEntries.empty() && 0 == nBadItemCount, "Relocation items are decoded from the raw blocks");
+
+    // The page objects and the item objects made on demand must agree with the table.
+    UINT32 nItemIndex = 0, nBadPageCount = 0;
+    for(UINT32 nPageIndex = 0; nPageIndex < pRelocationTable->GetPageCount(); ++nPageIndex) {
+        LibPEPtr<IPERelocationPage> pRelocationPage;
+        pRelocationTable->GetPageByIndex(nPageIndex, &pRelocationPage);
+        if(NULL == pRelocationPage) {
+            ++nBadPageCount;
+            continue;
+        }
+
+        for(UINT32 nItemIndexInPage = 0; nItemIndexInPage < pRelocationPage->GetItemCount(); ++nItemIndexInPage, ++nItemIndex) {
+            PERelocationEntry oEntry = {0};
+            LibPEPtr<IPERelocationItem> pRelocationItem;
+            pRelocationPage->GetItemByIndex(nItemIndexInPage, &pRelocationItem);
+            if(nItemIndex >= vExpectedEntries.size() || 1 != pRelocationPage->GetItems(nItemIndexInPage, &oEntry, 1)
+                || oEntry.nType != vExpectedEntries[nItemIndex].nType || oEntry.nRVA != vExpectedEntries[nItemIndex].nRVA
+                || NULL == pRelocationItem || (IMAGE_REL_BASED_ABSOLUTE != oEntry.nType && pRelocationItem->GetAddressRVA() != oEntry.nRVA)) {
+                ++nBadPageCount;
+                break;
+            }
+        }
+    }
+
+    TestCheck(0 == nBadPageCount && nItemIndex == vExpectedEntries.size(), "Relocation pages and items agree with the table");
+
+    printf("\n");
+}
+
+void TestRelocationLookup(IPEFile *pFile, const std::vector<UINT8> &vFileData)
+{
+    LibPEPtr<IPERelocationTable> pRelocationTable;
+    pFile->GetRelocationTable(&pRelocationTable);
+    if(NULL == pRelocationTable) {
+        TestCheck(false, "Relocation lookup by RVA");
+        return;
+    }
+
+    std::vector<PERelocationEntry> vDecodedEntries;
+    DecodeRelocations(pRelocationTable, vFileData, vDecodedEntries);
+
+    std::map<PEAddress, UINT16> mapExpectedEntries;
+    for(UINT32 nItemIndex = 0; nItemIndex < vDecodedEntries.size(); ++nItemIndex) {
+        if(IMAGE_REL_BASED_ABSOLUTE != vDecodedEntries[nItemIndex].nType) {
+            mapExpectedEntries[vDecodedEntries[nItemIndex].nRVA] = vDecodedEntries[nItemIndex].nType;
+        }
+    }
+
+    if(mapExpectedEntries.empty()) {
+        TestCheck(false, "Relocation lookup by RVA");
+        return;
+    }
+
+    // Every byte around the relocated slots is looked up, so the misses next to the hits are checked as well.
+    PEAddress nBeginRVA = mapExpectedEntries.begin()->first, nEndRVA = mapExpectedEntries.rbegin()->first + 1;
+    UINT32 nBadLookupCount = 0;
+    for(std::map<PEAddress, UINT16>::iterator itEntry = mapExpectedEntries.begin(); itEntry != mapExpectedEntries.end(); ++itEntry) {
+        for(PEAddress nRVA = itEntry->first - 3; nRVA <= itEntry->first + 3; ++nRVA) {
+            BOOL bIsExpected = (mapExpectedEntries.find(nRVA) != mapExpectedEntries.end());
+            LibPEPtr<IPERelocationItem> pRelocationItem;
+            pRelocationTable->GetItemByRVA(nRVA, &pRelocationItem);
+            if(pRelocationTable->IsRVANeedRelocation(nRVA) != bIsExpected || (NULL != pRelocationItem) != bIsExpected
+                || (NULL != pRelocationItem && pRelocationItem->GetAddressRVA() != nRVA)) {
+                ++nBadLookupCount;
+            }
+        }
+    }
+
+    TestCheck(0 == nBadLookupCount && !pRelocationTable->IsRVANeedRelocation(nEndRVA + 0x10000), "Relocation lookup by RVA matches the raw blocks");
+
+    // The ranges are cut at odd places, so most of them start and end in the middle of a page.
+    UINT32 nBadRangeCount = 0;
+    PEAddress nRangeSize = (nEndRVA - nBeginRVA) / 13 + 1;
+    for(PEAddress nRangeBeginRVA = nBeginRVA - 1; nRangeBeginRVA < nEndRVA; nRangeBeginRVA += nRangeSize) {
+        PEAddress nRangeEndRVA = nRangeBeginRVA + nRangeSize;
+        std::vector<PERelocationEntry> vExpectedEntries;
+        for(std::map<PEAddress, UINT16>::iterator itEntry = mapExpectedEntries.lower_bound(nRangeBeginRVA); itEntry != mapExpectedEntries.end() && itEntry->first < nRangeEndRVA; ++itEntry) {
+            PERelocationEntry oEntry;
+            oEntry.nType = itEntry->second;
+            oEntry.nRVA = itEntry->first;
+            vExpectedEntries.push_back(oEntry);
+        }
+
+        UINT32 nEntryCount = pRelocationTable->GetRelocationsInRange(nRangeBeginRVA, nRangeEndRVA, NULL, 0);
+        std::vector<PERelocationEntry> vEntries(nEntryCount + 1);
+        UINT32 nFilledCount = pRelocationTable->GetRelocationsInRange(nRangeBeginRVA, nRangeEndRVA, &vEntries[0], (UINT32)vEntries.size());
+        if(nEntryCount != vExpectedEntries.size() || nFilledCount != nEntryCount) {
+            ++nBadRangeCount;
+            continue;
+        }
+
+        for(UINT32 nEntryIndex = 0; nEntryIndex < nEntryCount; ++nEntryIndex) {
+            if(vEntries[nEntryIndex].nRVA != vExpectedEntries[nEntryIndex].nRVA || vEntries[nEntryIndex].nType != vExpectedEntries[nEntryIndex].nType) {
+                ++nBadRangeCount;
+                break;
+            }
+        }
+    }
+
+    TestCheck(0 == nBadRangeCount, "GetRelocationsInRange matches the raw blocks");
+
+    printf("\n");
+}
+
+void TestRebase(IPEFile *pFile)
+{
+    UINT32 nImageSize = pFile->GetImageSize();
+    PEAddress nImageBase = pFile->GetImageBase();
+    PEAddress nNewImageBase = nImageBase + 0x10000000;
+
+    std::vector<UINT8> vImage(nImageSize), vRebasedImage(nImageSize), vRestoredImage(nImageSize);
+    TestCheck(SUCCEEDED(pFile->Rebase(nImageBase, &vImage[0], nImageSize)), "Rebase to the preferred base");
+    TestCheck(SUCCEEDED(pFile->Rebase(nNewImageBase, &vRebasedImage[0], nImageSize)), "Rebase to a new base");
+
+    // Every pointer-sized fixup must have moved by the delta, with the same layout as the image at its preferred base.
+    LibPEPtr<IPERelocationTable> pRelocationTable;
+    pFile->GetRelocationTable(&pRelocationTable);
+
+    UINT32 nFixupCount = 0, nBadFixupCount = 0;
+    std::vector<PERelocationEntry> vEntries(pRelocationTable->GetItemCount() + 1);
+    UINT32 nEntryCount = pRelocationTable->GetItems(0, &vEntries[0], (UINT32)vEntries.size());
+    for(UINT32 nEntryIndex = 0; nEntryIndex < nEntryCount; ++nEntryIndex) {
+        PEAddress nRVA = vEntries[nEntryIndex].nRVA;
+        if(IMAGE_REL_BASED_HIGHLOW == vEntries[nEntryIndex].nType && nRVA + sizeof(UINT32) <= nImageSize) {
+            UINT32 nValue = 0, nRebasedValue = 0;
+            memcpy(&nValue, &vImage[(size_t)nRVA], sizeof(UINT32));
+            memcpy(&nRebasedValue, &vRebasedImage[(size_t)nRVA], sizeof(UINT32));
+            nBadFixupCount += (nRebasedValue - nValue != (UINT32)(nNewImageBase - nImageBase)) ? 1 : 0;
+            ++nFixupCount;
+        } else if(IMAGE_REL_BASED_DIR64 == vEntries[nEntryIndex].nType && nRVA + sizeof(UINT64) <= nImageSize) {
+            UINT64 nValue = 0, nRebasedValue = 0;
+            memcpy(&nValue, &vImage[(size_t)nRVA], sizeof(UINT64));
+            memcpy(&nRebasedValue, &vRebasedImage[(size_t)nRVA], sizeof(UINT64));
+            nBadFixupCount += (nRebasedValue - nValue != (UINT64)(nNewImageBase - nImageBase)) ? 1 : 0;
+            ++nFixupCount;
+        }
+    }
+
+    printf("Rebase: Fixups = %u, Bad fixups = %u\n", nFixupCount, nBadFixupCount);
+    TestCheck(0 != nFixupCount && 0 == nBadFixupCount, "Rebase applies every fixup by the delta");
+
+    // Rebasing the rebased image back to the preferred base must restore it byte for byte.
+    LibPEPtr<IPEFile> pRebasedFile;
+    ParsePEFromImageBuffer(&vRebasedImage[0], nImageSize, &pRebasedFile);
+    TestCheck(NULL != pRebasedFile && SUCCEEDED(pRebasedFile->Rebase(nImageBase, &vRestoredImage[0], nImageSize))
+        && vImage == vRestoredImage, "Rebase round trip restores the image");
+
+    // The image can't be laid out over the buffer it is parsed from, and the buffer must be left as it is.
+    std::vector<UINT8> vRebasedImageCopy(vRebasedImage);
+    TestCheck(NULL != pRebasedFile && E_INVALIDARG == pRebasedFile->Rebase(nNewImageBase, &vRebasedImage[0], nImageSize)
+        && vRebasedImage == vRebasedImageCopy, "Rebase rejects the buffer the file is parsed from");
+
+    printf("\n");
 }
+
+void TestExportLookup(const file_char_t *pFilePath)
+{
+    // The lookups go through the binary search over the name table first, then through the hash index of the names.
+    const UINT32 pThresholds[2] = { 0xFFFFFFFF, 1 };
+    const char *pCheckNames[2] = { "GetFunctionByName finds every named export with binary search", "GetFunctionByName finds every named export with the hash index" };
+    for(UINT32 nThresholdIndex = 0; nThresholdIndex < 2; ++nThresholdIndex) {
+        SetPEExportNameIndexThreshold(pThresholds[nThresholdIndex]);
+
+        LibPEPtr<IPEFile> pFile;
+        LibPEPtr<IPEExportTable> pExportTable;
+        ParsePEFromDiskFile(pFilePath, &pFile);
+        if(NULL != pFile) {
+            pFile->GetExportTable(&pExportTable);
+        }
+
+        UINT32 nNameCount = 0, nBadNameCount = 0;
+        UINT32 nExportFunctionCount = (NULL != pExportTable) ? pExportTable->GetFunctionCount() : 0;
+        for(UINT32 nExportFunctionIndex = 0; nExportFunctionIndex < nExportFunctionCount; ++nExportFunctionIndex) {
+            LibPEPtr<IPEExportFunction> pExportFunction;
+            if(FAILED(pExportTable->GetFunctionByIndex(nExportFunctionIndex, &pExportFunction)) || NULL == pExportFunction || NULL == pExportFunction->GetName()) {
+                continue;
+            }
+
+            LibPEPtr<IPEExportFunction> pFunctionByName;
+            pExportTable->GetFunctionByName(pExportFunction->GetName(), &pFunctionByName);
+            nBadNameCount += (NULL == pFunctionByName || pFunctionByName->GetRVA() != pExportFunction->GetRVA()) ? 1 : 0;
+
+            // Export names are case sensitive, and a prefix of a name is not a match, so only an export with exactly
+            // the same name may be found for them.
+            std::string strName = pExportFunction->GetName();
+            std::string pProbeNames[2] = { ToLowerCase(strName.c_str()), strName.substr(0, strName.size() - 1) };
+            for(UINT32 nProbeIndex = 0; nProbeIndex < 2; ++nProbeIndex) {
+                LibPEPtr<IPEExportFunction> pFunctionByProbe;
+                if(pProbeNames[nProbeIndex] != strName && SUCCEEDED(pExportTable->GetFunctionByName(pProbeNames[nProbeIndex].c_str(), &pFunctionByProbe))
+                    && (NULL == pFunctionByProbe->GetName() || 0 != strcmp(pFunctionByProbe->GetName(), pProbeNames[nProbeIndex].c_str()))) {
+                    ++nBadNameCount;
+                }
+            }
+
+            ++nNameCount;
+        }
+
+        LibPEPtr<IPEExportFunction> pMissingFunction;
+        if(NULL == pExportTable || SUCCEEDED(pExportTable->GetFunctionByName("NoSuchExportedFunction", &pMissingFunction))) {
+            ++nBadNameCount;
+        }
+
+        printf("Export Lookup: Names = %u, Bad names = %u\n", nNameCount, nBadNameCount);
+        TestCheck(0 != nNameCount && 0 == nBadNameCount, pCheckNames[nThresholdIndex]);
+    }
+
+    SetPEExportNameIndexThreshold(0);
+
+    printf("\n");
+}
+
+std::string ReadFileString(IPEFile *pFile, const std::vector<UINT8> &vFileData, PEAddress nRVA)
+{
+    std::string strString;
+    for(PEAddress nFOA = pFile->GetFOAFromRVA(nRVA); 0 != nFOA && nFOA < vFileData.size() && 0 != vFileData[(size_t)nFOA]; ++nFOA) {
+        strString += (char)vFileData[(size_t)nFOA];
+    }
+    return strString;
+}
+
+UINT32 ReadFileValue(IPEFile *pFile, const std::vector<UINT8> &vFileData, PEAddress nRVA, UINT32 nSize)
+{
+    UINT32 nValue = 0;
+    PEAddress nFOA = pFile->GetFOAFromRVA(nRVA);
+    if(0 != nFOA && nFOA + nSize <= vFileData.size()) {
+        memcpy(&nValue, &vFileData[(size_t)nFOA], nSize);
+    }
+    return nValue;
+}
+
+void TestExportOrdinals(IPEFile *pFile, const std::vector<UINT8> &vFileData)
+{
+    LibPEPtr<IPEExportTable> pExportTable;
+    pFile->GetExportTable(&pExportTable);
+    if(NULL == pExportTable) {
+        TestCheck(false, "Export ordinals, names and forwarders match the raw export tables");
+        return;
+    }
+
+    // Map each function back to its first name from the raw name and name ordinal tables.
+    std::map<UINT32, std::string> mapExpectedNames;
+    for(UINT32 nNameIndex = 0; nNameIndex < pExportTable->GetFieldNumberOfNames(); ++nNameIndex) {
+        UINT32 nNameRVA = ReadFileValue(pFile, vFileData, pExportTable->GetFieldAddressOfNames() + nNameIndex * sizeof(UINT32), sizeof(UINT32));
+        UINT32 nFunctionIndex = ReadFileValue(pFile, vFileData, pExportTable->GetFieldAddressOfNameOrdinals() + nNameIndex * sizeof(UINT16), sizeof(UINT16));
+        if(mapExpectedNames.find(nFunctionIndex) == mapExpectedNames.end()) {
+            mapExpectedNames[nFunctionIndex] = ReadFileString(pFile, vFileData, nNameRVA);
+        }
+    }
+
+    // A function whose RVA points inside the export directory is forwarded, and the RVA is the one of its forwarder.
+    UINT32 nForwarderCount = 0, nBadFunctionCount = 0;
+    UINT32 nExportFunctionCount = pExportTable->GetFunctionCount();
+    for(UINT32 nFunctionIndex = 0; nFunctionIndex < nExportFunctionCount; ++nFunctionIndex) {
+        UINT32 nFunctionRVA = ReadFileValue(pFile, vFileData, pExportTable->GetFieldAddressOfFunctions() + nFunctionIndex * sizeof(UINT32), sizeof(UINT32));
+        BOOL bIsForwarded = (nFunctionRVA >= pExportTable->GetRVA() && nFunctionRVA < pExportTable->GetRVA() + pExportTable->GetSizeInMemory());
+        nForwarderCount += bIsForwarded ? 1 : 0;
+
+        // A slot with no RVA is an unused ordinal, so there is no function to find.
+        LibPEPtr<IPEExportFunction> pExportFunction;
+        pExportTable->GetFunctionByOrdinal(pExportTable->GetFieldBase() + nFunctionIndex, &pExportFunction);
+        if(0 == nFunctionRVA) {
+            nBadFunctionCount += (NULL != pExportFunction) ? 1 : 0;
+            continue;
+        }
+
+        if(NULL == pExportFunction || pExportFunction->GetOrdinal() != pExportTable->GetFieldBase() + nFunctionIndex) {
+            ++nBadFunctionCount;
+            continue;
+        }
+
+        std::map<UINT32, std::string>::iterator itName = mapExpectedNames.find(nFunctionIndex);
+        const char *pName = pExportFunction->GetName();
+        if((itName == mapExpectedNames.end()) != (NULL == pName) || (NULL != pName && itName->second != pName)) {
+            ++nBadFunctionCount;
+        }
+
+        const char *pForwarder = pExportFunction->GetForwarder();
+        if(pExportFunction->IsForwarded() != bIsForwarded || (NULL != pForwarder) != bIsForwarded
+            || (bIsForwarded && ReadFileString(pFile, vFileData, nFunctionRVA) != pForwarder)) {
+            ++nBadFunctionCount;
+        }
+    }
+
+    LibPEPtr<IPEExportFunction> pMissingFunction;
+    if(SUCCEEDED(pExportTable->GetFunctionByOrdinal(pExportTable->GetFieldBase() + nExportFunctionCount, &pMissingFunction))
+        || (0 != pExportTable->GetFieldBase() && SUCCEEDED(pExportTable->GetFunctionByOrdinal(pExportTable->GetFieldBase() - 1, &pMissingFunction)))) {
+        ++nBadFunctionCount;
+    }
+
+    printf("Export Ordinals: Functions = %u, Forwarders = %u, Bad functions = %u\n", nExportFunctionCount, nForwarderCount, nBadFunctionCount);
+    TestCheck(0 != nExportFunctionCount && 0 == nBadFunctionCount, "Export ordinals, names and forwarders match the raw export tables");
+
+    printf("\n");
+}
+
+void TestImportLookup(IPEFile *pFile)
+{
+    LibPEPtr<IPEImportTable> pImportTable;
+    pFile->GetImportTable(&pImportTable);
+    if(NULL == pImportTable) {
+        TestCheck(false, "Import lookups by name find every named import");
+        return;
+    }
+
+    // Module names are looked up in lower case, since they are case insensitive, but function names must match exactly.
+    UINT32 nNameCount = 0, nBadNameCount = 0;
+    for(UINT32 nImportModuleIndex = 0; nImportModuleIndex < pImportTable->GetModuleCount(); ++nImportModuleIndex) {
+        LibPEPtr<IPEImportModule> pImportModule, pModuleByName;
+        pImportTable->GetModuleByIndex(nImportModuleIndex, &pImportModule);
+        if(NULL == pImportModule || NULL == pImportModule->GetName()) {
+            ++nBadNameCount;
+            continue;
+        }
+
+        std::string strModuleName = ToLowerCase(pImportModule->GetName());
+        pImportTable->GetModuleByName(strModuleName.c_str(), &pModuleByName);
+        if(NULL == pModuleByName || ToLowerCase(pModuleByName->GetName()) != strModuleName) {
+            ++nBadNameCount;
+        }
+
+        for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < pImportModule->GetFunctionCount(); ++nImportFunctionIndex) {
+            LibPEPtr<IPEImportFunction> pImportFunction;
+            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+            if(NULL == pImportFunction || pImportFunction->IsByOrdinal() || NULL == pImportFunction->GetName()) {
+                continue;
+            }
+
+            LibPEPtr<IPEImportFunction> pFunctionInModule, pFunctionInTable;
+            pImportModule->GetFunctionByName(pImportFunction->GetName(), &pFunctionInModule);
+            pImportTable->GetFunctionByName(strModuleName.c_str(), pImportFunction->GetName(), &pFunctionInTable);
+            if(NULL == pFunctionInModule || NULL == pFunctionInModule->GetName() || 0 != strcmp(pFunctionInModule->GetName(), pImportFunction->GetName())
+                || NULL == pFunctionInTable || NULL == pFunctionInTable->GetName() || 0 != strcmp(pFunctionInTable->GetName(), pImportFunction->GetName())) {
+                ++nBadNameCount;
+            }
+            ++nNameCount;
+        }
+
+        LibPEPtr<IPEImportFunction> pMissingFunction;
+        if(SUCCEEDED(pImportModule->GetFunctionByName("NoSuchImportedFunction", &pMissingFunction))) {
+            ++nBadNameCount;
+        }
+    }
+
+    LibPEPtr<IPEImportModule> pMissingModule;
+    if(SUCCEEDED(pImportTable->GetModuleByName("nosuchmodule.dll", &pMissingModule))) {
+        ++nBadNameCount;
+    }
+
+    printf("Import Lookup: Names = %u, Bad names = %u\n", nNameCount, nBadNameCount);
+    TestCheck(0 != nNameCount && 0 == nBadNameCount, "Import lookups by name find every named import");
+
+    printf("\n");
+}
+
+void TestImportThunks(IPEFile *pFile, const std::vector<UINT8> &vFileData)
+{
+    LibPEPtr<IPEImportTable> pImportTable;
+    pFile->GetImportTable(&pImportTable);
+    if(NULL == pImportTable) {
+        TestCheck(false, "Import functions match the raw thunks");
+        return;
+    }
+
+    // Decode the lookup table of each module from the file. A thunk with the ordinal flag, the top bit of a 32-bit or a
+    // 64-bit thunk, holds the ordinal in its low 16 bits. The others hold the RVA of the hint and the name.
+    UINT32 nThunkSize = pFile->Is32Bit() ? sizeof(UINT32) : sizeof(UINT64);
+    UINT32 nOrdinalCount = 0, nNameCount = 0, nBadThunkCount = 0;
+    for(UINT32 nImportModuleIndex = 0; nImportModuleIndex < pImportTable->GetModuleCount(); ++nImportModuleIndex) {
+        LibPEPtr<IPEImportModule> pImportModule;
+        pImportTable->GetModuleByIndex(nImportModuleIndex, &pImportModule);
+        if(NULL == pImportModule || (0 == pImportModule->GetFieldOriginalFirstThunk() && pImportModule->IsBound())) {
+            continue;
+        }
+
+        PEAddress nThunkRVA = (0 != pImportModule->GetFieldOriginalFirstThunk()) ? pImportModule->GetFieldOriginalFirstThunk() : pImportModule->GetFieldFirstThunk();
+        for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < pImportModule->GetFunctionCount(); ++nImportFunctionIndex, nThunkRVA += nThunkSize) {
+            UINT64 nThunk = 0;
+            PEAddress nThunkFOA = pFile->GetFOAFromRVA(nThunkRVA);
+            if(0 != nThunkFOA && nThunkFOA + nThunkSize <= vFileData.size()) {
+                memcpy(&nThunk, &vFileData[(size_t)nThunkFOA], nThunkSize);
+            }
+
+            BOOL bIsByOrdinal = (0 != (nThunk >> (nThunkSize * 8 - 1)));
+            LibPEPtr<IPEImportFunction> pImportFunction;
+            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+            if(0 == nThunk || NULL == pImportFunction || pImportFunction->IsByOrdinal() != bIsByOrdinal) {
+                ++nBadThunkCount;
+            } else if(bIsByOrdinal) {
+                nBadThunkCount += (pImportFunction->GetOrdinal() != (UINT16)nThunk || NULL != pImportFunction->GetName() || 0 != pImportFunction->GetFieldHint()) ? 1 : 0;
+                ++nOrdinalCount;
+            } else {
+                UINT16 nHint = (UINT16)ReadFileValue(pFile, vFileData, (PEAddress)nThunk, sizeof(UINT16));
+                std::string strName = ReadFileString(pFile, vFileData, (PEAddress)nThunk + sizeof(UINT16));
+                nBadThunkCount += (NULL == pImportFunction->GetName() || strName != pImportFunction->GetName() || nHint != pImportFunction->GetFieldHint()) ? 1 : 0;
+                ++nNameCount;
+            }
+        }
+    }
+
+    printf("Import Thunks: Names = %u, Ordinals = %u, Bad thunks = %u\n", nNameCount, nOrdinalCount, nBadThunkCount);
+    TestCheck(0 != nNameCount && 0 == nBadThunkCount, "Import functions match the raw thunks");
+
+    printf("\n");
+}
+
+void TestImportHash(IPEFile *pFile)
+{
+    LibPEPtr<IPEImportTable> pImportTable;
+    pFile->GetImportTable(&pImportTable);
+
+    // The imphash is the MD5 of the "module.function" entries joined by commas. Here the entries are built from the
+    // import objects, so the streaming pass of ComputeImportHash is checked against an independent implementation.
+    std::string strEntries;
+    UINT32 nImportModuleCount = pImportTable->GetModuleCount();
+    for(UINT32 nImportModuleIndex = 0; nImportModuleIndex < nImportModuleCount; ++nImportModuleIndex) {
+        LibPEPtr<IPEImportModule> pImportModule;
+        pImportTable->GetModuleByIndex(nImportModuleIndex, &pImportModule);
+
+        // The thunks of a bound module without its lookup table hold addresses, so they have no names to hash.
+        if(0 == pImportModule->GetFieldOriginalFirstThunk() && pImportModule->IsBound()) {
+            continue;
+        }
+
+        std::string strModuleName = ToLowerCase(pImportModule->GetName());
+        size_t nExtensionPos = strModuleName.size() - 4;
+        if(strModuleName.size() >= 4 && strModuleName[nExtensionPos] == '.') {
+            std::string strExtension = strModuleName.substr(nExtensionPos + 1);
+            if(strExtension == "dll" || strExtension == "ocx" || strExtension == "sys") {
+                strModuleName.resize(nExtensionPos);
+            }
+        }
+
+        for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < pImportModule->GetFunctionCount(); ++nImportFunctionIndex) {
+            LibPEPtr<IPEImportFunction> pImportFunction;
+            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+
+            std::string strFunctionName;
+            if(pImportFunction->IsByOrdinal()) {
+                char pOrdinalName[16];
+                sprintf(pOrdinalName, "ord%u", pImportFunction->GetOrdinal());
+                strFunctionName = pOrdinalName;
+            } else {
+                strFunctionName = ToLowerCase(pImportFunction->GetName());
+            }
+
+            if(!strEntries.empty()) {
+                strEntries += ",";
+            }
+            strEntries += strModuleName + "." + strFunctionName;
+        }
+    }
+
+    UINT8 pExpectedHash[16] = {0}, pHash[16] = {0};
+    BOOL bHasExpectedHash = ComputeMD5(strEntries.c_str(), (UINT32)strEntries.size(), pExpectedHash);
+    HRESULT hr = pImportTable->ComputeImportHash(PE_IMPORT_HASH_MD5, pHash, sizeof(pHash));
+
+    printf("Import Hash: ");
+    for(UINT32 nByteIndex = 0; nByteIndex < sizeof(pHash); ++nByteIndex) {
+        printf("%02x", pHash[nByteIndex]);
+    }
+    printf("\n");
+
+    TestCheck(bHasExpectedHash && SUCCEEDED(hr) && 0 == memcmp(pHash, pExpectedHash, sizeof(pHash)), "ComputeImportHash matches the imphash of the import objects");
+
+    UINT64 nSetHash = 0, nSetHashAgain = 0;
+    TestCheck(SUCCEEDED(pImportTable->ComputeImportHash(PE_IMPORT_HASH_FNV64, (UINT8 *)&nSetHash, sizeof(nSetHash)))
+        && SUCCEEDED(pImportTable->ComputeImportHash(PE_IMPORT_HASH_FNV64, (UINT8 *)&nSetHashAgain, sizeof(nSetHashAgain)))
+        && nSetHash == nSetHashAgain, "ComputeImportHash FNV64 is stable");
+
+    printf("\n");
+}
+
+void TestMaterializedImports(IPEFile *pFile)
+{
+    LibPEPtr<IPEImportTable> pImportTable;
+    pFile->GetImportTable(&pImportTable);
+
+    PEMaterializedImportTable oTable = {0};
+    if(NULL == pImportTable || FAILED(pImportTable->Materialize(&oTable)) || oTable.nModuleCount != pImportTable->GetModuleCount()) {
+        TestCheck(false, "Materialized imports match the import objects");
+        return;
+    }
+
+    // The functions of a bound module without its lookup table only have their IAT slots.
+    UINT32 nThunkSize = pFile->Is32Bit() ? sizeof(UINT32) : sizeof(UINT64);
+    UINT32 nBoundFunctionCount = 0, nBadEntryCount = 0;
+    for(UINT32 nImportModuleIndex = 0; nImportModuleIndex < oTable.nModuleCount; ++nImportModuleIndex) {
+        const PEImportModuleEntry &oModule = oTable.pModules[nImportModuleIndex];
+        LibPEPtr<IPEImportModule> pImportModule;
+        pImportTable->GetModuleByIndex(nImportModuleIndex, &pImportModule);
+        if(NULL == pImportModule || NULL == pImportModule->GetName() || oModule.nNameOffset >= oTable.nStringPoolSize
+            || 0 != strcmp(&oTable.pStringPool[oModule.nNameOffset], pImportModule->GetName())
+            || oModule.nFunctionCount != pImportModule->GetFunctionCount() || oModule.nFirstFunctionIndex + oModule.nFunctionCount > oTable.nFunctionCount) {
+            ++nBadEntryCount;
+            continue;
+        }
+
+        BOOL bHasAddressThunks = (0 == pImportModule->GetFieldOriginalFirstThunk() && pImportModule->IsBound());
+        for(UINT32 nImportFunctionIndex = 0; nImportFunctionIndex < oModule.nFunctionCount; ++nImportFunctionIndex) {
+            const PEImportFunctionEntry &oFunction = oTable.pFunctions[oModule.nFirstFunctionIndex + nImportFunctionIndex];
+            if(oFunction.nThunkRVA != pImportModule->GetFieldFirstThunk() + nImportFunctionIndex * nThunkSize) {
+                ++nBadEntryCount;
+                continue;
+            }
+
+            if(bHasAddressThunks) {
+                nBadEntryCount += (PE_IMPORT_NO_NAME != oFunction.nNameOffset || 0 != oFunction.nOrdinal) ? 1 : 0;
+                ++nBoundFunctionCount;
+                continue;
+            }
+
+            LibPEPtr<IPEImportFunction> pImportFunction;
+            pImportModule->GetFunctionByIndex(nImportFunctionIndex, &pImportFunction);
+            if(NULL == pImportFunction) {
+                ++nBadEntryCount;
+            } else if(pImportFunction->IsByOrdinal()) {
+                nBadEntryCount += (PE_IMPORT_NO_NAME != oFunction.nNameOffset || pImportFunction->GetOrdinal() != oFunction.nOrdinal) ? 1 : 0;
+            } else {
+                nBadEntryCount += (oFunction.nNameOffset >= oTable.nStringPoolSize || NULL == pImportFunction->GetName()
+                    || 0 != strcmp(&oTable.pStringPool[oFunction.nNameOffset], pImportFunction->GetName())) ? 1 : 0;
+            }
+        }
+    }
+
+    printf("Materialized Imports: Modules = %u, Functions = %u, Bound functions = %u, Bad entries = %u\n", oTable.nModuleCount, oTable.nFunctionCount, nBoundFunctionCount, nBadEntryCount);
+    TestCheck(0 != oTable.nFunctionCount && 0 == nBadEntryCount, "Materialized imports match the import objects");
+
+    printf("\n");
+}
+
+void TestBoundAndDelayImports(IPEFile *pFile, const std::vector<UINT8> &vFileData)
+{
+    // The bound import descriptors are followed by their forwarder refs, which have the same layout, and the names are
+    // at offsets from the start of the table.
+    UINT32 nBoundModuleCount = 0, nDelayModuleCount = 0, nDelayFunctionCount = 0, nBadEntryCount = 0;
+    LibPEPtr<IPEBoundImportTable> pBoundImportTable;
+    pFile->GetBoundImportTable(&pBoundImportTable);
+    if(NULL != pBoundImportTable) {
+        PEAddress nDescRVA = pBoundImportTable->GetRVA();
+        for(UINT32 nModuleIndex = 0; nModuleIndex < pBoundImportTable->GetModuleCount(); ++nModuleIndex) {
+            UINT32 nTimeDateStamp = ReadFileValue(pFile, vFileData, nDescRVA, sizeof(UINT32));
+            std::string strName = ReadFileString(pFile, vFileData, pBoundImportTable->GetRVA() + ReadFileValue(pFile, vFileData, nDescRVA + 4, sizeof(UINT16)));
+            UINT32 nForwarderRefCount = ReadFileValue(pFile, vFileData, nDescRVA + 6, sizeof(UINT16));
+
+            LibPEPtr<IPEBoundImportModule> pBoundImportModule, pModuleByName;
+            pBoundImportTable->GetModuleByIndex(nModuleIndex, &pBoundImportModule);
+            pBoundImportTable->GetModuleByName(ToLowerCase(strName.c_str()).c_str(), &pModuleByName);
+            if(NULL == pBoundImportModule || NULL == pBoundImportModule->GetName() || strName != pBoundImportModule->GetName()
+                || pBoundImportModule->GetFieldTimeDateStamp() != nTimeDateStamp || pBoundImportModule->GetForwarderRefCount() != nForwarderRefCount
+                || NULL == pModuleByName || 0 == (pFile->GetModuleImportKinds(strName.c_str()) & PE_IMPORT_KIND_BOUND)) {
+                ++nBadEntryCount;
+                nDescRVA += (1 + nForwarderRefCount) * 8;
+                continue;
+            }
+
+            for(UINT32 nRefIndex = 0; nRefIndex < nForwarderRefCount; ++nRefIndex) {
+                PEAddress nRefRVA = nDescRVA + (1 + nRefIndex) * 8;
+                const char *pRefName = pBoundImportModule->GetForwarderRefName(nRefIndex);
+                if(NULL == pRefName || ReadFileString(pFile, vFileData, pBoundImportTable->GetRVA() + ReadFileValue(pFile, vFileData, nRefRVA + 4, sizeof(UINT16))) != pRefName
+                    || pBoundImportModule->GetForwarderRefTimeDateStamp(nRefIndex) != ReadFileValue(pFile, vFileData, nRefRVA, sizeof(UINT32))) {
+                    ++nBadEntryCount;
+                }
+            }
+
+            nDescRVA += (1 + nForwarderRefCount) * 8;
+            ++nBoundModuleCount;
+        }
+    }
+
+    // Only the delay import descriptors with the RVA based attribute have their name tables decoded. The names must be
+    // found through the module, the table and the file.
+    UINT32 nThunkSize = pFile->Is32Bit() ? sizeof(UINT32) : sizeof(UINT64);
+    LibPEPtr<IPEDelayImportTable> pDelayImportTable;
+    pFile->GetDelayImportTable(&pDelayImportTable);
+    if(NULL != pDelayImportTable) {
+        for(UINT32 nModuleIndex = 0; nModuleIndex < pDelayImportTable->GetModuleCount(); ++nModuleIndex) {
+            LibPEPtr<IPEDelayImportModule> pDelayImportModule;
+            pDelayImportTable->GetModuleByIndex(nModuleIndex, &pDelayImportModule);
+            UINT32 nAttributes = ReadFileValue(pFile, vFileData, (NULL != pDelayImportModule) ? pDelayImportModule->GetRVA() : 0, sizeof(UINT32));
+            if(NULL == pDelayImportModule || pDelayImportModule->IsRVABased() != (0 != (nAttributes & PE_DELAY_IMPORT_ATTRIBUTE_RVA_BASED))) {
+                ++nBadEntryCount;
+                continue;
+            }
+
+            ++nDelayModuleCount;
+            if(!pDelayImportModule->IsRVABased()) {
+                continue;
+            }
+
+            const char *pModuleName = pDelayImportModule->GetName();
+            if(NULL == pModuleName || ReadFileString(pFile, vFileData, pDelayImportModule->GetFieldDllNameRVA()) != pModuleName
+                || 0 == (pFile->GetModuleImportKinds(pModuleName) & PE_IMPORT_KIND_DELAY)) {
+                ++nBadEntryCount;
+                continue;
+            }
+
+            UINT32 nFunctionIndex = 0;
+            for(PEAddress nThunkRVA = pDelayImportModule->GetFieldImportNameTableRVA(); ; nThunkRVA += nThunkSize, ++nFunctionIndex) {
+                UINT64 nThunk = 0;
+                PEAddress nThunkFOA = pFile->GetFOAFromRVA(nThunkRVA);
+                if(0 != nThunkFOA && nThunkFOA + nThunkSize <= vFileData.size()) {
+                    memcpy(&nThunk, &vFileData[(size_t)nThunkFOA], nThunkSize);
+                }
+
+                if(0 == nThunk) {
+                    break;
+                }
+
+                BOOL bIsByOrdinal = (0 != (nThunk >> (nThunkSize * 8 - 1)));
+                LibPEPtr<IPEImportFunction> pImportFunction;
+                pDelayImportModule->GetFunctionByIndex(nFunctionIndex, &pImportFunction);
+                if(NULL == pImportFunction || pImportFunction->IsByOrdinal() != bIsByOrdinal) {
+                    ++nBadEntryCount;
+                    continue;
+                }
+
+                ++nDelayFunctionCount;
+                if(bIsByOrdinal) {
+                    nBadEntryCount += (pImportFunction->GetOrdinal() != (UINT16)nThunk) ? 1 : 0;
+                    continue;
+                }
+
+                std::string strName = ReadFileString(pFile, vFileData, (PEAddress)nThunk + sizeof(UINT16));
+                LibPEPtr<IPEImportFunction> pFunctionInModule, pFunctionInTable, pFunctionInFile;
+                pDelayImportModule->GetFunctionByName(strName.c_str(), &pFunctionInModule);
+                pDelayImportTable->GetFunctionByName(pModuleName, strName.c_str(), &pFunctionInTable);
+                pFile->FindImportedFunction(pModuleName, strName.c_str(), &pFunctionInFile);
+                if(NULL == pImportFunction->GetName() || strName != pImportFunction->GetName()
+                    || pImportFunction->GetFieldHint() != (UINT16)ReadFileValue(pFile, vFileData, (PEAddress)nThunk, sizeof(UINT16))
+                    || NULL == pFunctionInModule || NULL == pFunctionInTable || NULL == pFunctionInFile) {
+                    ++nBadEntryCount;
+                }
+            }
+
+            nBadEntryCount += (pDelayImportModule->GetFunctionCount() != nFunctionIndex) ? 1 : 0;
+        }
+    }
+
+    printf("Bound and Delay Imports: Bound modules = %u, Delay modules = %u, Delay functions = %u, Bad entries = %u\n", nBoundModuleCount, nDelayModuleCount, nDelayFunctionCount, nBadEntryCount);
+    TestCheck(0 != nBoundModuleCount + nDelayModuleCount && 0 == nBadEntryCount, "Bound and delay imports match the raw descriptors");
+
+    printf("\n");
+}
+
+void TestResolveIATSlots(IPEFile *pFile)
+{
+    LibPEPtr<IPEImportTable> pImportTable;
+    pFile->GetImportTable(&pImportTable);
+
+    LibPEPtr<IPEImportAddressTable> pImportAddressTable;
+    pFile->GetImportAddressTable(&pImportAddressTable);
+
+    PEMaterializedImportTable oMaterializedTable;
+    if(NULL == pImportTable || NULL == pImportAddressTable || FAILED(pImportTable->Materialize(&oMaterializedTable))) {
+        TestCheck(false, "ResolveIATSlots resolves every IAT slot");
+        return;
+    }
+
+    // All the IAT slots and one RVA out of the IAT are resolved in one call, and each slot must be the thunk of the
+    // function it is resolved to.
+    std::vector<PEAddress> vSlotRVAs;
+    UINT32 nImportAddressBlockCount = pImportAddressTable->GetBlockCount();
+    for(UINT32 nBlockIndex = 0; nBlockIndex < nImportAddressBlockCount; ++nBlockIndex) {
+        LibPEPtr<IPEImportAddressBlock> pImportAddressBlock;
+        pImportAddressTable->GetBlockByIndex(nBlockIndex, &pImportAddressBlock);
+        if(NULL == pImportAddressBlock) {
+            continue;
+        }
+
+        UINT32 nImportAddressItemCount = pImportAddressBlock->GetItemCount();
+        for(UINT32 nItemIndex = 0; nItemIndex < nImportAddressItemCount; ++nItemIndex) {
+            LibPEPtr<IPEImportAddressItem> pImportAddressItem;
+            pImportAddressBlock->GetItemByIndex(nItemIndex, &pImportAddressItem);
+            if(NULL != pImportAddressItem) {
+                vSlotRVAs.push_back(pImportAddressItem->GetRVA());
+            }
+        }
+    }
+    vSlotRVAs.push_back(0);
+
+    std::vector<PEImportSlot> vSlots(vSlotRVAs.size());
+    UINT32 nResolvedCount = pImportTable->ResolveIATSlots(&vSlotRVAs[0], (UINT32)vSlotRVAs.size(), &vSlots[0]);
+
+    UINT32 nBadSlotCount = 0;
+    for(size_t nSlotIndex = 0; nSlotIndex + 1 < vSlotRVAs.size(); ++nSlotIndex) {
+        const PEImportSlot &oSlot = vSlots[nSlotIndex];
+        if(oSlot.nModuleIndex >= oMaterializedTable.nModuleCount
+            || oSlot.nFunctionIndex >= oMaterializedTable.pModules[oSlot.nModuleIndex].nFunctionCount) {
+            ++nBadSlotCount;
+            continue;
+        }
+
+        const PEImportFunctionEntry &oFunction = oMaterializedTable.pFunctions[oMaterializedTable.pModules[oSlot.nModuleIndex].nFirstFunctionIndex + oSlot.nFunctionIndex];
+        PEImportSlot oSingleSlot;
+        if(oFunction.nThunkRVA != vSlotRVAs[nSlotIndex] || FAILED(pImportTable->ResolveIATSlot(vSlotRVAs[nSlotIndex], &oSingleSlot))
+            || oSingleSlot.nModuleIndex != oSlot.nModuleIndex || oSingleSlot.nFunctionIndex != oSlot.nFunctionIndex) {
+            ++nBadSlotCount;
+        }
+    }
+
+    printf("ResolveIATSlots: Slots = %u, Resolved = %u, Bad slots = %u\n", (UINT32)vSlotRVAs.size() - 1, nResolvedCount, nBadSlotCount);
+    TestCheck(vSlotRVAs.size() > 1 && nResolvedCount == vSlotRVAs.size() - 1 && 0 == nBadSlotCount, "ResolveIATSlots resolves every IAT slot");
+    TestCheck(PE_IMPORT_NO_INDEX == vSlots.back().nModuleIndex && PE_IMPORT_NO_INDEX == vSlots.back().nFunctionIndex, "ResolveIATSlots leaves an RVA out of the IAT unresolved");
+
+    printf("\n");
+}
+
+std::vector<wchar_t> GetResourceKeyString(IPEResourceTable *pResourceTable, UINT32 nKey, BOOL bToLowerCase)
+{
+    // The names in the file are UTF-16 units, so they are widened one by one here, whatever the size of wchar_t is.
+    std::vector<wchar_t> vString;
+    UINT32 nLength = 0;
+    const UINT16 *pString = (const UINT16 *)pResourceTable->GetResourceRecordName(nKey, &nLength);
+    for(UINT32 nIndex = 0; NULL != pString && nIndex < nLength; ++nIndex) {
+        wchar_t nChar = (wchar_t)pString[nIndex];
+        if(bToLowerCase && nChar >= L'A' && nChar <= L'Z') {
+            nChar = (wchar_t)(nChar - L'A' + L'a');
+        }
+        vString.push_back(nChar);
+    }
+    vString.push_back(L'\0');
+    return vString;
+}
+
+void TestFindResourceRecord(IPEFile *pFile)
+{
+    LibPEPtr<IPEResourceTable> pResourceTable;
+    pFile->GetResourceTable(&pResourceTable);
+
+    const PEResourceRecord *pRecords = NULL;
+    UINT32 nRecordCount = 0;
+    if(NULL == pResourceTable || FAILED(pResourceTable->GetResourceRecords(&pRecords, &nRecordCount))) {
+        TestCheck(false, "FindResourceRecord finds every record by its keys");
+        return;
+    }
+
+    // Each record is looked up again by its own type, name and language. The string keys are passed as null-terminated
+    // strings, in their own case and in lower case, and the ids with MAKEINTRESOURCEW.
+    UINT32 nStringKeyCount = 0, nIdKeyCount = 0, nBadRecordCount = 0;
+    for(UINT32 nRecordIndex = 0; nRecordIndex < nRecordCount; ++nRecordIndex) {
+        const PEResourceRecord &oRecord = pRecords[nRecordIndex];
+        if(0 != nRecordIndex && oRecord.nDataEntryOffset == pRecords[nRecordIndex - 1].nDataEntryOffset) {
+            ++nBadRecordCount;
+        }
+
+        for(int nCase = 0; nCase < 2; ++nCase) {
+            std::vector<wchar_t> vType, vName;
+            const wchar_t *pType = MAKEINTRESOURCEW(oRecord.nType);
+            const wchar_t *pName = MAKEINTRESOURCEW(oRecord.nName);
+            if(0 != (oRecord.nType & PE_RESOURCE_NAME_IS_STRING)) {
+                vType = GetResourceKeyString(pResourceTable, oRecord.nType, 0 != nCase);
+                pType = &vType[0];
+                nStringKeyCount += (0 == nCase) ? 1 : 0;
+            } else {
+                nIdKeyCount += (0 == nCase) ? 1 : 0;
+            }
+            if(0 != (oRecord.nName & PE_RESOURCE_NAME_IS_STRING)) {
+                vName = GetResourceKeyString(pResourceTable, oRecord.nName, 0 != nCase);
+                pName = &vName[0];
+                nStringKeyCount += (0 == nCase) ? 1 : 0;
+            } else {
+                nIdKeyCount += (0 == nCase) ? 1 : 0;
+            }
+
+            const PEResourceRecord *pFoundRecord = NULL;
+            if(FAILED(pResourceTable->FindResourceRecord(pType, pName, oRecord.nLanguage, &pFoundRecord))
+                || NULL == pFoundRecord || pFoundRecord->nDataEntryOffset != oRecord.nDataEntryOffset) {
+                ++nBadRecordCount;
+            }
+        }
+    }
+
+    printf("FindResourceRecord: Records = %u, String keys = %u, Id keys = %u, Bad records = %u\n", nRecordCount, nStringKeyCount, nIdKeyCount, nBadRecordCount);
+    TestCheck(0 != nRecordCount && 0 == nBadRecordCount, "FindResourceRecord finds every record by its keys");
+
+    const PEResourceRecord *pMissingRecord = NULL;
+    TestCheck(FAILED(pResourceTable->FindResourceRecord(L"NO_SUCH_TYPE", MAKEINTRESOURCEW(1), PE_RESOURCE_ANY_LANGUAGE, &pMissingRecord))
+        && FAILED(pResourceTable->FindResourceRecord(MAKEINTRESOURCEW(0xFFFF), MAKEINTRESOURCEW(1), PE_RESOURCE_ANY_LANGUAGE, &pMissingRecord)),
+        "FindResourceRecord fails for missing string and id keys");
+
+    printf("\n");
+}
+
+UINT32 CheckCachedResourceDirectory(IPEResourceDirectory *pDirectory, UINT32 nLevel, UINT32 &nBadEntryCount)
+{
+    // Every child is asked for twice and must be the same object. Only the data entries on the language level are
+    // counted, the same as the records, and the tree is not walked below it.
+    UINT32 nDataEntryCount = 0;
+    UINT32 nEntryCount = pDirectory->GetEntryCount();
+    for(UINT32 nEntryIndex = 0; nEntryIndex < nEntryCount; ++nEntryIndex) {
+        LibPEPtr<IPEResourceDirectoryEntry> pEntry, pEntryAgain;
+        pDirectory->GetEntryByIndex(nEntryIndex, &pEntry);
+        pDirectory->GetEntryByIndex(nEntryIndex, &pEntryAgain);
+        if(NULL == pEntry || pEntry != pEntryAgain) {
+            ++nBadEntryCount;
+            continue;
+        }
+
+        if(pEntry->IsNameString() && (NULL == pEntry->GetName() || pEntry->GetName() != pEntry->GetName())) {
+            ++nBadEntryCount;
+        }
+
+        LibPEPtr<IPEResourceDirectory> pChildDirectory, pChildDirectoryAgain;
+        LibPEPtr<IPEResourceDataEntry> pDataEntry, pDataEntryAgain;
+        if(pEntry->IsEntryDirectory()) {
+            pEntry->GetDirectory(&pChildDirectory);
+            pEntry->GetDirectory(&pChildDirectoryAgain);
+            if(NULL == pChildDirectory || pChildDirectory != pChildDirectoryAgain || SUCCEEDED(pEntry->GetDataEntry(&pDataEntry))) {
+                ++nBadEntryCount;
+            } else if(nLevel < 2) {
+                nDataEntryCount += CheckCachedResourceDirectory(pChildDirectory, nLevel + 1, nBadEntryCount);
+            }
+        } else {
+            pEntry->GetDataEntry(&pDataEntry);
+            pEntry->GetDataEntry(&pDataEntryAgain);
+            if(NULL == pDataEntry || pDataEntry != pDataEntryAgain || SUCCEEDED(pEntry->GetDirectory(&pChildDirectory))) {
+                ++nBadEntryCount;
+            } else if(2 == nLevel) {
+                ++nDataEntryCount;
+            }
+        }
+    }
+
+    return nDataEntryCount;
+}
+
+void TestCachedResourceEntries(IPEFile *pFile)
+{
+    LibPEPtr<IPEResourceTable> pResourceTable;
+    pFile->GetResourceTable(&pResourceTable);
+
+    LibPEPtr<IPEResourceDirectory> pRootDirectory, pRootDirectoryAgain;
+    const PEResourceRecord *pRecords = NULL;
+    UINT32 nRecordCount = 0;
+    if(NULL == pResourceTable || FAILED(pResourceTable->GetRootDirectory(&pRootDirectory)) || FAILED(pResourceTable->GetRootDirectory(&pRootDirectoryAgain))
+        || FAILED(pResourceTable->GetResourceRecords(&pRecords, &nRecordCount))) {
+        TestCheck(false, "Resource directory entries keep their children");
+        return;
+    }
+
+    UINT32 nBadEntryCount = (pRootDirectory != pRootDirectoryAgain) ? 1 : 0;
+    UINT32 nDataEntryCount = CheckCachedResourceDirectory(pRootDirectory, 0, nBadEntryCount);
+
+    printf("Cached Resource Entries: Data entries = %u, Records = %u, Bad entries = %u\n", nDataEntryCount, nRecordCount, nBadEntryCount);
+    TestCheck(0 != nDataEntryCount && nDataEntryCount == nRecordCount && 0 == nBadEntryCount, "Resource directory entries keep their children");
+
+    printf("\n");
+}
+
+std::string ConvertVersionString(IPEVersionInfo *pVersionInfo, const PEStringView &oString)
+{
+    UINT32 nSize = 0;
+    pVersionInfo->ConvertToUTF8(&oString, NULL, 0, &nSize);
+
+    std::vector<char> vBuffer(nSize + 1, 0);
+    if(FAILED(pVersionInfo->ConvertToUTF8(&oString, &vBuffer[0], nSize, &nSize))) {
+        return std::string();
+    }
+    return std::string(&vBuffer[0]);
+}
+
+void TestVersionInfo(IPEFile *pFile)
+{
+    LibPEPtr<IPEResourceTable> pResourceTable;
+    pFile->GetResourceTable(&pResourceTable);
+
+    const PEResourceRecord *pRecord = NULL;
+    LibPEPtr<IPEResource> pResource;
+    LibPEPtr<IPEVersionInfo> pVersionInfo;
+    if(NULL == pResourceTable || FAILED(pResourceTable->FindResourceRecord(MAKEINTRESOURCEW(16), MAKEINTRESOURCEW(1), PE_RESOURCE_ANY_LANGUAGE, &pRecord))
+        || FAILED(pResourceTable->GetResourceByRecord(pRecord, &pResource)) || FAILED(pResource->GetVersionInfo(&pVersionInfo))) {
+        TestCheck(false, "Version info strings are decoded in UTF-16 units");
+        return;
+    }
+
+    PERawFixedFileInfo *pFixedFileInfo = pVersionInfo->GetFixedFileInfo();
+    TestCheck(NULL != pFixedFileInfo && 0xFEEF04BD == pFixedFileInfo->dwSignature, "Version info has its VS_FIXEDFILEINFO");
+
+    // Every key and value must be a view into the resource. The keys are found again through GetString in lower case,
+    // and the first table which has a key must give the same value.
+    const UINT8 *pRawBegin = (const UINT8 *)pVersionInfo->GetRawMemory();
+    const UINT8 *pRawEnd = pRawBegin + pVersionInfo->GetRawSize();
+    std::map<std::string, const wchar_t *> mapFirstValues;
+    UINT32 nStringCount = 0, nBadStringCount = 0;
+    for(UINT32 nTableIndex = 0; nTableIndex < pVersionInfo->GetStringTableCount(); ++nTableIndex) {
+        for(UINT32 nStringIndex = 0; nStringIndex < pVersionInfo->GetStringCount(nTableIndex); ++nStringIndex) {
+            PEStringView oKey, oValue;
+            if(FAILED(pVersionInfo->GetStringByIndex(nTableIndex, nStringIndex, &oKey, &oValue))) {
+                ++nBadStringCount;
+                continue;
+            }
+
+            const UINT8 *pKey = (const UINT8 *)oKey.pString, *pValue = (const UINT8 *)oValue.pString;
+            if(0 == oKey.nLength || pKey < pRawBegin || pKey + oKey.nLength * sizeof(UINT16) > pRawEnd
+                || pValue < pRawBegin || pValue + oValue.nLength * sizeof(UINT16) > pRawEnd) {
+                ++nBadStringCount;
+                continue;
+            }
+
+            std::string strKey = ConvertVersionString(pVersionInfo, oKey);
+            if(mapFirstValues.find(strKey) == mapFirstValues.end()) {
+                mapFirstValues[strKey] = oValue.pString;
+            }
+
+            std::string strLowerCaseKey = ToLowerCase(strKey.c_str());
+            std::vector<wchar_t> vLowerCaseKey(strLowerCaseKey.begin(), strLowerCaseKey.end());
+            vLowerCaseKey.push_back(L'\0');
+
+            PEStringView oFoundValue;
+            if(strKey.size() != oKey.nLength || FAILED(pVersionInfo->GetString(&vLowerCaseKey[0], &oFoundValue)) || oFoundValue.pString != mapFirstValues[strKey]) {
+                ++nBadStringCount;
+            }
+            ++nStringCount;
+        }
+    }
+
+    PEStringView oMissingValue;
+    if(SUCCEEDED(pVersionInfo->GetString(L"NoSuchVersionString", &oMissingValue))) {
+        ++nBadStringCount;
+    }
+
+    printf("Version Info: String tables = %u, Strings = %u, Translations = %u, Bad strings = %u\n", pVersionInfo->GetStringTableCount(), nStringCount, pVersionInfo->GetTranslationCount(), nBadStringCount);
+    TestCheck(0 != nStringCount && 0 == nBadStringCount, "Version info strings are decoded in UTF-16 units");
+
+    // The key of a string table is the language and the code page of the translation, such as "040904b0".
+    UINT16 nLanguage = 0, nCodePage = 0;
+    char pTranslationKey[16] = {0};
+    PEStringView oTableKey;
+    if(0 != pVersionInfo->GetTranslationCount() && SUCCEEDED(pVersionInfo->GetTranslation(0, &nLanguage, &nCodePage))) {
+        sprintf(pTranslationKey, "%04x%04x", nLanguage, nCodePage);
+    }
+    TestCheck(0 != pVersionInfo->GetStringTableCount() && SUCCEEDED(pVersionInfo->GetStringTableKey(0, &oTableKey))
+        && ToLowerCase(ConvertVersionString(pVersionInfo, oTableKey).c_str()) == pTranslationKey,
+        "Version info translation matches the string table key");
+
+    // A buffer too small for the string gets an empty string and the size it needs.
+    char pShortBuffer[2] = {'x', 'x'};
+    UINT32 nSize = 0;
+    TestCheck(E_INVALIDARG == pVersionInfo->ConvertToUTF8(&oTableKey, pShortBuffer, sizeof(pShortBuffer), &nSize)
+        && 0 == pShortBuffer[0] && nSize == oTableKey.nLength + 1,
+        "ConvertToUTF8 reports the size a short buffer needs");
+
+    printf("\n");
+}
+
+class ResourceDataCollector :
+    public IPEResourceDataSink
+{
+public:
+    ResourceDataCollector() : m_bIsInOrder(true), m_nMaxChunkSize(0) {}
+
+    virtual HRESULT LIBPE_CALLTYPE OnData(UINT32 nOffset, const void *pChunk, UINT32 nChunkSize)
+    {
+        if(nOffset != m_vData.size()) {
+            m_bIsInOrder = false;
+        }
+
+        if(nChunkSize > m_nMaxChunkSize) {
+            m_nMaxChunkSize = nChunkSize;
+        }
+
+        m_vData.insert(m_vData.end(), (const UINT8 *)pChunk, (const UINT8 *)pChunk + nChunkSize);
+
+        return S_OK;
+    }
+
+    std::vector<UINT8>  m_vData;
+    BOOL                m_bIsInOrder;
+    UINT32              m_nMaxChunkSize;
+};
+
+void TestResourceStreaming(const file_char_t *pFilePath, const std::vector<UINT8> &vFileData)
+{
+    // Tiny blocks and a tiny cache make the largest resource span many blocks, and keep it from being loaded at once.
+    SetPELoaderIOBlockSize(0x40, 0x40);
+    SetPELoaderCacheSize(0x200);
+
+    LibPEPtr<IPEFile> pFile;
+    ParsePEFromDiskFile(pFilePath, &pFile);
+
+    SetPELoaderIOBlockSize(0, 0);
+    SetPELoaderCacheSize(0);
+
+    LibPEPtr<IPEResourceTable> pResourceTable;
+    const PEResourceRecord *pRecords = NULL;
+    UINT32 nRecordCount = 0;
+    if(NULL != pFile) {
+        pFile->GetResourceTable(&pResourceTable);
+    }
+    if(NULL == pResourceTable || FAILED(pResourceTable->GetResourceRecords(&pRecords, &nRecordCount)) || 0 == nRecordCount) {
+        TestCheck(false, "Read returns the resource data");
+        return;
+    }
+
+    const PEResourceRecord *pLargestRecord = NULL;
+    for(UINT32 nRecordIndex = 0; nRecordIndex < nRecordCount; ++nRecordIndex) {
+        if(NULL == pLargestRecord || pRecords[nRecordIndex].nDataSize > pLargestRecord->nDataSize) {
+            pLargestRecord = &pRecords[nRecordIndex];
+        }
+    }
+
+    LibPEPtr<IPEResource> pResource;
+    pResourceTable->GetResourceByRecord(pLargestRecord, &pResource);
+    if(NULL == pResource) {
+        TestCheck(false, "Read returns the resource data");
+        return;
+    }
+
+    UINT32 nDataSize = pLargestRecord->nDataSize;
+    UINT64 nFOA = pResource->GetFOA();
+    BOOL bHasFileData = (0 != nFOA && nFOA + nDataSize <= vFileData.size());
+    printf("Resource Streaming: FOA = 0x%08x, Size = %u, Blocks = %u\n", (UINT32)nFOA, nDataSize, nDataSize / 0x40 + 1);
+    TestCheck(bHasFileData && nDataSize > 4 * 0x40, "Largest resource spans many blocks");
+
+    // Read in an odd piece size, so the reads don't line up with the blocks.
+    std::vector<UINT8> vReadData;
+    std::vector<UINT8> vPiece(93);
+    UINT32 nReadSize = 0;
+    while(vReadData.size() < nDataSize && SUCCEEDED(pResource->Read((UINT32)vReadData.size(), &vPiece[0], (UINT32)vPiece.size(), &nReadSize)) && 0 != nReadSize) {
+        vReadData.insert(vReadData.end(), vPiece.begin(), vPiece.begin() + nReadSize);
+    }
+
+    TestCheck(bHasFileData && vReadData.size() == nDataSize && 0 == memcmp(&vReadData[0], &vFileData[(size_t)nFOA], nDataSize), "Read returns the resource data");
+    TestCheck(SUCCEEDED(pResource->Read(nDataSize, &vPiece[0], (UINT32)vPiece.size(), &nReadSize)) && 0 == nReadSize, "Read stops at the end of the resource");
+
+    ResourceDataCollector oSmallWindowCollector, oDefaultWindowCollector;
+    TestCheck(SUCCEEDED(pResource->ReadInChunks(&oSmallWindowCollector, 13)) && oSmallWindowCollector.m_bIsInOrder
+        && oSmallWindowCollector.m_nMaxChunkSize <= 13 && oSmallWindowCollector.m_vData == vReadData, "ReadInChunks with a small window returns the resource data");
+    TestCheck(SUCCEEDED(pResource->ReadInChunks(&oDefaultWindowCollector, 0)) && oDefaultWindowCollector.m_bIsInOrder
+        && oDefaultWindowCollector.m_vData == vReadData, "ReadInChunks with the default window returns the resource data");
+
+    printf("\n");
+}
+
+HRESULT FindFirstResourceInTree(IPEResourceTable *pResourceTable, UINT16 nTypeId, IPEResource **ppResource)
+{
+    // Walk the tree the long way: the type entry with the id, then the first name and the first language under it.
+    LibPEPtr<IPEResourceDirectory> pDirectory;
+    pResourceTable->GetRootDirectory(&pDirectory);
+    if(NULL == pDirectory) {
+        return E_FAIL;
+    }
+
+    LibPEPtr<IPEResourceDirectoryEntry> pEntry;
+    for(UINT32 nEntryIndex = 0; nEntryIndex < pDirectory->GetEntryCount() && NULL == pEntry; ++nEntryIndex) {
+        LibPEPtr<IPEResourceDirectoryEntry> pTypeEntry;
+        pDirectory->GetEntryByIndex(nEntryIndex, &pTypeEntry);
+        if(NULL != pTypeEntry && pTypeEntry->IsNameId() && nTypeId == pTypeEntry->GetId()) {
+            pEntry = pTypeEntry;
+        }
+    }
+
+    for(UINT32 nLevel = 0; nLevel < 2; ++nLevel) {
+        LibPEPtr<IPEResourceDirectory> pChildDirectory;
+        if(NULL == pEntry || FAILED(pEntry->GetDirectory(&pChildDirectory)) || 0 == pChildDirectory->GetEntryCount()) {
+            return E_FAIL;
+        }
+
+        pEntry.Reset();
+        pChildDirectory->GetEntryByIndex(0, &pEntry);
+    }
+
+    LibPEPtr<IPEResourceDataEntry> pDataEntry;
+    if(NULL == pEntry || FAILED(pEntry->GetDataEntry(&pDataEntry))) {
+        return E_FAIL;
+    }
+
+    return pDataEntry->GetResource(ppResource);
+}
+
+void TestFirstResourceOfType(IPEFile *pFile, UINT16 nTypeId, const char *pTypeName)
+{
+    LibPEPtr<IPEResourceTable> pResourceTable;
+    pFile->GetResourceTable(&pResourceTable);
+    if(NULL == pResourceTable) {
+        TestCheck(false, "GetManifest and GetIconGroup find the first resource of their type");
+        return;
+    }
+
+    // The lookup is done first, on a table which has not been walked yet, and must find what the tree walk finds.
+    LibPEPtr<IPEResource> pResource, pExpectedResource;
+    HRESULT hr = (24 == nTypeId) ? pResourceTable->GetManifest(&pResource) : pResourceTable->GetIconGroup(&pResource);
+    HRESULT hrExpected = FindFirstResourceInTree(pResourceTable, nTypeId, &pExpectedResource);
+
+    BOOL bIsMatching = (SUCCEEDED(hr) == SUCCEEDED(hrExpected));
+    if(bIsMatching && SUCCEEDED(hr)) {
+        bIsMatching = (NULL != pResource && NULL != pExpectedResource && pResource->GetRVA() == pExpectedResource->GetRVA()
+            && pResource->GetSizeInMemory() == pExpectedResource->GetSizeInMemory());
+
+        // The resources are kept by their data entry, so the record of the same data gives back the same object.
+        const PEResourceRecord *pRecords = NULL;
+        UINT32 nRecordCount = 0;
+        pResourceTable->GetResourceRecords(&pRecords, &nRecordCount);
+        for(UINT32 nRecordIndex = 0; nRecordIndex < nRecordCount; ++nRecordIndex) {
+            if(nTypeId == pRecords[nRecordIndex].nType && pRecords[nRecordIndex].nDataRVA == pResource->GetRVA()) {
+                LibPEPtr<IPEResource> pRecordResource;
+                pResourceTable->GetResourceByRecord(&pRecords[nRecordIndex], &pRecordResource);
+                bIsMatching = bIsMatching && (pRecordResource == pResource);
+            }
+        }
+    }
+
+    printf("First %s: %s, RVA = 0x%08x, Size = %u\n", pTypeName, SUCCEEDED(hr) ? "found" : "none",
+        (NULL != pResource) ? (UINT32)pResource->GetRVA() : 0, (NULL != pResource) ? (UINT32)pResource->GetSizeInMemory() : 0);
+    TestCheck(bIsMatching, "GetManifest and GetIconGroup find the first resource of their type");
+}
+
+void TestManifestAndIconGroup(const file_char_t *pFilePath)
+{
+    // Each lookup gets a freshly parsed file, so it can't use anything the other tests have read.
+    LibPEPtr<IPEFile> pManifestFile, pIconGroupFile;
+    ParsePEFromDiskFile(pFilePath, &pManifestFile);
+    ParsePEFromDiskFile(pFilePath, &pIconGroupFile);
+    if(NULL == pManifestFile || NULL == pIconGroupFile) {
+        TestCheck(false, "GetManifest and GetIconGroup find the first resource of their type");
+        return;
+    }
+
+    TestFirstResourceOfType(pManifestFile, 24, "manifest");
+    TestFirstResourceOfType(pIconGroupFile, 14, "icon group");
+
+    printf("\n");
+}
+
+void TestDataLoader(const char *pLoaderName, IPEFile *pFile, IPEFile *pReferenceFile, const std::vector<UINT8> &vReferenceImage)
+{
+    printf("DataLoader %s: %s\n", pLoaderName, (NULL != pFile) ? "parsed" : "failed");
+    if(NULL == pFile) {
+        TestCheck(false, pLoaderName);
+        return;
+    }
+
+    LibPEPtr<IPEExportTable> pExportTable, pReferenceExportTable;
+    pFile->GetExportTable(&pExportTable);
+    pReferenceFile->GetExportTable(&pReferenceExportTable);
+
+    LibPEPtr<IPEImportTable> pImportTable, pReferenceImportTable;
+    pFile->GetImportTable(&pImportTable);
+    pReferenceFile->GetImportTable(&pReferenceImportTable);
+
+    UINT8 pImportHash[16] = {0}, pReferenceImportHash[16] = {1};
+    if(NULL != pImportTable && NULL != pReferenceImportTable) {
+        pImportTable->ComputeImportHash(PE_IMPORT_HASH_MD5, pImportHash, sizeof(pImportHash));
+        pReferenceImportTable->ComputeImportHash(PE_IMPORT_HASH_MD5, pReferenceImportHash, sizeof(pReferenceImportHash));
+    }
+
+    std::vector<UINT8> vImage(vReferenceImage.size());
+    BOOL bIsImageSame = !vImage.empty() && SUCCEEDED(pFile->Rebase(pReferenceFile->GetImageBase(), &vImage[0], vImage.size())) && vImage == vReferenceImage;
+
+    TestCheck(pFile->GetSectionCount() == pReferenceFile->GetSectionCount()
+        && NULL != pExportTable && NULL != pReferenceExportTable && pExportTable->GetFunctionCount() == pReferenceExportTable->GetFunctionCount()
+        && 0 == memcmp(pImportHash, pReferenceImportHash, sizeof(pImportHash))
+        && bIsImageSame, pLoaderName);
+}
+
+void TestDataLoaders(const file_char_t *pFilePath, IPEFile *pFile)
+{
+    // Each loader must give the same view of the file as the disk file loader, down to the image it lays out.
+    std::vector<UINT8> vImage(pFile->GetImageSize());
+    pFile->Rebase(pFile->GetImageBase(), &vImage[0], vImage.size());
+
+    LibPEPtr<IPEFile> pMappedDiskFile;
+    ParsePEFromMappedDiskFile(pFilePath, &pMappedDiskFile);
+    TestDataLoader("ParsePEFromMappedDiskFile", pMappedDiskFile, pFile, vImage);
+
+    std::vector<UINT8> vFileData;
+    LibPEPtr<IPEFile> pMappedFile;
+    if(ReadWholeFile(pFilePath, vFileData)) {
+        ParsePEFromMappedFile(&vFileData[0], vFileData.size(), &pMappedFile);
+    }
+    TestDataLoader("ParsePEFromMappedFile", pMappedFile, pFile, vImage);
+
+    std::vector<UINT8> vImageBuffer(vImage);
+    LibPEPtr<IPEFile> pImageBufferFile;
+    ParsePEFromImageBuffer(&vImageBuffer[0], vImageBuffer.size(), &pImageBufferFile);
+    TestDataLoader("ParsePEFromImageBuffer", pImageBufferFile, pFile, vImage);
+
+    // With read-ahead the blocks are read by the worker threads while the file is parsed. Small blocks make a lot of
+    // runs, and the file released right after parsing has to cancel the runs still queued for it.
+    SetPELoaderAsyncReadAhead(true);
+    SetPELoaderIOBlockSize(0x1000, 0x1000);
+
+    LibPEPtr<IPEFile> pReadAheadFile, pDroppedReadAheadFile;
+    ParsePEFromDiskFile(pFilePath, &pReadAheadFile);
+    ParsePEFromDiskFile(pFilePath, &pDroppedReadAheadFile);
+    pDroppedReadAheadFile.Reset();
+
+    SetPELoaderAsyncReadAhead(false);
+    SetPELoaderIOBlockSize(0, 0);
+
+    TestDataLoader("ParsePEFromDiskFile with async read-ahead", pReadAheadFile, pFile, vImage);
+
+    printf("\n");
+}
+
+int RunTests(const file_char_t *pFilePath)
+{
+    LibPEPtr<IPEFile> pFile;
+    ParsePEFromDiskFile(pFilePath, &pFile);
+    if(NULL == pFile) {
+        printf("Failed to parse the test file.\n");
+        return 1;
+    }
+
+    printf("AddRef: %d\n", pFile->AddRef());
+    printf("Release: %d\n", pFile->Release());
+
+    TestBasicInfo(pFile);
+    TestSection(pFile);
+    TestExportTable(pFile);
+    TestImportTable(pFile);
+    TestResourceTable(pFile);
+    TestRelocationTable(pFile);
+    TestImportAddressTable(pFile);
+
+    std::vector<UINT8> vFileData;
+    ReadWholeFile(pFilePath, vFileData);
+
+    TestAddressTranslation(pFile);
+    TestBlockCache(pFilePath);
+    TestStringTerminators(pFilePath);
+    TestArena(pFilePath, pFile);
+    TestRelocationDecoding(pFile, vFileData);
+    TestRelocationLookup(pFile, vFileData);
+    TestRebase(pFile);
+    TestExportLookup(pFilePath);
+    TestExportOrdinals(pFile, vFileData);
+    TestImportLookup(pFile);
+    TestImportThunks(pFile, vFileData);
+    TestImportHash(pFile);
+    TestMaterializedImports(pFile);
+    TestBoundAndDelayImports(pFile, vFileData);
+    TestResolveIATSlots(pFile);
+    TestFindResourceRecord(pFile);
+    TestCachedResourceEntries(pFile);
+    TestVersionInfo(pFile);
+    TestResourceStreaming(pFilePath, vFileData);
+    TestManifestAndIconGroup(pFilePath);
+    TestDataLoaders(pFilePath, pFile);
+
+    printf("Failed checks: %u\n", s_nFailedCheckCount);
+
+    return (0 == s_nFailedCheckCount) ? 0 : 1;
+}
+
+#ifdef LIBPE_WINOS
+
+int wmain(int argc, wchar_t* argv[])
+{
+    return RunTests(L"C:\\Windows\\system32\\kernel32.dll");
+}
+
+#else
+
+// There is no system32 to take the test files from, so they are passed on the command line.
+int main(int argc, char* argv[])
+{
+    if(argc < 2) {
+        printf("Usage: %s <PE file>\n", argv[0]);
+        return 2;
+    }
+
+    return RunTests(argv[1]);
+}
+
+#endif
@@ -28,8 +28,17 @@
 #include <vector>
 #include <list>
 
+#ifdef WIN32
 #include <windows.h>
 #include <WinNT.h>
+#include <wincrypt.h>
 
 #define LIBPE_DLL
-#include "LibPE.h"
\ No newline at end of file
+#endif
+
+#include "LibPE.h"
+
+// The resource ids are passed to the resource table the same way as to ::FindResourceEx.
+#ifndef MAKEINTRESOURCEW
+#define MAKEINTRESOURCEW(i) ((wchar_t *)((size_t)((UINT16)(i))))
+#endif
\ No newline at end of file